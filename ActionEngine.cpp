@@ -0,0 +1,248 @@
+#include "ActionEngine.h"
+#include "HashCache.h"
+#include "Stats.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <tuple>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+#endif
+
+namespace
+{
+#ifndef _WIN32
+	/**
+	 * @brief Функция для проверки, что файл не изменился после сканирования.
+	 * @param st Текущие метаданные файла.
+	 * @param file Файл, найденный при сканировании.
+	 * @param size Размер файла при сканировании.
+	 * @return true, если устройство, inode, размер и время изменения совпадают.
+	 */
+	bool sameFile(const struct stat& st, const ResultFile& file, uint64_t size)
+	{
+		// Файл, перезаписанный на месте без изменения длины, отличается только временем изменения
+		FileKey key = FileKey::fromStat(st);
+		return key.device == file.device && key.inode == file.inode && key.size == size && key.mtime == file.mtime;
+	}
+
+	/// Текст ошибки по errno
+	std::string errorText(int error)
+	{
+		return std::strerror(error);
+	}
+
+	/**
+	 * @brief Функция для создания reflink-копии файла под временным именем.
+	 * @param dirFd Дескриптор директории копии.
+	 * @param name Временное имя копии.
+	 * @param source Путь к исходному файлу.
+	 * @param attributes Метаданные заменяемого файла (права, владелец, время).
+	 * @return Текст ошибки (пусто - успешно).
+	 */
+	std::string createReflink(int dirFd, const std::string& name, const std::string& source, const struct stat& attributes)
+	{
+#if defined(__linux__) && defined(FICLONE)
+		int sourceFd = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+		if (sourceFd < 0)
+			return errorText(errno);
+		int targetFd = ::openat(dirFd, name.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, attributes.st_mode & 07777);
+		if (targetFd < 0) {
+			int error = errno;
+			::close(sourceFd);
+			return errorText(error);
+		}
+		// Владелец сохраняется, если хватает прав; права и время изменения копируются всегда
+		const struct timespec times[2] = { attributes.st_atim, attributes.st_mtim };
+		std::string result;
+		if (::ioctl(targetFd, FICLONE, sourceFd) != 0
+			|| (::fchown(targetFd, attributes.st_uid, attributes.st_gid) != 0 && errno != EPERM)
+			|| ::fchmod(targetFd, attributes.st_mode & 07777) != 0
+			|| ::futimens(targetFd, times) != 0)
+			result = errorText(errno);
+		::close(targetFd);
+		::close(sourceFd);
+		if (!result.empty())
+			::unlinkat(dirFd, name.c_str(), 0);
+		return result;
+#else
+		(void)dirFd; (void)name; (void)source; (void)attributes;
+		return "reflink is not supported on this platform";
+#endif
+	}
+#endif
+}
+
+DuplicateAction ActionEngine::parseAction(std::string_view name)
+{
+	if (name == "report")
+		return DuplicateAction::REPORT;
+	else if (name == "delete")
+		return DuplicateAction::DELETE;
+	else if (name == "hardlink")
+		return DuplicateAction::HARDLINK;
+	else if (name == "reflink")
+		return DuplicateAction::REFLINK;
+	throw std::invalid_argument("Invalid action");
+}
+
+void ActionEngine::submit(const ResultGroup& group)
+{
+	if (action_ == DuplicateAction::REPORT || group.files.size() < 2)
+		return;
+	std::vector<Task> tasks;
+	tasks.reserve(group.files.size() - 1);
+	for (size_t i = 1; i < group.files.size(); ++i) {
+		const auto& file = group.files[i];
+		auto slash = file.path.find_last_of(std::string{ '/', static_cast<char>(std::filesystem::path::preferred_separator) });
+		// Путь без директории относится к текущей, путь вида /name - к корню
+		std::string directory = slash == std::string::npos ? std::string(1, '.') : file.path.substr(0, std::max<size_t>(slash, 1));
+		std::string name = slash == std::string::npos ? file.path : file.path.substr(slash + 1);
+		tasks.push_back({ std::move(directory), std::move(name), file, group.files.front(), group.size });
+	}
+	std::scoped_lock<std::mutex> lock(mutex_);
+	std::move(tasks.begin(), tasks.end(), std::back_inserter(tasks_));
+}
+
+void ActionEngine::run()
+{
+	if (tasks_.empty())
+		return;
+	StatTimer timer(StatCounter::ACTION_NANOS);
+	// Дубликаты одной директории идут подряд и обрабатываются с одним дескриптором директории
+	std::sort(tasks_.begin(), tasks_.end(), [](const Task& a, const Task& b) {
+		return std::tie(a.directory, a.name) < std::tie(b.directory, b.name);
+		});
+	{
+		TaskGroup group(pool_);
+		for (size_t begin = 0; begin < tasks_.size();) {
+			size_t end = begin + 1;
+			while (end < tasks_.size() && end - begin < kBatchSize && tasks_[end].directory == tasks_[begin].directory)
+				++end;
+			group.run([this, begin, end]() { runBatch(tasks_, begin, end); });
+			begin = end;
+		}
+		group.wait();
+	}
+	tasks_.clear();
+}
+
+void ActionEngine::runBatch(const std::vector<Task>& tasks, size_t begin, size_t end)
+{
+	int dirFd = -1;
+	std::string openError;
+#ifndef _WIN32
+	dirFd = ::open(tasks[begin].directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirFd < 0)
+		openError = "failed to open directory " + tasks[begin].directory + ": " + errorText(errno);
+#endif
+	for (size_t i = begin; i < end; ++i) {
+		const auto& task = tasks[i];
+		ResultAction result{ action_, task.file.path, task.keep.path, dryRun_, openError.empty() ? apply(dirFd, task) : openError };
+		Stats::add(result.error.empty() ? StatCounter::ACTIONS_DONE : StatCounter::ACTIONS_FAILED);
+		writer_.push(std::move(result));
+	}
+#ifndef _WIN32
+	if (dirFd >= 0)
+		::close(dirFd);
+#endif
+}
+
+std::string ActionEngine::temporaryName()
+{
+	return ".bayan-" + std::to_string(temporaryCounter_.fetch_add(1, std::memory_order_relaxed))
+#ifndef _WIN32
+		+ "-" + std::to_string(::getpid())
+#endif
+		+ ".tmp";
+}
+
+#ifndef _WIN32
+std::string ActionEngine::apply(int dirFd, const Task& task)
+{
+	struct stat fileStat {};
+	if (::fstatat(dirFd, task.name.c_str(), &fileStat, 0) != 0)
+		return errorText(errno);
+	if (!sameFile(fileStat, task.file, task.size))
+		return "file changed since scan";
+	// Без сохраняемого файла действие уничтожило бы последнюю копию содержимого
+	struct stat keepStat {};
+	if (::stat(task.keep.path.c_str(), &keepStat) != 0)
+		return "kept file " + task.keep.path + " is unavailable: " + errorText(errno);
+	if (!sameFile(keepStat, task.keep, task.size))
+		return "kept file " + task.keep.path + " changed since scan";
+	if (dryRun_ || action_ == DuplicateAction::REPORT)
+		return {};
+
+	if (action_ == DuplicateAction::DELETE) {
+		if (::unlinkat(dirFd, task.name.c_str(), 0) != 0)
+			return errorText(errno);
+		return {};
+	}
+
+	std::string temporary = temporaryName();
+	if (action_ == DuplicateAction::HARDLINK) {
+		if (::linkat(AT_FDCWD, task.keep.path.c_str(), dirFd, temporary.c_str(), AT_SYMLINK_FOLLOW) != 0)
+			return errorText(errno);
+	}
+	else if (auto error = createReflink(dirFd, temporary, task.keep.path, fileStat); !error.empty()) {
+		return error;
+	}
+	// Атомарная замена: путь дубликата все время указывает на файл с тем же содержимым
+	if (::renameat(dirFd, temporary.c_str(), dirFd, task.name.c_str()) != 0) {
+		int error = errno;
+		::unlinkat(dirFd, temporary.c_str(), 0);
+		return errorText(error);
+	}
+	return {};
+}
+#else
+std::string ActionEngine::apply(int /*dirFd*/, const Task& task)
+{
+	std::error_code ec;
+	// Без inode изменение файла определяется по размеру и времени последней записи
+	auto fileKey = FileKey::fromPath(task.file.path);
+	if (!fileKey)
+		return "file is unavailable";
+	if (fileKey->size != task.size || fileKey->mtime != task.file.mtime)
+		return "file changed since scan";
+	auto keepKey = FileKey::fromPath(task.keep.path);
+	if (!keepKey)
+		return "kept file " + task.keep.path + " is unavailable";
+	if (keepKey->size != task.size || keepKey->mtime != task.keep.mtime)
+		return "kept file " + task.keep.path + " changed since scan";
+	if (dryRun_ || action_ == DuplicateAction::REPORT)
+		return {};
+
+	if (action_ == DuplicateAction::DELETE) {
+		std::filesystem::remove(task.file.path, ec);
+		return ec ? ec.message() : std::string{};
+	}
+	if (action_ == DuplicateAction::REFLINK)
+		return "reflink is not supported on this platform";
+
+	auto temporary = std::filesystem::path(task.directory) / temporaryName();
+	std::filesystem::create_hard_link(task.keep.path, temporary, ec);
+	if (ec)
+		return ec.message();
+	std::filesystem::rename(temporary, task.file.path, ec);
+	if (ec) {
+		std::error_code ignored;
+		std::filesystem::remove(temporary, ignored);
+		return ec.message();
+	}
+	return {};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+/**
+ * @file ActionEngine.h
+ * @brief Заголовочный файл для класса ActionEngine.
+ *
+ * Класс ActionEngine выполняет действия над найденными дубликатами: удаление,
+ * замену жесткой ссылкой или reflink-копией.
+ */
+#pragma once
+#include "ResultWriter.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class ActionEngine
+ * @brief Параллельное выполнение действий над дубликатами.
+ *
+ * Группы накапливаются во время сравнения, первый файл группы сохраняется. После
+ * сравнения дубликаты сортируются по директориям и обрабатываются пакетами в пуле
+ * потоков: пакет открывает директорию один раз и работает относительно ее дескриптора
+ * (unlinkat, linkat, openat). Жесткая ссылка или reflink-копия создается под временным
+ * именем и атомарно заменяет дубликат через renameat, поэтому путь не пропадает ни на
+ * мгновение. Перед действием устройство, inode и размер обоих файлов сверяются с
+ * найденными при сканировании: изменившиеся после сканирования файлы не трогаются.
+ */
+class ActionEngine : public IGroupSink
+{
+public:
+	/// Наибольшее количество дубликатов одной директории в пакете
+	static constexpr size_t kBatchSize = 256;
+
+	/**
+	 * @brief Конструктор класса ActionEngine.
+	 * @param action Действие над дубликатами.
+	 * @param dryRun Только показать действия, не изменяя файлы.
+	 * @param pool Пул потоков.
+	 * @param writer Поток вывода результатов действий.
+	 */
+	ActionEngine(DuplicateAction action, bool dryRun, ThreadPool& pool, ResultWriter& writer)
+		: action_(action), dryRun_(dryRun), pool_(pool), writer_(writer)
+	{
+	}
+
+	/**
+	 * @brief Метод для добавления группы дубликатов. Потокобезопасен.
+	 * @param group Группа дубликатов (первый файл сохраняется).
+	 */
+	void submit(const ResultGroup& group) override;
+
+	/**
+	 * @brief Метод для выполнения действий над всеми добавленными группами.
+	 */
+	void run();
+
+	/**
+	 * @brief Метод для получения действия по названию.
+	 * @param name Название действия (report, delete, hardlink, reflink).
+	 * @return Действие над дубликатами.
+	 * @throws std::invalid_argument Если действие неизвестно.
+	 */
+	static DuplicateAction parseAction(std::string_view name);
+
+private:
+	/// Дубликат, над которым выполняется действие
+	struct Task
+	{
+		std::string directory; ///< Директория дубликата.
+		std::string name; ///< Имя дубликата в директории.
+		ResultFile file; ///< Дубликат.
+		ResultFile keep; ///< Сохраняемый файл.
+		uint64_t size; ///< Размер файлов.
+	};
+
+	/**
+	 * @brief Метод для обработки пакета дубликатов одной директории.
+	 * @param tasks Все дубликаты.
+	 * @param begin Начало пакета.
+	 * @param end Конец пакета.
+	 */
+	void runBatch(const std::vector<Task>& tasks, size_t begin, size_t end);
+
+	/**
+	 * @brief Метод для выполнения действия над одним дубликатом.
+	 * @param dirFd Дескриптор директории дубликата.
+	 * @param task Дубликат.
+	 * @return Текст ошибки (пусто - успешно).
+	 */
+	std::string apply(int dirFd, const Task& task);
+
+	/**
+	 * @brief Метод для получения уникального временного имени в директории дубликата.
+	 * @return Временное имя.
+	 */
+	std::string temporaryName();
+
+	DuplicateAction action_; ///< Действие над дубликатами.
+	bool dryRun_; ///< Только показать действия.
+	ThreadPool& pool_; ///< Пул потоков.
+	ResultWriter& writer_; ///< Поток вывода результатов действий.
+	std::mutex mutex_; ///< Мьютекс для добавления групп.
+	std::vector<Task> tasks_; ///< Накопленные дубликаты.
+	std::atomic<uint64_t> temporaryCounter_{ 0 }; ///< Счетчик временных имен.
+};
\ No newline at end of file
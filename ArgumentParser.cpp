@@ -1,78 +1,266 @@
-#include "ArgumentParser.h"
-#include <boost/program_options.hpp>
-#include <iostream>
-
-ArgumentParser::PARSE_RES_CODE ArgumentParser::parse()
-{
-	namespace po = boost::program_options;
-
-	po::variables_map vm;
-
-	if (argc == 1) {
-		std::cerr << "Error: no arguments. Run with --help to get help" << std::endl;
-		return PARSE_RES_CODE::NO_ARGUMENTS;
-	}
-
-	po::options_description desc("Allowed options");
-	desc.add_options()
-		("help", "produce help message")
-		("directories", po::value<std::vector<std::string>>()->multitoken(), "directories to scan")
-		("exclude", po::value<std::vector<std::string>>()->multitoken()->default_value(std::vector<std::string>{}, ""), "directories to exclude")
-		("level", po::value<size_t>()->default_value(0), "scan level depth (0 [default]- only current directory)")
-		("masks", po::value<std::vector<std::string>>()->multitoken()->default_value(std::vector<std::string>{}, ""), "file name masks (case insensitive) - all [default]")
-		("min-size", po::value<size_t>()->default_value(1), "minimum file size, bytes - 1 [default]")
-		("block-size", po::value<size_t>()->default_value(1024), "block size, bytes - 1024 [default]")
-		("hash", po::value<std::string>()->default_value("crc32"), "hash algorithm (crc32 [default], md5)")
-		("delete", po::value<bool>()->default_value(false), "delete duplicates except of one from folder")
-		;
-
-	try {
-		po::store(po::parse_command_line(argc, argv, desc), vm);
-		po::notify(vm);
-	}
-	catch (const po::error& e) {
-		std::cerr << "Error: " << e.what() << std::endl;
-		return PARSE_RES_CODE::PARSE_ERROR;
-	}
-
-	if (vm.count("help")) {
-		std::cout << desc << std::endl;
-		return PARSE_RES_CODE::OK;
-	}
-
-	if (vm.count("directories")) {
-		data_.directories = vm["directories"].as<std::vector<std::string>>();
-	}
-	else {
-		std::cerr << "Error: no directories specified. Run with --help to get help" << std::endl;
-		return PARSE_RES_CODE::NO_DIRECTORIES;
-	}
-
-	if (vm.count("exclude"))
-		data_.excludeDirectories = vm["exclude"].as<std::vector<std::string>>();
-
-	if (vm.count("level"))
-		data_.level = vm["level"].as<size_t>();
-
-	if (vm.count("masks"))
-		data_.masks = vm["masks"].as<std::vector<std::string>>();
-
-	if (vm.count("min-size"))
-		data_.minFileSize = vm["min-size"].as<size_t>();
-
-	try {
-		data_.hashAlgorithm = HashAlgorithmFactory::create(vm["hash"].as<std::string>());
-	}
-	catch (const std::invalid_argument& e) {
-		std::cerr << "Error: " << e.what() << std::endl;
-		return PARSE_RES_CODE::INVALID_HASH_ALGORITHM;
-	}
-
-	if (vm.count("block-size"))
-		data_.blockSize = vm["block-size"].as<size_t>();
-
-	if (vm.count("delete"))
-		data_.deleteflag = vm["delete"].as<bool>();
-
-	return PARSE_RES_CODE::OK;
+#include "ArgumentParser.h"
+#include <boost/program_options.hpp>
+#include "ActionEngine.h"
+#include "UringReader.h"
+#include <algorithm>
+#include <iostream>
+#include <boost/lexical_cast.hpp>
+
+namespace
+{
+	/// Размер первого блока в режиме --block-size auto (одна страница)
+	constexpr size_t kAutoFirstBlockSize = 4096;
+}
+
+ArgumentParser::PARSE_RES_CODE ArgumentParser::parse()
+{
+	namespace po = boost::program_options;
+
+	po::variables_map vm;
+
+	if (argc == 1) {
+		std::cerr << "Error: no arguments. Run with --help to get help" << std::endl;
+		return PARSE_RES_CODE::NO_ARGUMENTS;
+	}
+
+	po::options_description desc("Allowed options");
+	desc.add_options()
+		("help", "produce help message")
+		("directories", po::value<std::vector<std::string>>()->multitoken(), "directories to scan")
+		("exclude", po::value<std::vector<std::string>>()->multitoken()->default_value(std::vector<std::string>{}, ""), "directories to exclude")
+		("level", po::value<size_t>()->default_value(0), "scan level depth (0 [default]- only current directory)")
+		("masks", po::value<std::vector<std::string>>()->multitoken()->default_value(std::vector<std::string>{}, ""), "file name masks, case insensitive: extensions (.txt), names or globs (IMG_*.jp?g) - all [default]")
+		("min-size", po::value<size_t>()->default_value(1), "minimum file size, bytes - 1 [default]")
+		("max-size", po::value<size_t>(), "maximum file size, bytes - unlimited [default]")
+		("block-size", po::value<std::string>()->default_value("1024"), "block size, bytes - 1024 [default], or auto - grow from 4096 up to --max-block-size")
+		("max-block-size", po::value<size_t>()->default_value(1 << 20), "largest block size for --block-size auto, bytes - 1048576 [default]")
+		("block-stats", "print bytes read and saved by early elimination")
+		("stats", "print per-stage counters, timings and histograms to stderr")
+		("stats-file", po::value<std::string>(), "write per-stage metrics in Prometheus text format to this file")
+		("export-index", po::value<std::string>(), "after the scan write a snapshot of the collected files and computed block hashes, sectioned by size range, for --merge")
+		("merge", po::value<std::vector<std::string>>()->multitoken(), "instead of scanning directories merge snapshots written by --export-index and compare only sizes found in several snapshots (--min-size and --max-size select the size range)")
+		("watch", po::value<std::string>(), "after the scan keep watching the directories with inotify, update duplicates incrementally and answer queries (groups, status) on this Unix socket")
+		("hash", po::value<std::string>()->default_value("crc32"), "hash algorithm (crc32 [default], md5, crc32c, xxh3, xxh128, blake3)")
+		("hash-benchmark", "measure throughput of every hash algorithm at --block-size and exit")
+		("delete", po::value<bool>()->default_value(false), "delete duplicates except of one from folder")
+		("action", po::value<std::string>()->default_value("report"), "action for duplicates except of one (report [default], delete, hardlink, reflink)")
+		("dry-run", "print actions for duplicates without changing files")
+		("samples", po::value<size_t>()->default_value(8), "number of 4 KiB sample blocks (first, last and evenly spaced, 2..64) hashed for files of 1 MiB and more before full comparison, 0 - disabled")
+		("verify", po::value<std::string>()->default_value("none"), "confirm hash-equal groups before output and --action (none [default], bytes)")
+		("jobs", po::value<size_t>()->default_value(0), "number of worker threads (0 [default] - hardware concurrency)")
+		("cache-file", po::value<std::string>(), "persistent block hash cache file for incremental rescans")
+		("io", po::value<std::string>()->default_value("stream"), "block reader backend (stream [default], mmap - files changed since the scan are skipped, a file truncated while it is read terminates the process with SIGBUS, uring)")
+		("cache-policy", po::value<std::string>()->default_value("normal"), "page cache use of block reads (normal [default], sequential - sequential read hint and eviction of every hashed block, direct - O_DIRECT reads bypassing the cache, block sizes rounded up to 4096)")
+		("queue-depth", po::value<unsigned>()->default_value(32), "io_uring queue depth - 32 [default]")
+		("device-jobs", po::value<std::vector<std::string>>()->multitoken(), "concurrent directory and group tasks per device: N for every device or DEVICE=N for one (sda, nvme0n1 or major:minor), 0 - unlimited (default: 1 for rotational disks from /sys/block, unlimited otherwise)")
+		("read-order", po::value<std::string>()->default_value("default"), "block read order (default, physical - one read per device at a time in ascending physical offset from FIEMAP, inode order without it; for rotational disks)")
+		("max-open-files", po::value<size_t>()->default_value(0), "files kept open at once by all groups (0 [default] - from RLIMIT_NOFILE)")
+		("format", po::value<std::string>()->default_value("text"), "output format (text [default], ndjson, json, csv)")
+		;
+
+	try {
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);
+	}
+	catch (const po::error& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return PARSE_RES_CODE::PARSE_ERROR;
+	}
+
+	if (vm.count("help")) {
+		std::cout << desc << std::endl;
+		data_.help = true;
+		return PARSE_RES_CODE::OK;
+	}
+
+	try {
+		const auto& blockSize = vm["block-size"].as<std::string>();
+		size_t maxBlockSize = vm["max-block-size"].as<size_t>();
+		if (blockSize == "auto")
+			data_.blockSchedule = BlockSchedule(std::min<size_t>(kAutoFirstBlockSize, maxBlockSize), maxBlockSize);
+		else
+			data_.blockSchedule = BlockSchedule(boost::lexical_cast<size_t>(blockSize));
+	}
+	catch (const boost::bad_lexical_cast&) {
+		std::cerr << "Error: Invalid block size" << std::endl;
+		return PARSE_RES_CODE::INVALID_BLOCK_SIZE;
+	}
+
+	if (vm.count("hash-benchmark")) {
+		data_.hashBenchmark = true;
+		return PARSE_RES_CODE::OK;
+	}
+
+	if (vm.count("merge")) {
+		// Снимки заменяют сканирование; действия и наблюдение требуют локальных файлов, снимок - сканирования
+		for (const char* option : { "directories", "export-index", "watch" }) {
+			if (vm.count(option)) {
+				std::cerr << "Error: --merge conflicts with --" << option << std::endl;
+				return PARSE_RES_CODE::INVALID_MERGE;
+			}
+		}
+		data_.mergeSnapshots = vm["merge"].as<std::vector<std::string>>();
+	}
+	else if (vm.count("directories")) {
+		data_.directories = vm["directories"].as<std::vector<std::string>>();
+	}
+	else {
+		std::cerr << "Error: no directories specified. Run with --help to get help" << std::endl;
+		return PARSE_RES_CODE::NO_DIRECTORIES;
+	}
+
+	if (vm.count("exclude"))
+		data_.excludeDirectories = vm["exclude"].as<std::vector<std::string>>();
+
+	if (vm.count("level"))
+		data_.level = vm["level"].as<size_t>();
+
+	if (vm.count("masks"))
+		data_.masks = vm["masks"].as<std::vector<std::string>>();
+	data_.maskMatcher = MaskMatcher(data_.masks);
+
+	if (vm.count("min-size"))
+		data_.minFileSize = vm["min-size"].as<size_t>();
+
+	if (vm.count("max-size"))
+		data_.maxFileSize = vm["max-size"].as<size_t>();
+
+	try {
+		data_.hashAlgorithm = HashAlgorithmFactory::create(vm["hash"].as<std::string>());
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return PARSE_RES_CODE::INVALID_HASH_ALGORITHM;
+	}
+
+	try {
+		data_.action = ActionEngine::parseAction(vm["action"].as<std::string>());
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return PARSE_RES_CODE::INVALID_ACTION;
+	}
+
+	// --delete true сохранен для совместимости и равносилен --action delete
+	if (vm["delete"].as<bool>()) {
+		if (!vm["action"].defaulted() && data_.action != DuplicateAction::DELETE) {
+			std::cerr << "Error: --delete conflicts with --action " << vm["action"].as<std::string>() << std::endl;
+			return PARSE_RES_CODE::INVALID_ACTION;
+		}
+		data_.action = DuplicateAction::DELETE;
+	}
+
+	data_.dryRun = vm.count("dry-run") > 0;
+
+	const auto& verify = vm["verify"].as<std::string>();
+	if (verify == "bytes") {
+		data_.verifyBytes = true;
+	}
+	else if (verify != "none") {
+		std::cerr << "Error: Invalid verify mode" << std::endl;
+		return PARSE_RES_CODE::INVALID_VERIFY_MODE;
+	}
+
+	data_.sampleCount = vm["samples"].as<size_t>();
+
+	if (vm.count("jobs"))
+		data_.jobs = vm["jobs"].as<size_t>();
+
+	if (vm.count("cache-file"))
+		data_.cacheFile = vm["cache-file"].as<std::string>();
+
+	try {
+		data_.ioMode = BlockReaderFactory::parseMode(vm["io"].as<std::string>());
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return PARSE_RES_CODE::INVALID_IO_MODE;
+	}
+
+	try {
+		data_.cachePolicy = BlockReaderFactory::parseCachePolicy(vm["cache-policy"].as<std::string>());
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return PARSE_RES_CODE::INVALID_CACHE_POLICY;
+	}
+
+	if (data_.cachePolicy == CachePolicy::DIRECT && data_.ioMode == IoMode::MMAP) {
+		std::cerr << "Warning: mmap reads cannot bypass the page cache, falling back to --cache-policy sequential" << std::endl;
+		data_.cachePolicy = CachePolicy::SEQUENTIAL;
+	}
+
+	if (data_.cachePolicy == CachePolicy::DIRECT) {
+		// Смещения и длины чтений O_DIRECT должны быть кратны размеру сектора
+		auto align = [](size_t size) {
+			return (size + FileBlockReader::kDirectAlignment - 1) / FileBlockReader::kDirectAlignment * FileBlockReader::kDirectAlignment;
+		};
+		const auto& schedule = data_.blockSchedule;
+		if (schedule.firstBlockSize() % FileBlockReader::kDirectAlignment != 0) {
+			std::cerr << "Warning: --cache-policy direct rounds block sizes up to a multiple of " << FileBlockReader::kDirectAlignment << " bytes" << std::endl;
+			data_.blockSchedule = BlockSchedule(align(schedule.firstBlockSize()), align(schedule.maxBlockSize()));
+		}
+	}
+
+	try {
+		if (vm.count("device-jobs"))
+			data_.deviceJobs = DeviceJobs::parse(vm["device-jobs"].as<std::vector<std::string>>());
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return PARSE_RES_CODE::INVALID_DEVICE_JOBS;
+	}
+
+	try {
+		data_.readOrder = ReadScheduler::parseOrder(vm["read-order"].as<std::string>());
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return PARSE_RES_CODE::INVALID_READ_ORDER;
+	}
+
+	try {
+		data_.outputFormat = ResultFormatterFactory::parseFormat(vm["format"].as<std::string>());
+	}
+	catch (const std::invalid_argument& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return PARSE_RES_CODE::INVALID_OUTPUT_FORMAT;
+	}
+
+	data_.blockStats = vm.count("block-stats") > 0;
+
+	data_.stats = vm.count("stats") > 0;
+
+	if (vm.count("stats-file"))
+		data_.statsFile = vm["stats-file"].as<std::string>();
+
+	if (vm.count("watch"))
+		data_.watchSocket = vm["watch"].as<std::string>();
+
+	if (vm.count("export-index"))
+		data_.exportIndex = vm["export-index"].as<std::string>();
+
+	if (!data_.mergeSnapshots.empty() && data_.action != DuplicateAction::REPORT) {
+		std::cerr << "Error: --merge only reports duplicates and conflicts with --action and --delete" << std::endl;
+		return PARSE_RES_CODE::INVALID_MERGE;
+	}
+
+	// Файлы других машин сравниваются только по хэшам снимков и побайтно сравнены быть не могут
+	if (!data_.mergeSnapshots.empty() && data_.verifyBytes) {
+		std::cerr << "Error: --merge compares files of other hosts by snapshot hashes and conflicts with --verify bytes" << std::endl;
+		return PARSE_RES_CODE::INVALID_MERGE;
+	}
+
+	if (vm.count("max-open-files"))
+		data_.maxOpenFiles = vm["max-open-files"].as<size_t>();
+
+	if (vm.count("queue-depth"))
+		data_.queueDepth = std::max(vm["queue-depth"].as<unsigned>(), 1u);
+
+	if (data_.ioMode == IoMode::URING && !UringReader::available()) {
+		std::cerr << "Warning: io_uring is not available, falling back to stream reads" << std::endl;
+		data_.ioMode = IoMode::STREAM;
+	}
+
+	return PARSE_RES_CODE::OK;
 }
\ No newline at end of file
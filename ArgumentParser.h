@@ -1,78 +1,116 @@
-/**
- * @file ArgumentParser.h
- * @brief Заголовочный файл для класса ArgumentParser.
- *
- * Класс ArgumentParser предназначен для обработки аргументов командной строки и их валидации.
- */
-#pragma once
-#include "HashCalculator.h"
-#include <memory>
-#include <string>
-#include <vector>
-
- /**
-  * @class ArgumentParser
-  * @brief Класс для парсинга аргументов командной строки.
-  */
-class ArgumentParser
-{
-public:
-	/**
-	 * @struct ParserData
-	 * @brief Структура для хранения данных, полученных из аргументов командной строки.
-	 */
-	struct ParserData
-	{
-		std::vector<std::string> directories; ///< Список директорий для сканирования.
-		std::vector<std::string> excludeDirectories; ///< Список директорий для исключения.
-		std::vector<std::string> masks; ///< Маски файлов для фильтрации.
-		size_t level; ///< Глубина сканирования.
-		size_t minFileSize; ///< Минимальный размер файла для обработки.
-		std::unique_ptr<IHashAlgorithm> hashAlgorithm; ///< Алгоритм хэширования.
-		size_t blockSize{ 1024 }; ///< Размер блока для чтения файлов.
-		bool deleteflag{ false };
-	};
-
-	/**
-	 * @enum PARSE_RES_CODE
-	 * @brief Коды результата парсинга аргументов.
-	 */
-	enum class PARSE_RES_CODE
-	{
-		OK = 0, ///< Успешный парсинг.
-		NO_ARGUMENTS, ///< Отсутствуют аргументы.
-		PARSE_ERROR, ///< Ошибка парсинга.
-		NO_DIRECTORIES, ///< Не указаны директории.
-		INVALID_HASH_ALGORITHM ///< Неверный алгоритм хэширования.
-	};
-
-	/**
-	 * @brief Конструктор класса ArgumentParser.
-	 * @param argc Количество аргументов командной строки.
-	 * @param argv Массив аргументов командной строки.
-	 */
-	ArgumentParser(int argc, char* argv[]) : argc(argc), argv(argv) {};
-
-	/**
-	 * @brief Деструктор класса ArgumentParser.
-	 */
-	~ArgumentParser() = default;
-
-	/**
-	 * @brief Метод для парсинга аргументов командной строки.
-	 * @return Код результата парсинга.
-	 */
-	PARSE_RES_CODE parse();
-
-	/**
-	 * @brief Метод для получения данных, полученных из аргументов.
-	 * @return Константная ссылка на структуру ParserData.
-	 */
-	const ParserData& data() const { return data_; }
-
-private:
-	int argc; ///< Количество аргументов командной строки.
-	char** argv; ///< Массив аргументов командной строки.
-
-	ParserData data_; ///< Данные, полученные из аргументов.
+/**
+ * @file ArgumentParser.h
+ * @brief Заголовочный файл для класса ArgumentParser.
+ *
+ * Класс ArgumentParser предназначен для обработки аргументов командной строки и их валидации.
+ */
+#pragma once
+#include "HashCalculator.h"
+#include "BlockReader.h"
+#include "BlockSchedule.h"
+#include "ReadScheduler.h"
+#include "DeviceQueues.h"
+#include "MaskMatcher.h"
+#include "ResultWriter.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+ /**
+  * @class ArgumentParser
+  * @brief Класс для парсинга аргументов командной строки.
+  */
+class ArgumentParser
+{
+public:
+	/**
+	 * @struct ParserData
+	 * @brief Структура для хранения данных, полученных из аргументов командной строки.
+	 */
+	struct ParserData
+	{
+		std::vector<std::string> directories; ///< Список директорий для сканирования.
+		std::vector<std::string> excludeDirectories; ///< Список директорий для исключения.
+		std::vector<std::string> masks; ///< Маски файлов для фильтрации.
+		MaskMatcher maskMatcher; ///< Скомпилированные маски файлов.
+		size_t level; ///< Глубина сканирования.
+		size_t minFileSize; ///< Минимальный размер файла для обработки.
+		size_t maxFileSize{ SIZE_MAX }; ///< Максимальный размер файла для обработки.
+		std::unique_ptr<IHashAlgorithm> hashAlgorithm; ///< Алгоритм хэширования.
+		BlockSchedule blockSchedule{ 1024 }; ///< Разбиение файлов на блоки для чтения.
+		DuplicateAction action{ DuplicateAction::REPORT }; ///< Действие над дубликатами.
+		bool dryRun{ false }; ///< Только показать действия над дубликатами, не изменяя файлы.
+		size_t sampleCount{ 8 }; ///< Количество выборочных блоков предварительной проверки больших файлов (0 - без нее).
+		bool verifyBytes{ false }; ///< Подтверждать группы, найденные по хэшам, побайтным сравнением.
+		size_t jobs{ 0 }; ///< Количество рабочих потоков (0 - по числу аппаратных потоков).
+		std::string cacheFile; ///< Путь к файлу кэша хэшей (пусто - без кэша).
+		IoMode ioMode{ IoMode::STREAM }; ///< Способ чтения блоков файлов.
+		CachePolicy cachePolicy{ CachePolicy::NORMAL }; ///< Использование страничного кэша при чтении блоков.
+		unsigned queueDepth{ 32 }; ///< Глубина очереди io_uring.
+		ReadOrder readOrder{ ReadOrder::DEFAULT }; ///< Порядок чтения блоков.
+		DeviceJobs deviceJobs; ///< Ограничения одновременных задач устройств.
+		bool help{ false }; ///< Выведена справка, сканирование не выполняется.
+		bool hashBenchmark{ false }; ///< Измерить пропускную способность алгоритмов хэширования и завершиться.
+		bool blockStats{ false }; ///< Вывести статистику прочитанных байт.
+		size_t maxOpenFiles{ 0 }; ///< Бюджет одновременно открытых файлов (0 - по системному ограничению).
+		OutputFormat outputFormat{ OutputFormat::TEXT }; ///< Формат вывода результатов.
+		bool stats{ false }; ///< Вывести сводку счетчиков и таймеров этапов.
+		std::string statsFile; ///< Путь к файлу метрик в формате Prometheus (пусто - без файла).
+		std::string watchSocket; ///< Путь к Unix-сокету режима наблюдения (пусто - без наблюдения).
+		std::string exportIndex; ///< Путь к файлу снимка индекса для слияния (пусто - без снимка).
+		std::vector<std::string> mergeSnapshots; ///< Снимки индексов для слияния вместо сканирования директорий.
+	};
+
+	/**
+	 * @enum PARSE_RES_CODE
+	 * @brief Коды результата парсинга аргументов.
+	 */
+	enum class PARSE_RES_CODE
+	{
+		OK = 0, ///< Успешный парсинг.
+		NO_ARGUMENTS, ///< Отсутствуют аргументы.
+		PARSE_ERROR, ///< Ошибка парсинга.
+		NO_DIRECTORIES, ///< Не указаны директории.
+		INVALID_HASH_ALGORITHM, ///< Неверный алгоритм хэширования.
+		INVALID_IO_MODE, ///< Неверный способ чтения файлов.
+		INVALID_BLOCK_SIZE, ///< Неверный размер блока.
+		INVALID_OUTPUT_FORMAT, ///< Неверный формат вывода.
+		INVALID_VERIFY_MODE, ///< Неверный способ проверки дубликатов.
+		INVALID_ACTION, ///< Неверное действие над дубликатами.
+		INVALID_READ_ORDER, ///< Неверный порядок чтения блоков.
+		INVALID_DEVICE_JOBS, ///< Неверное ограничение задач устройства.
+		INVALID_MERGE, ///< Режим слияния снимков несовместим с другими параметрами.
+		INVALID_CACHE_POLICY ///< Неверное использование страничного кэша.
+	};
+
+	/**
+	 * @brief Конструктор класса ArgumentParser.
+	 * @param argc Количество аргументов командной строки.
+	 * @param argv Массив аргументов командной строки.
+	 */
+	ArgumentParser(int argc, char* argv[]) : argc(argc), argv(argv) {};
+
+	/**
+	 * @brief Деструктор класса ArgumentParser.
+	 */
+	~ArgumentParser() = default;
+
+	/**
+	 * @brief Метод для парсинга аргументов командной строки.
+	 * @return Код результата парсинга.
+	 */
+	PARSE_RES_CODE parse();
+
+	/**
+	 * @brief Метод для получения данных, полученных из аргументов.
+	 * @return Константная ссылка на структуру ParserData.
+	 */
+	const ParserData& data() const { return data_; }
+
+private:
+	int argc; ///< Количество аргументов командной строки.
+	char** argv; ///< Массив аргументов командной строки.
+
+	ParserData data_; ///< Данные, полученные из аргументов.
 };
\ No newline at end of file
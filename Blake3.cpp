@@ -0,0 +1,255 @@
+#include "HashCalculator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BAYAN_BLAKE3_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	constexpr size_t kBlockLen = 64;
+	constexpr size_t kChunkLen = 1024;
+	constexpr size_t kOutLen = 32;
+
+	constexpr uint32_t kChunkStart = 1u << 0;
+	constexpr uint32_t kChunkEnd = 1u << 1;
+	constexpr uint32_t kParent = 1u << 2;
+	constexpr uint32_t kRoot = 1u << 3;
+
+	constexpr std::array<uint32_t, 8> kIv = {
+		0x6A09E667u, 0xBB67AE85u, 0x3C6EF372u, 0xA54FF53Au, 0x510E527Fu, 0x9B05688Cu, 0x1F83D9ABu, 0x5BE0CD19u,
+	};
+
+	/// Перестановки слов сообщения для каждого из 7 раундов
+	constexpr uint8_t kSchedule[7][16] = {
+		{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+		{ 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+		{ 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+		{ 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+		{ 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+		{ 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+		{ 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 },
+	};
+
+	/// Минимальный размер входа (в блоках по 1 КиБ) для распараллеливания по пулу
+	constexpr size_t kParallelChunks = 64;
+
+	using ChainingValue = std::array<uint32_t, 8>;
+
+	inline uint32_t load32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+	inline void g(uint32_t* v, size_t a, size_t b, size_t c, size_t d, uint32_t mx, uint32_t my)
+	{
+		v[a] = v[a] + v[b] + mx;
+		v[d] = std::rotr(v[d] ^ v[a], 16);
+		v[c] = v[c] + v[d];
+		v[b] = std::rotr(v[b] ^ v[c], 12);
+		v[a] = v[a] + v[b] + my;
+		v[d] = std::rotr(v[d] ^ v[a], 8);
+		v[c] = v[c] + v[d];
+		v[b] = std::rotr(v[b] ^ v[c], 7);
+	}
+
+	/// Функция сжатия BLAKE3; возвращает первые 8 слов выходного состояния
+	ChainingValue compress(const ChainingValue& cv, const uint8_t* block, uint64_t counter, uint32_t blockLen, uint32_t flags)
+	{
+		uint32_t m[16];
+		for (size_t i = 0; i < 16; ++i)
+			m[i] = load32(block + 4 * i);
+		uint32_t v[16] = {
+			cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+			kIv[0], kIv[1], kIv[2], kIv[3],
+			static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), blockLen, flags,
+		};
+		for (const auto& s : kSchedule) {
+			g(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+			g(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+			g(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+			g(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+			g(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+			g(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+			g(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+			g(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+		}
+		ChainingValue out;
+		for (size_t i = 0; i < 8; ++i)
+			out[i] = v[i] ^ v[i + 8];
+		return out;
+	}
+
+	/// Цепочечное значение (или корневой выход) одного блока данных до 1 КиБ
+	ChainingValue hashChunk(const uint8_t* input, size_t len, uint64_t counter, uint32_t rootFlag)
+	{
+		ChainingValue cv = kIv;
+		uint32_t flags = kChunkStart;
+		while (len > kBlockLen) {
+			cv = compress(cv, input, counter, kBlockLen, flags);
+			input += kBlockLen;
+			len -= kBlockLen;
+			flags = 0;
+		}
+		uint8_t last[kBlockLen] = {};
+		if (len > 0)
+			std::memcpy(last, input, len);
+		return compress(cv, last, counter, static_cast<uint32_t>(len), flags | kChunkEnd | rootFlag);
+	}
+
+	ChainingValue parentCv(const ChainingValue& left, const ChainingValue& right, uint32_t rootFlag)
+	{
+		uint8_t block[kBlockLen];
+		std::memcpy(block, left.data(), 32);
+		std::memcpy(block + 32, right.data(), 32);
+		return compress(kIv, block, 0, kBlockLen, kParent | rootFlag);
+	}
+
+#if BAYAN_BLAKE3_AVX2
+	__attribute__((target("avx2"))) inline __m256i rotr16(__m256i x)
+	{
+		return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+			13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+	}
+
+	__attribute__((target("avx2"))) inline __m256i rotr8(__m256i x)
+	{
+		return _mm256_shuffle_epi8(x, _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1,
+			12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1));
+	}
+
+	__attribute__((target("avx2"))) inline __m256i rotr12(__m256i x)
+	{
+		return _mm256_or_si256(_mm256_srli_epi32(x, 12), _mm256_slli_epi32(x, 20));
+	}
+
+	__attribute__((target("avx2"))) inline __m256i rotr7(__m256i x)
+	{
+		return _mm256_or_si256(_mm256_srli_epi32(x, 7), _mm256_slli_epi32(x, 25));
+	}
+
+	__attribute__((target("avx2"))) inline void g8(__m256i* v, size_t a, size_t b, size_t c, size_t d, __m256i mx, __m256i my)
+	{
+		v[a] = _mm256_add_epi32(_mm256_add_epi32(v[a], v[b]), mx);
+		v[d] = rotr16(_mm256_xor_si256(v[d], v[a]));
+		v[c] = _mm256_add_epi32(v[c], v[d]);
+		v[b] = rotr12(_mm256_xor_si256(v[b], v[c]));
+		v[a] = _mm256_add_epi32(_mm256_add_epi32(v[a], v[b]), my);
+		v[d] = rotr8(_mm256_xor_si256(v[d], v[a]));
+		v[c] = _mm256_add_epi32(v[c], v[d]);
+		v[b] = rotr7(_mm256_xor_si256(v[b], v[c]));
+	}
+
+	/// Восемь полных некорневых блоков по 1 КиБ параллельно: каждая полоса AVX2 обрабатывает свой блок
+	__attribute__((target("avx2")))
+	void hashChunks8Avx2(const uint8_t* input, uint64_t counter, ChainingValue* out)
+	{
+		__m256i h[8];
+		for (size_t i = 0; i < 8; ++i)
+			h[i] = _mm256_set1_epi32(static_cast<int>(kIv[i]));
+		const __m256i offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i counterLo = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter)), offsets);
+		// Перенос в старшее слово счётчика для полос, где младшее слово переполнилось
+		const __m256i carry = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(counter)), _mm256_set1_epi32(INT32_MIN)),
+			_mm256_xor_si256(counterLo, _mm256_set1_epi32(INT32_MIN)));
+		const __m256i counterHi = _mm256_sub_epi32(_mm256_set1_epi32(static_cast<int>(counter >> 32)), carry);
+		const __m256i gatherIndex = _mm256_mullo_epi32(offsets, _mm256_set1_epi32(static_cast<int>(kChunkLen / 4)));
+
+		for (size_t blockIndex = 0; blockIndex < kChunkLen / kBlockLen; ++blockIndex) {
+			uint32_t flags = (blockIndex == 0 ? kChunkStart : 0) | (blockIndex == kChunkLen / kBlockLen - 1 ? kChunkEnd : 0);
+			__m256i m[16];
+			const auto* base = reinterpret_cast<const int*>(input + blockIndex * kBlockLen);
+			for (size_t w = 0; w < 16; ++w)
+				m[w] = _mm256_i32gather_epi32(base + w, gatherIndex, 4);
+			__m256i v[16] = {
+				h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+				_mm256_set1_epi32(static_cast<int>(kIv[0])), _mm256_set1_epi32(static_cast<int>(kIv[1])),
+				_mm256_set1_epi32(static_cast<int>(kIv[2])), _mm256_set1_epi32(static_cast<int>(kIv[3])),
+				counterLo, counterHi, _mm256_set1_epi32(static_cast<int>(kBlockLen)), _mm256_set1_epi32(static_cast<int>(flags)),
+			};
+			for (const auto& s : kSchedule) {
+				g8(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+				g8(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+				g8(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+				g8(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+				g8(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+				g8(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+				g8(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+				g8(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+			}
+			for (size_t i = 0; i < 8; ++i)
+				h[i] = _mm256_xor_si256(v[i], v[i + 8]);
+		}
+
+		alignas(32) uint32_t lanes[8][8];
+		for (size_t i = 0; i < 8; ++i)
+			_mm256_store_si256(reinterpret_cast<__m256i*>(lanes[i]), h[i]);
+		for (size_t lane = 0; lane < 8; ++lane)
+			for (size_t i = 0; i < 8; ++i)
+				out[lane][i] = lanes[i][lane];
+	}
+#endif
+
+	/// Цепочечные значения полных блоков по 1 КиБ в диапазоне [first, last)
+	void hashFullChunks(const uint8_t* input, size_t first, size_t last, ChainingValue* out)
+	{
+#if BAYAN_BLAKE3_AVX2
+		static const bool avx2 = __builtin_cpu_supports("avx2");
+		if (avx2) {
+			for (; first + 8 <= last; first += 8)
+				hashChunks8Avx2(input + first * kChunkLen, first, out + first);
+		}
+#endif
+		for (; first < last; ++first)
+			out[first] = hashChunk(input + first * kChunkLen, kChunkLen, first, 0);
+	}
+
+	/// Свёртка цепочечных значений поддерева [first, last) по правилам дерева BLAKE3
+	ChainingValue reduce(const std::vector<ChainingValue>& leaves, size_t first, size_t last, uint32_t rootFlag)
+	{
+		size_t count = last - first;
+		// Левое поддерево - наибольшая степень двойки, строго меньшая числа блоков
+		size_t left = std::bit_floor(count - 1);
+		ChainingValue leftCv = left == 1 ? leaves[first] : reduce(leaves, first, first + left, 0);
+		ChainingValue rightCv = count - left == 1 ? leaves[first + left] : reduce(leaves, first + left, last, 0);
+		return parentCv(leftCv, rightCv, rootFlag);
+	}
+}
+
+Digest Blake3Hash::calculateHash(std::span<const char> block) const
+{
+	const auto* input = reinterpret_cast<const uint8_t*>(block.data());
+	const size_t len = block.size();
+	ChainingValue root;
+	if (len <= kChunkLen) {
+		root = hashChunk(input, len, 0, kRoot);
+	}
+	else {
+		const size_t chunks = (len + kChunkLen - 1) / kChunkLen;
+		const size_t fullChunks = len / kChunkLen;
+		std::vector<ChainingValue> leaves(chunks);
+		if (pool_ && fullChunks >= kParallelChunks) {
+			// Блоки делятся на части, кратные 8, и хэшируются текущим и свободными рабочими потоками.
+			// Вызов приходит и из задачи сравнения, удерживающей дескрипторы: ожидание частей не берет чужие задачи
+			size_t parts = pool_->size() * 2;
+			size_t step = ((fullChunks + parts - 1) / parts + 7) / 8 * 8;
+			pool_->parallelFor((fullChunks + step - 1) / step, [input, step, fullChunks, &leaves](size_t part) {
+				size_t first = part * step;
+				hashFullChunks(input, first, std::min(first + step, fullChunks), leaves.data());
+				});
+		}
+		else {
+			hashFullChunks(input, 0, fullChunks, leaves.data());
+		}
+		for (size_t i = fullChunks; i < chunks; ++i)
+			leaves[i] = hashChunk(input + i * kChunkLen, std::min(kChunkLen, len - i * kChunkLen), i, 0);
+		root = reduce(leaves, 0, chunks, kRoot);
+	}
+	uint8_t out[kOutLen];
+	std::memcpy(out, root.data(), kOutLen);
+	return Digest(out, kOutLen);
+}
\ No newline at end of file
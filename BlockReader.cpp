@@ -0,0 +1,206 @@
+#include "BlockReader.h"
+#include "ReadScheduler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool StreamBlockReader::open(const std::string& path, uint64_t)
+{
+	stream_.open(path, std::ios::binary);
+	position_ = 0;
+	return static_cast<bool>(stream_);
+}
+
+std::span<const char> StreamBlockReader::read(uint64_t offset, size_t length)
+{
+	if (buffer_.size() < length)
+		buffer_.resize(length);
+	if (offset != position_) {
+		stream_.clear();
+		stream_.seekg(static_cast<std::streamoff>(offset));
+	}
+	stream_.read(buffer_.data(), static_cast<std::streamsize>(length));
+	auto bytesRead = static_cast<size_t>(std::max<std::streamsize>(stream_.gcount(), 0));
+	position_ = offset + bytesRead;
+	return { buffer_.data(), bytesRead };
+}
+
+void FileBlockReader::FreeBuffer::operator()(char* buffer) const
+{
+	std::free(buffer);
+}
+
+#ifdef _WIN32
+
+bool FileBlockReader::open(const std::string&, uint64_t)
+{
+	return false;
+}
+
+std::span<const char> FileBlockReader::read(uint64_t, size_t)
+{
+	return {};
+}
+
+void FileBlockReader::close()
+{
+}
+
+void FileBlockReader::dropCached(uint64_t, size_t) const
+{
+}
+
+#else
+
+bool FileBlockReader::open(const std::string& path, uint64_t)
+{
+	close();
+#ifdef O_DIRECT
+	if (policy_ == CachePolicy::DIRECT) {
+		fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+		direct_ = fd_ >= 0;
+	}
+#endif
+	// Без поддержки O_DIRECT (tmpfs, часть сетевых ФС) прочитанные блоки вытесняются из кэша
+	if (fd_ < 0)
+		fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#ifdef POSIX_FADV_SEQUENTIAL
+	if (fd_ >= 0)
+		::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	return fd_ >= 0;
+}
+
+std::span<const char> FileBlockReader::read(uint64_t offset, size_t length)
+{
+	// Чтение O_DIRECT начинается и заканчивается на границах выравнивания
+	uint64_t start = direct_ ? offset / kDirectAlignment * kDirectAlignment : offset;
+	auto skip = static_cast<size_t>(offset - start);
+	size_t size = direct_ ? (skip + length + kDirectAlignment - 1) / kDirectAlignment * kDirectAlignment : length;
+	if (capacity_ < size) {
+		size_t capacity = (size + kDirectAlignment - 1) / kDirectAlignment * kDirectAlignment;
+		buffer_.reset(static_cast<char*>(std::aligned_alloc(kDirectAlignment, capacity)));
+		capacity_ = buffer_ ? capacity : 0;
+		if (!buffer_)
+			throw std::bad_alloc();
+	}
+	size_t bytesRead = 0;
+	while (bytesRead < size) {
+		ssize_t res = ::pread(fd_, buffer_.get() + bytesRead, size - bytesRead, static_cast<off_t>(start + bytesRead));
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res <= 0)
+			break;
+		bytesRead += static_cast<size_t>(res);
+	}
+	dropCached(start, bytesRead);
+	if (bytesRead <= skip)
+		return {};
+	return { buffer_.get() + skip, std::min(length, bytesRead - skip) };
+}
+
+void FileBlockReader::close()
+{
+#ifdef POSIX_FADV_DONTNEED
+	// Вытеснение страниц, дочитанных ядром вперед или занятых вводом-выводом при вытеснении блоков
+	if (fd_ >= 0 && policy_ != CachePolicy::NORMAL && !direct_)
+		::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+	if (fd_ >= 0)
+		::close(fd_);
+	fd_ = -1;
+	direct_ = false;
+}
+
+void FileBlockReader::dropCached(uint64_t offset, size_t length) const
+{
+#ifdef POSIX_FADV_DONTNEED
+	if (policy_ != CachePolicy::NORMAL && !direct_ && length > 0)
+		::posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_DONTNEED);
+#endif
+}
+
+#endif
+
+bool MmapBlockReader::open(const std::string& path, uint64_t size)
+{
+	if (!file_.open(path))
+		return false;
+	// Обращение к отображению за концом усеченного файла вызывает SIGBUS, поэтому меняющийся файл не читается
+	if (file_.size() != size) {
+		file_.close();
+		return false;
+	}
+	file_.adviseSequential();
+	lastLength_ = 0;
+	return true;
+}
+
+std::span<const char> MmapBlockReader::read(uint64_t offset, size_t length)
+{
+	dropLastBlock();
+	if (offset >= file_.size())
+		return {};
+	length = std::min<size_t>(length, file_.size() - offset);
+	lastOffset_ = offset;
+	lastLength_ = length;
+	return { file_.data() + offset, length };
+}
+
+void MmapBlockReader::close()
+{
+	dropLastBlock();
+	file_.close();
+}
+
+void MmapBlockReader::dropLastBlock()
+{
+	if (policy_ != CachePolicy::NORMAL && lastLength_ > 0)
+		file_.adviseDone(static_cast<size_t>(lastOffset_), lastLength_);
+	lastLength_ = 0;
+}
+
+IoMode BlockReaderFactory::parseMode(std::string_view mode)
+{
+	if (mode == "stream")
+		return IoMode::STREAM;
+	else if (mode == "mmap")
+		return IoMode::MMAP;
+	else if (mode == "uring")
+		return IoMode::URING;
+	throw std::invalid_argument("Invalid io mode");
+}
+
+CachePolicy BlockReaderFactory::parseCachePolicy(std::string_view policy)
+{
+	if (policy == "normal")
+		return CachePolicy::NORMAL;
+	else if (policy == "sequential")
+		return CachePolicy::SEQUENTIAL;
+	else if (policy == "direct")
+		return CachePolicy::DIRECT;
+	throw std::invalid_argument("Invalid cache policy");
+}
+
+std::unique_ptr<BlockReader> BlockReaderFactory::create(IoMode mode, CachePolicy policy, ReadScheduler* scheduler)
+{
+	std::unique_ptr<BlockReader> reader;
+	if (mode == IoMode::MMAP)
+		reader = std::make_unique<MmapBlockReader>(policy);
+#ifndef _WIN32
+	else if (mode == IoMode::URING || policy != CachePolicy::NORMAL || scheduler)
+		reader = std::make_unique<FileBlockReader>(policy);
+#endif
+	else
+		reader = std::make_unique<StreamBlockReader>();
+	if (scheduler)
+		return std::make_unique<ScheduledBlockReader>(std::move(reader), *scheduler, mode == IoMode::MMAP);
+	return reader;
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+/**
+ * @file BlockReader.h
+ * @brief Заголовочный файл для классов чтения блоков файлов.
+ *
+ * Класс BlockReader определяет интерфейс чтения блоков файла по смещению,
+ * реализации которого различаются способом ввода-вывода.
+ */
+#pragma once
+#include "MappedFile.h"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ReadScheduler;
+
+/**
+ * @enum IoMode
+ * @brief Способ чтения блоков файлов.
+ */
+enum class IoMode
+{
+	STREAM = 0, ///< Буферизованное чтение через std::ifstream.
+	MMAP, ///< Отображение файла в память.
+	URING ///< Пакетное асинхронное чтение через io_uring.
+};
+
+/**
+ * @enum CachePolicy
+ * @brief Использование страничного кэша при чтении блоков файлов.
+ */
+enum class CachePolicy
+{
+	NORMAL = 0, ///< Обычное чтение через страничный кэш.
+	SEQUENTIAL, ///< Подсказка последовательного чтения; страницы прочитанных блоков вытесняются из кэша.
+	DIRECT ///< Чтение в обход кэша (O_DIRECT) блоками, выровненными по сектору.
+};
+
+/**
+ * @class BlockReader
+ * @brief Интерфейс для чтения блоков файла.
+ */
+class BlockReader
+{
+public:
+	/**
+	 * @brief Деструктор класса BlockReader.
+	 */
+	virtual ~BlockReader() = default;
+
+	/**
+	 * @brief Метод для открытия файла.
+	 * @param path Путь к файлу.
+	 * @param size Размер файла при сканировании.
+	 * @return true, если файл открыт.
+	 */
+	virtual bool open(const std::string& path, uint64_t size) = 0;
+
+	/**
+	 * @brief Метод для чтения блока файла.
+	 * @param offset Смещение блока.
+	 * @param length Размер блока.
+	 * @return Прочитанные данные (короче length в конце файла). Действительны до следующего вызова.
+	 */
+	virtual std::span<const char> read(uint64_t offset, size_t length) = 0;
+
+	/**
+	 * @brief Метод для закрытия файла.
+	 */
+	virtual void close() = 0;
+
+	/**
+	 * @brief Метод для проверки, открыт ли файл.
+	 * @return true, если файл открыт.
+	 */
+	virtual bool isOpen() const = 0;
+
+	/**
+	 * @brief Метод для получения дескриптора открытого файла.
+	 * @return Дескриптор (-1, если файл не открыт или читается не через дескриптор).
+	 */
+	virtual int fd() const { return -1; }
+};
+
+/**
+ * @class StreamBlockReader
+ * @brief Чтение блоков через std::ifstream в переиспользуемый буфер.
+ */
+class StreamBlockReader : public BlockReader
+{
+public:
+	bool open(const std::string& path, uint64_t size) override;
+	std::span<const char> read(uint64_t offset, size_t length) override;
+	void close() override { stream_.close(); }
+	bool isOpen() const override { return stream_.is_open(); }
+
+private:
+	std::ifstream stream_; ///< Поток файла.
+	std::vector<char> buffer_; ///< Буфер блока.
+	uint64_t position_{ 0 }; ///< Текущая позиция в файле.
+};
+
+/**
+ * @class FileBlockReader
+ * @brief Чтение блоков по дескриптору файла (pread) с заданным использованием страничного кэша.
+ *
+ * Файл открывается с подсказкой последовательного чтения. С CachePolicy::SEQUENTIAL страницы
+ * блока вытесняются сразу после чтения: данные уже скопированы в буфер. С CachePolicy::DIRECT
+ * файл открывается с O_DIRECT, а чтение расширяется до границ kDirectAlignment в выровненный
+ * буфер, который переиспользуется между чтениями. Если файловая система не поддерживает
+ * O_DIRECT, файл читается как с CachePolicy::SEQUENTIAL. Дескриптор используется и для
+ * пакетных чтений io_uring.
+ */
+class FileBlockReader : public BlockReader
+{
+public:
+	/// Выравнивание смещения, длины и буфера чтения O_DIRECT (не меньше логического сектора)
+	static constexpr size_t kDirectAlignment = 4096;
+
+	/**
+	 * @brief Конструктор класса FileBlockReader.
+	 * @param policy Использование страничного кэша.
+	 */
+	explicit FileBlockReader(CachePolicy policy = CachePolicy::NORMAL) : policy_(policy) {}
+
+	/**
+	 * @brief Деструктор класса FileBlockReader.
+	 */
+	~FileBlockReader() override { close(); }
+
+	bool open(const std::string& path, uint64_t size) override;
+	std::span<const char> read(uint64_t offset, size_t length) override;
+	void close() override;
+	bool isOpen() const override { return fd_ >= 0; }
+
+	/**
+	 * @brief Метод для вытеснения из страничного кэша блока, прочитанного без read (пакетом io_uring).
+	 * @param offset Смещение блока.
+	 * @param length Размер блока.
+	 */
+	void dropCached(uint64_t offset, size_t length) const;
+
+	int fd() const override { return fd_; }
+
+	/// Признак чтения в обход кэша: смещение и длина чтения должны быть кратны kDirectAlignment
+	bool direct() const { return direct_; }
+
+private:
+	/// Освобождение буфера, выделенного std::aligned_alloc
+	struct FreeBuffer
+	{
+		void operator()(char* buffer) const;
+	};
+
+	CachePolicy policy_; ///< Использование страничного кэша.
+	int fd_{ -1 }; ///< Дескриптор файла.
+	bool direct_{ false }; ///< Файл открыт с O_DIRECT.
+	std::unique_ptr<char, FreeBuffer> buffer_; ///< Выровненный буфер чтения.
+	size_t capacity_{ 0 }; ///< Размер буфера.
+};
+
+/**
+ * @class MmapBlockReader
+ * @brief Чтение блоков напрямую из отображённого в память файла без копирования.
+ *
+ * С CachePolicy::SEQUENTIAL страницы предыдущего блока вытесняются при чтении следующего:
+ * данные блока действительны до следующего вызова.
+ *
+ * Файл, размер которого изменился после сканирования, не отображается. Усечение файла во время
+ * чтения не обнаруживается: обращение к отображению за новым концом файла завершает процесс
+ * сигналом SIGBUS, тогда как остальные способы чтения возвращают короткий блок.
+ */
+class MmapBlockReader : public BlockReader
+{
+public:
+	/**
+	 * @brief Конструктор класса MmapBlockReader.
+	 * @param policy Использование страничного кэша (CachePolicy::DIRECT недоступен для отображения).
+	 */
+	explicit MmapBlockReader(CachePolicy policy = CachePolicy::NORMAL) : policy_(policy) {}
+
+	/**
+	 * @brief Метод для отображения файла в память.
+	 * @param path Путь к файлу.
+	 * @param size Размер файла при сканировании.
+	 * @return false, если файл не отображён или его размер изменился после сканирования.
+	 */
+	bool open(const std::string& path, uint64_t size) override;
+	std::span<const char> read(uint64_t offset, size_t length) override;
+	void close() override;
+	bool isOpen() const override { return file_.isOpen(); }
+	int fd() const override { return file_.fd(); }
+
+private:
+	/**
+	 * @brief Метод для вытеснения страниц последнего прочитанного блока.
+	 */
+	void dropLastBlock();
+
+	CachePolicy policy_; ///< Использование страничного кэша.
+	MappedFile file_; ///< Отображение файла.
+	uint64_t lastOffset_{ 0 }; ///< Смещение последнего прочитанного блока.
+	size_t lastLength_{ 0 }; ///< Размер последнего прочитанного блока.
+};
+
+/**
+ * @class BlockReaderFactory
+ * @brief Класс для создания объектов чтения блоков.
+ */
+class BlockReaderFactory
+{
+public:
+	/**
+	 * @brief Метод для получения способа чтения по названию.
+	 * @param mode Название способа чтения.
+	 * @return Способ чтения.
+	 */
+	static IoMode parseMode(std::string_view mode);
+
+	/**
+	 * @brief Метод для получения использования страничного кэша по названию.
+	 * @param policy Название (normal, sequential, direct).
+	 * @return Использование страничного кэша.
+	 */
+	static CachePolicy parseCachePolicy(std::string_view policy);
+
+	/**
+	 * @brief Метод для создания объекта чтения блоков.
+	 * @param mode Способ чтения.
+	 * @param policy Использование страничного кэша (для stream, кроме NORMAL, чтение идет через FileBlockReader).
+	 * Для упорядоченного чтения stream также читает через FileBlockReader: расположение запрашивается по дескриптору.
+	 * @param scheduler Планировщик чтений в физическом порядке (nullptr - чтения не упорядочиваются).
+	 * @return Указатель на объект чтения блоков.
+	 */
+	static std::unique_ptr<BlockReader> create(IoMode mode, CachePolicy policy, ReadScheduler* scheduler = nullptr);
+};
\ No newline at end of file
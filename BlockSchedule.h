@@ -0,0 +1,96 @@
+/**
+ * @file BlockSchedule.h
+ * @brief Заголовочный файл для класса BlockSchedule.
+ *
+ * Класс BlockSchedule задаёт разбиение файла на блоки для поблочного сравнения.
+ */
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class BlockSchedule
+ * @brief Разбиение файла на блоки, растущие геометрически от первого блока до максимального.
+ *
+ * Первый блок мал, чтобы дешево отсеять большинство различающихся файлов; каждый следующий
+ * вдвое больше предыдущего, пока не достигнет максимального размера. Разбиение зависит
+ * только от размера файла, поэтому блоки с одинаковым номером у файлов группы совпадают
+ * по смещению и длине. При равных размерах первого и максимального блока разбиение фиксированное.
+ */
+class BlockSchedule
+{
+public:
+	/**
+	 * @brief Конструктор фиксированного разбиения.
+	 * @param blockSize Размер блока.
+	 */
+	explicit BlockSchedule(size_t blockSize = 1024) : BlockSchedule(blockSize, blockSize) {}
+
+	/**
+	 * @brief Конструктор растущего разбиения.
+	 * @param firstBlockSize Размер первого блока.
+	 * @param maxBlockSize Максимальный размер блока (округляется вниз до firstBlockSize * 2^k).
+	 */
+	BlockSchedule(size_t firstBlockSize, size_t maxBlockSize)
+		: firstBlockSize_(std::max<size_t>(firstBlockSize, 1))
+	{
+		while ((firstBlockSize_ << growthSteps_) <= maxBlockSize / 2)
+			++growthSteps_;
+	}
+
+	/// Размер первого блока
+	size_t firstBlockSize() const { return firstBlockSize_; }
+
+	/// Максимальный размер блока
+	size_t maxBlockSize() const { return firstBlockSize_ << growthSteps_; }
+
+	/// Признак растущего разбиения
+	bool isAdaptive() const { return growthSteps_ > 0; }
+
+	/**
+	 * @brief Метод для получения смещения блока.
+	 * @param index Номер блока.
+	 * @return Смещение начала блока в файле.
+	 */
+	uint64_t offset(size_t index) const {
+		size_t grown = std::min(index, growthSteps_);
+		uint64_t result = static_cast<uint64_t>(firstBlockSize_) * ((uint64_t{ 1 } << grown) - 1);
+		return result + static_cast<uint64_t>(index - grown) * maxBlockSize();
+	}
+
+	/**
+	 * @brief Метод для получения длины блока.
+	 * @param index Номер блока.
+	 * @param fileSize Размер файла.
+	 * @return Длина блока (последний блок может быть короче).
+	 */
+	size_t length(size_t index, uint64_t fileSize) const {
+		uint64_t start = offset(index);
+		if (start >= fileSize)
+			return 0;
+		size_t nominal = firstBlockSize_ << std::min(index, growthSteps_);
+		return static_cast<size_t>(std::min<uint64_t>(nominal, fileSize - start));
+	}
+
+	/**
+	 * @brief Метод для получения количества блоков файла.
+	 * @param fileSize Размер файла.
+	 * @return Количество блоков.
+	 */
+	size_t blockCount(uint64_t fileSize) const {
+		size_t count = 0;
+		while (count < growthSteps_ && offset(count) < fileSize)
+			++count;
+		uint64_t start = offset(count);
+		if (start < fileSize)
+			count += static_cast<size_t>((fileSize - start + maxBlockSize() - 1) / maxBlockSize());
+		return count;
+	}
+
+	bool operator==(const BlockSchedule&) const = default;
+
+private:
+	size_t firstBlockSize_; ///< Размер первого блока.
+	size_t growthSteps_{ 0 }; ///< Количество удвоений до максимального размера блока.
+};
\ No newline at end of file
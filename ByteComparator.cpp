@@ -0,0 +1,118 @@
+#include "ByteComparator.h"
+#include "Stats.h"
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+bool ByteComparator::openReader(const std::string& path, uint64_t fileSize, bool wait, std::unique_ptr<BlockReader>& reader)
+{
+	reader.reset();
+	if (wait)
+		budget_.acquire(descriptors_);
+	else if (!budget_.tryAcquire(descriptors_))
+		return false;
+	auto opened = BlockReaderFactory::create(ioMode_, cachePolicy_, scheduler_);
+	if (!opened->open(path, fileSize)) {
+		budget_.release(descriptors_);
+		Stats::add(StatCounter::FILES_FAILED);
+		std::cerr << "Failed to open file: " << path << ". File will be skipped." << std::endl;
+		return true;
+	}
+	reader = std::move(opened);
+	return true;
+}
+
+void ByteComparator::closeReader(BlockReader& reader)
+{
+	if (!reader.isOpen())
+		return;
+	reader.close();
+	budget_.release(descriptors_);
+}
+
+std::vector<std::vector<size_t>> ByteComparator::partition(const std::vector<std::string>& paths, uint64_t fileSize, const BlockSchedule& schedule)
+{
+	std::vector<std::vector<size_t>> groups;
+	std::vector<size_t> pending(paths.size());
+	std::iota(pending.begin(), pending.end(), size_t{ 0 });
+	digests_.clear();
+	while (pending.size() > 1) {
+		std::unique_ptr<BlockReader> reference;
+		openReader(paths[pending.front()], fileSize, true, reference);
+		if (!reference) {
+			pending.erase(pending.begin());
+			continue;
+		}
+		std::vector<size_t> same{ pending.front() };
+		std::vector<size_t> different;
+		// Эталон хэшируется в первом пакете, в котором он дочитан до конца
+		std::vector<Digest> blockHashes;
+		bool hashed = !hashCalculator_;
+		for (size_t next = 1; next < pending.size();) {
+			// Первый файл пакета ждет дескриптор, остальные берутся, пока бюджет позволяет
+			std::vector<Candidate> batch;
+			while (next < pending.size() && batch.size() < kMaxBatch) {
+				std::unique_ptr<BlockReader> reader;
+				if (!openReader(paths[pending[next]], fileSize, batch.empty(), reader))
+					break;
+				if (reader)
+					batch.push_back({ pending[next], std::move(reader) });
+				++next;
+			}
+			compareBatch(*reference, batch, fileSize, schedule, hashed ? nullptr : &blockHashes);
+			hashed = hashed || blockHashes.size() == hashSchedule_.blockCount(fileSize);
+			for (auto& candidate : batch) {
+				closeReader(*candidate.reader);
+				(candidate.equal ? same : different).push_back(candidate.index);
+			}
+		}
+		closeReader(*reference);
+		if (same.size() > 1) {
+			groups.push_back(std::move(same));
+			if (hashCalculator_)
+				digests_.push_back(blockHashes.empty() ? Digest{} : hashCalculator_->combineHashes(blockHashes));
+		}
+		pending = std::move(different);
+	}
+	return groups;
+}
+
+void ByteComparator::compareBatch(BlockReader& reference, std::vector<Candidate>& batch, uint64_t fileSize, const BlockSchedule& schedule,
+	std::vector<Digest>* blockHashes)
+{
+	if (blockHashes)
+		blockHashes->clear();
+	size_t remaining = batch.size();
+	for (size_t block = 0; remaining > 0 && schedule.offset(block) < fileSize; ++block) {
+		uint64_t offset = schedule.offset(block);
+		size_t length = schedule.length(block, fileSize);
+		auto expected = reference.read(offset, length);
+		bytesRead_ += expected.size();
+		Stats::add(StatCounter::BYTES_READ, expected.size());
+		Stats::add(StatCounter::BLOCKS_READ);
+		// Порция состоит из целых блоков разбиения хэширования
+		if (blockHashes && expected.size() == length) {
+			for (uint64_t hashOffset = hashSchedule_.offset(blockHashes->size()); hashOffset < offset + length;
+				hashOffset = hashSchedule_.offset(blockHashes->size())) {
+				auto part = expected.subspan(static_cast<size_t>(hashOffset - offset), hashSchedule_.length(blockHashes->size(), fileSize));
+				blockHashes->push_back(hashCalculator_->calculateHash(part));
+			}
+		}
+		for (auto& candidate : batch) {
+			if (!candidate.equal)
+				continue;
+			auto actual = candidate.reader->read(offset, length);
+			bytesRead_ += actual.size();
+			Stats::add(StatCounter::BYTES_READ, actual.size());
+			Stats::add(StatCounter::BLOCKS_READ);
+			// Короткое чтение (файл изменился во время сравнения) считается отличием
+			if (expected.size() != length || actual.size() != length || std::memcmp(expected.data(), actual.data(), length) != 0) {
+				candidate.equal = false;
+				closeReader(*candidate.reader);
+				--remaining;
+			}
+		}
+	}
+	if (blockHashes && blockHashes->size() != hashSchedule_.blockCount(fileSize))
+		blockHashes->clear();
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+/**
+ * @file ByteComparator.h
+ * @brief Заголовочный файл для класса ByteComparator.
+ *
+ * Класс ByteComparator сравнивает файлы одного размера побайтно, без хэширования.
+ */
+#pragma once
+#include "BlockReader.h"
+#include "BlockSchedule.h"
+#include "DescriptorBudget.h"
+#include "HashCalculator.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class ByteComparator
+ * @brief Побайтное сравнение файлов одного размера.
+ *
+ * Первый из оставшихся файлов служит эталоном: остальные читаются вместе с ним
+ * порциями и сравниваются memcmp, файл выбывает на первой отличающейся порции.
+ * Отличившиеся файлы сравниваются между собой следующим проходом. Так результат
+ * не зависит от коллизий хэша, а несовпадающие файлы дочитываются только до первого отличия.
+ */
+class ByteComparator
+{
+public:
+	/// Максимальное количество файлов, сравниваемых с эталоном одновременно
+	static constexpr size_t kMaxBatch = 32;
+
+	/**
+	 * @brief Конструктор класса ByteComparator.
+	 * @param ioMode Способ чтения файлов.
+	 * @param cachePolicy Использование страничного кэша.
+	 * @param budget Общий бюджет открытых файлов.
+	 * @param scheduler Планировщик чтений в физическом порядке (может отсутствовать).
+	 */
+	ByteComparator(IoMode ioMode, CachePolicy cachePolicy, DescriptorBudget& budget, ReadScheduler* scheduler = nullptr) : ioMode_(ioMode), cachePolicy_(cachePolicy), budget_(budget), scheduler_(scheduler) {}
+
+	/**
+	 * @brief Метод для разбиения файлов на группы с одинаковым содержимым.
+	 * @param paths Пути к файлам одного размера.
+	 * @param fileSize Размер файлов.
+	 * @param schedule Разбиение файлов на порции для сравнения.
+	 * @return Группы из двух и более одинаковых файлов (индексы в paths).
+	 */
+	std::vector<std::vector<size_t>> partition(const std::vector<std::string>& paths, uint64_t fileSize, const BlockSchedule& schedule);
+
+	/**
+	 * @brief Метод для включения расчета хэша содержимого групп.
+	 *
+	 * Блоки эталона хэшируются по разбиению hashSchedule во время сравнения, поэтому хэш
+	 * совпадает с хэшем такой же группы, найденной хэшированием. Порция сравнения должна
+	 * состоять из целых блоков hashSchedule: первый блок общий, наибольшая порция не меньше
+	 * наибольшего блока.
+	 * @param hashCalculator Калькулятор хэшей.
+	 * @param hashSchedule Разбиение файлов на блоки для хэширования.
+	 */
+	void hashContents(const HashCalculator& hashCalculator, const BlockSchedule& hashSchedule)
+	{
+		hashCalculator_ = &hashCalculator;
+		hashSchedule_ = hashSchedule;
+	}
+
+	/// Хэши содержимого групп последнего partition в том же порядке (пусто без hashContents)
+	const std::vector<Digest>& digests() const { return digests_; }
+
+	/// Байт прочитано этим объектом
+	uint64_t bytesRead() const { return bytesRead_; }
+
+private:
+	/// Файл, сравниваемый с эталоном
+	struct Candidate
+	{
+		size_t index; ///< Индекс файла.
+		std::unique_ptr<BlockReader> reader; ///< Объект чтения (закрыт после отличия).
+		bool equal{ true }; ///< Пока совпадает с эталоном.
+	};
+
+	/**
+	 * @brief Метод для открытия файла с получением дескриптора из бюджета.
+	 * @param path Путь к файлу.
+	 * @param fileSize Размер файла при сканировании.
+	 * @param wait Ждать дескриптор, если бюджет исчерпан.
+	 * @param reader Объект чтения (nullptr, если дескриптор не получен или файл не открыт).
+	 * @return false, если дескриптор не получен без ожидания.
+	 */
+	bool openReader(const std::string& path, uint64_t fileSize, bool wait, std::unique_ptr<BlockReader>& reader);
+
+	/**
+	 * @brief Метод для закрытия файла с возвратом дескриптора в бюджет.
+	 * @param reader Объект чтения.
+	 */
+	void closeReader(BlockReader& reader);
+
+	/**
+	 * @brief Метод для сравнения файлов пакета с эталоном порциями до первого отличия.
+	 * @param reference Объект чтения эталона.
+	 * @param batch Пакет файлов.
+	 * @param fileSize Размер файлов.
+	 * @param schedule Разбиение файлов на порции.
+	 * @param blockHashes Хэши блоков эталона (nullptr - не вычислять); пусто, если эталон не дочитан до конца.
+	 */
+	void compareBatch(BlockReader& reference, std::vector<Candidate>& batch, uint64_t fileSize, const BlockSchedule& schedule,
+		std::vector<Digest>* blockHashes);
+
+	IoMode ioMode_; ///< Способ чтения файлов.
+	CachePolicy cachePolicy_; ///< Использование страничного кэша.
+	DescriptorBudget& budget_; ///< Общий бюджет открытых файлов.
+	DescriptorBudget::Holder descriptors_; ///< Дескрипторы открытых файлов сравнения.
+	const HashCalculator* hashCalculator_{ nullptr }; ///< Калькулятор хэшей содержимого (nullptr - без хэшей).
+	BlockSchedule hashSchedule_; ///< Разбиение файлов на блоки для хэширования.
+	std::vector<Digest> digests_; ///< Хэши содержимого групп.
+	ReadScheduler* scheduler_; ///< Планировщик чтений.
+	uint64_t bytesRead_{ 0 }; ///< Байт прочитано.
+};
\ No newline at end of file
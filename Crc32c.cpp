@@ -0,0 +1,227 @@
+#include "HashCalculator.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BAYAN_CRC32C_X86 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define BAYAN_CRC32C_ARM 1
+#include <arm_acle.h>
+#ifdef __linux__
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+
+namespace
+{
+	/// Полином Кастаньоли в отражённой форме
+	constexpr uint32_t kPolynomial = 0x82F63B78u;
+
+	/// Таблицы для программного расчёта методом slicing-by-8
+	struct Crc32cTables
+	{
+		std::array<std::array<uint32_t, 256>, 8> table{};
+
+		constexpr Crc32cTables() {
+			for (uint32_t i = 0; i < 256; ++i) {
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; ++bit)
+					crc = (crc >> 1) ^ (kPolynomial & (0u - (crc & 1u)));
+				table[0][i] = crc;
+			}
+			for (uint32_t i = 0; i < 256; ++i)
+				for (size_t k = 1; k < 8; ++k)
+					table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+		}
+	};
+
+	constexpr Crc32cTables kTables;
+
+	uint32_t crc32cSoftware(uint32_t crc, const unsigned char* data, size_t size)
+	{
+		const auto& t = kTables.table;
+		while (size >= 8) {
+			uint64_t word;
+			std::memcpy(&word, data, sizeof(word));
+			word ^= crc;
+			crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff] ^
+				t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^ t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+			data += 8;
+			size -= 8;
+		}
+		while (size--)
+			crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xff];
+		return crc;
+	}
+
+#if BAYAN_CRC32C_X86
+#if defined(__GNUC__) || defined(__clang__)
+	__attribute__((target("sse4.2")))
+#endif
+	uint32_t crc32cHardware(uint32_t crc, const unsigned char* data, size_t size)
+	{
+#if defined(__x86_64__) || defined(_M_X64)
+		uint64_t crc64 = crc;
+		while (size >= 8) {
+			uint64_t word;
+			std::memcpy(&word, data, sizeof(word));
+			crc64 = _mm_crc32_u64(crc64, word);
+			data += 8;
+			size -= 8;
+		}
+		crc = static_cast<uint32_t>(crc64);
+#endif
+		while (size--)
+			crc = _mm_crc32_u8(crc, *data++);
+		return crc;
+	}
+
+	/// Три блока одинаковой длины: независимые цепочки занимают конвейер при задержке инструкции в 3 такта
+#if defined(__GNUC__) || defined(__clang__)
+	__attribute__((target("sse4.2")))
+#endif
+	void crc32cHardware3(const unsigned char* const data[3], size_t size, uint32_t crcs[3])
+	{
+		size_t offset = 0;
+#if defined(__x86_64__) || defined(_M_X64)
+		uint64_t crc0 = crcs[0], crc1 = crcs[1], crc2 = crcs[2];
+		for (; offset + 8 <= size; offset += 8) {
+			uint64_t word0, word1, word2;
+			std::memcpy(&word0, data[0] + offset, sizeof(word0));
+			std::memcpy(&word1, data[1] + offset, sizeof(word1));
+			std::memcpy(&word2, data[2] + offset, sizeof(word2));
+			crc0 = _mm_crc32_u64(crc0, word0);
+			crc1 = _mm_crc32_u64(crc1, word1);
+			crc2 = _mm_crc32_u64(crc2, word2);
+		}
+		crcs[0] = static_cast<uint32_t>(crc0);
+		crcs[1] = static_cast<uint32_t>(crc1);
+		crcs[2] = static_cast<uint32_t>(crc2);
+#endif
+		for (size_t lane = 0; lane < 3; ++lane)
+			crcs[lane] = crc32cHardware(crcs[lane], data[lane] + offset, size - offset);
+	}
+
+	bool hardwareSupported()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 20)) != 0;
+#else
+		return __builtin_cpu_supports("sse4.2");
+#endif
+	}
+#elif BAYAN_CRC32C_ARM
+	__attribute__((target("+crc")))
+	uint32_t crc32cHardware(uint32_t crc, const unsigned char* data, size_t size)
+	{
+		while (size >= 8) {
+			uint64_t word;
+			std::memcpy(&word, data, sizeof(word));
+			crc = __crc32cd(crc, word);
+			data += 8;
+			size -= 8;
+		}
+		while (size--)
+			crc = __crc32cb(crc, *data++);
+		return crc;
+	}
+
+	/// Три блока одинаковой длины: независимые цепочки скрывают задержку инструкции
+	__attribute__((target("+crc")))
+	void crc32cHardware3(const unsigned char* const data[3], size_t size, uint32_t crcs[3])
+	{
+		size_t offset = 0;
+		uint32_t crc0 = crcs[0], crc1 = crcs[1], crc2 = crcs[2];
+		for (; offset + 8 <= size; offset += 8) {
+			uint64_t word0, word1, word2;
+			std::memcpy(&word0, data[0] + offset, sizeof(word0));
+			std::memcpy(&word1, data[1] + offset, sizeof(word1));
+			std::memcpy(&word2, data[2] + offset, sizeof(word2));
+			crc0 = __crc32cd(crc0, word0);
+			crc1 = __crc32cd(crc1, word1);
+			crc2 = __crc32cd(crc2, word2);
+		}
+		crcs[0] = crc32cHardware(crc0, data[0] + offset, size - offset);
+		crcs[1] = crc32cHardware(crc1, data[1] + offset, size - offset);
+		crcs[2] = crc32cHardware(crc2, data[2] + offset, size - offset);
+	}
+
+	bool hardwareSupported()
+	{
+#ifdef __linux__
+		return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+		return true;
+#endif
+	}
+#endif
+
+	void crc32cSoftware3(const unsigned char* const data[3], size_t size, uint32_t crcs[3])
+	{
+		for (size_t lane = 0; lane < 3; ++lane)
+			crcs[lane] = crc32cSoftware(crcs[lane], data[lane], size);
+	}
+
+	using Crc32cFunction = uint32_t(*)(uint32_t, const unsigned char*, size_t);
+	using Crc32c3Function = void(*)(const unsigned char* const[3], size_t, uint32_t[3]);
+
+	/// Выбор реализации при первом вызове по возможностям процессора
+	Crc32cFunction selectImplementation()
+	{
+#if BAYAN_CRC32C_X86 || BAYAN_CRC32C_ARM
+		if (hardwareSupported())
+			return crc32cHardware;
+#endif
+		return crc32cSoftware;
+	}
+
+	Crc32c3Function selectImplementation3()
+	{
+#if BAYAN_CRC32C_X86 || BAYAN_CRC32C_ARM
+		if (hardwareSupported())
+			return crc32cHardware3;
+#endif
+		return crc32cSoftware3;
+	}
+}
+
+Digest CRC32CHash::calculateHash(std::span<const char> block) const
+{
+	static const Crc32cFunction crc32c = selectImplementation();
+	uint32_t checksum = ~crc32c(~0u, reinterpret_cast<const unsigned char*>(block.data()), block.size());
+	return Digest(&checksum, sizeof(checksum));
+}
+
+void CRC32CHash::calculateHashes(std::span<const std::span<const char>> blocks, std::span<Digest> digests) const
+{
+	static const Crc32c3Function crc32c3 = selectImplementation3();
+	for (size_t first = 0; first < blocks.size();) {
+		// Проход объединяет до трех идущих подряд блоков одинаковой длины; лишняя цепочка повторяет первый блок
+		size_t count = 1;
+		while (count < 3 && first + count < blocks.size() && blocks[first + count].size() == blocks[first].size())
+			++count;
+		if (count == 1) {
+			digests[first] = calculateHash(blocks[first]);
+			++first;
+			continue;
+		}
+		const unsigned char* data[3];
+		uint32_t crcs[3] = { ~0u, ~0u, ~0u };
+		for (size_t lane = 0; lane < 3; ++lane)
+			data[lane] = reinterpret_cast<const unsigned char*>(blocks[first + (lane < count ? lane : 0)].data());
+		crc32c3(data, blocks[first].size(), crcs);
+		for (size_t lane = 0; lane < count; ++lane) {
+			uint32_t checksum = ~crcs[lane];
+			digests[first + lane] = Digest(&checksum, sizeof(checksum));
+		}
+		first += count;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "DescriptorBudget.h"
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	/// Дескрипторы, оставляемые вне бюджета (кэш, стандартные потоки, служебные файлы)
+	constexpr size_t kReserved = 64;
+}
+
+DescriptorBudget::DescriptorBudget(size_t limit)
+	: limit_(limit == 0 ? systemLimit() : limit)
+{
+}
+
+void DescriptorBudget::acquire(Holder& holder)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (holder.held_ == 0)
+		released_.wait(lock, [this]() { return inUse_ < limit_; });
+	++inUse_;
+	++holder.held_;
+}
+
+bool DescriptorBudget::tryAcquire(Holder& holder)
+{
+	std::scoped_lock<std::mutex> lock(mutex_);
+	if (inUse_ >= limit_)
+		return false;
+	++inUse_;
+	++holder.held_;
+	return true;
+}
+
+void DescriptorBudget::release(Holder& holder)
+{
+	{
+		std::scoped_lock<std::mutex> lock(mutex_);
+		--inUse_;
+		--holder.held_;
+	}
+	released_.notify_one();
+}
+
+size_t DescriptorBudget::systemLimit()
+{
+	// По кольцу io_uring на рабочий поток
+	size_t reserved = kReserved + std::thread::hardware_concurrency();
+#ifdef _WIN32
+	int limit = _setmaxstdio(8192) == -1 ? _getmaxstdio() : 8192;
+	size_t available = static_cast<size_t>(limit);
+#else
+	rlimit limits{};
+	if (::getrlimit(RLIMIT_NOFILE, &limits) != 0)
+		return 256;
+	if (limits.rlim_cur != limits.rlim_max) {
+		rlimit raised = limits;
+		raised.rlim_cur = limits.rlim_max == RLIM_INFINITY ? std::max<rlim_t>(limits.rlim_cur, 1 << 20) : limits.rlim_max;
+		if (::setrlimit(RLIMIT_NOFILE, &raised) == 0)
+			limits = raised;
+	}
+	size_t available = limits.rlim_cur == RLIM_INFINITY ? size_t{ 1 } << 20 : static_cast<size_t>(limits.rlim_cur);
+#endif
+	return available > 2 * reserved ? available - reserved : std::max<size_t>(available / 2, 1);
+}
\ No newline at end of file
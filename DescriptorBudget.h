@@ -0,0 +1,86 @@
+/**
+ * @file DescriptorBudget.h
+ * @brief Заголовочный файл для класса DescriptorBudget.
+ *
+ * Класс DescriptorBudget ограничивает количество одновременно открытых файлов
+ * всеми параллельно сравниваемыми группами.
+ */
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+/**
+ * @class DescriptorBudget
+ * @brief Общий для всех групп бюджет открытых файловых дескрипторов.
+ *
+ * Группа, у которой нет ни одного дескриптора, ждет освобождения (acquire), а группа,
+ * у которой они уже есть, при нехватке закрывает один из своих файлов (tryAcquire).
+ * Так каждая группа всегда может продвинуться хотя бы с одним открытым файлом.
+ * Дескрипторы учитываются по владельцу (Holder), а не по потоку: файлы группы открывают
+ * и закрывают разные рабочие потоки.
+ */
+class DescriptorBudget
+{
+public:
+	/**
+	 * @class Holder
+	 * @brief Владелец дескрипторов (группа или сравнение). Счетчик изменяется под мьютексом бюджета.
+	 */
+	class Holder
+	{
+	public:
+		/// Количество удерживаемых дескрипторов
+		size_t held() const { return held_; }
+
+	private:
+		friend class DescriptorBudget;
+		size_t held_{ 0 }; ///< Количество удерживаемых дескрипторов.
+	};
+
+	/**
+	 * @brief Конструктор класса DescriptorBudget.
+	 * @param limit Максимальное количество открытых дескрипторов (0 - по системному ограничению).
+	 */
+	explicit DescriptorBudget(size_t limit);
+
+	/**
+	 * @brief Метод для получения дескриптора с ожиданием.
+	 *
+	 * Если владелец уже удерживает дескрипторы (побайтное сравнение с открытым эталонным файлом),
+	 * дескриптор выдается сверх бюджета, чтобы владелец не ждал сам себя.
+	 * @param holder Владелец дескриптора.
+	 */
+	void acquire(Holder& holder);
+
+	/**
+	 * @brief Метод для получения дескриптора без ожидания.
+	 * @param holder Владелец дескриптора.
+	 * @return true, если дескриптор получен.
+	 */
+	bool tryAcquire(Holder& holder);
+
+	/**
+	 * @brief Метод для возврата дескриптора в бюджет.
+	 * @param holder Владелец дескриптора.
+	 */
+	void release(Holder& holder);
+
+	/// Максимальное количество открытых дескрипторов
+	size_t limit() const { return limit_; }
+
+	/**
+	 * @brief Метод для получения бюджета по системному ограничению RLIMIT_NOFILE.
+	 *
+	 * Мягкое ограничение поднимается до жесткого; часть дескрипторов оставляется
+	 * для кэша, колец io_uring и стандартных потоков.
+	 * @return Количество дескрипторов, доступных для файлов групп.
+	 */
+	static size_t systemLimit();
+
+private:
+	size_t limit_; ///< Максимальное количество открытых дескрипторов.
+	size_t inUse_{ 0 }; ///< Количество выданных дескрипторов.
+	std::mutex mutex_; ///< Мьютекс для синхронизации доступа к счетчику.
+	std::condition_variable released_; ///< Условная переменная освобождения дескриптора.
+};
\ No newline at end of file
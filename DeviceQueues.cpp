@@ -0,0 +1,188 @@
+#include "DeviceQueues.h"
+#include "Stats.h"
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
+
+namespace
+{
+	/**
+	 * @brief Функция для разбора неотрицательного целого.
+	 * @param text Текст.
+	 * @return Число.
+	 * @throws std::invalid_argument Если текст не является числом.
+	 */
+	size_t parseCount(const std::string& text)
+	{
+		if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+			throw std::invalid_argument("Invalid device jobs: " + text);
+		try {
+			return static_cast<size_t>(std::stoull(text));
+		}
+		catch (const std::out_of_range&) {
+			throw std::invalid_argument("Invalid device jobs: " + text);
+		}
+	}
+
+#ifdef __linux__
+	/// Сведения об устройстве из sysfs
+	struct DeviceInfo
+	{
+		std::string number; ///< major:minor.
+		std::string name; ///< Имя устройства или раздела.
+		std::string disk; ///< Имя диска раздела.
+		bool rotational{ false }; ///< Вращающийся диск.
+	};
+
+	/**
+	 * @brief Функция для получения сведений об устройстве. Потокобезопасна.
+	 *
+	 * Сведения читаются из /sys/dev/block при первом обращении к устройству и запоминаются:
+	 * ограничение запрашивается для каждой большой группы.
+	 * @param device Устройство.
+	 * @return Сведения об устройстве.
+	 */
+	const DeviceInfo& deviceInfo(uint64_t device)
+	{
+		static std::mutex mutex;
+		static std::unordered_map<uint64_t, DeviceInfo> devices;
+		std::scoped_lock<std::mutex> lock(mutex);
+		if (auto it = devices.find(device); it != devices.end())
+			return it->second;
+		namespace fs = std::filesystem;
+		DeviceInfo info;
+		std::error_code ec;
+		info.number = std::to_string(major(device)) + ":" + std::to_string(minor(device));
+		fs::path resolved = fs::canonical(fs::path("/sys/dev/block") / info.number, ec);
+		if (!ec) {
+			// Раздел задается своим именем или именем диска; очередь и тип диска - у диска
+			fs::path disk = fs::exists(resolved / "partition", ec) ? resolved.parent_path() : resolved;
+			info.name = resolved.filename().string();
+			info.disk = disk.filename().string();
+			std::ifstream rotational(disk / "queue" / "rotational");
+			int value = 0;
+			info.rotational = rotational >> value && value == 1;
+		}
+		// Элементы unordered_map не перемещаются при вставке других
+		return devices.emplace(device, std::move(info)).first->second;
+	}
+#endif
+}
+
+DeviceJobs DeviceJobs::parse(const std::vector<std::string>& values)
+{
+	DeviceJobs jobs;
+	for (const auto& value : values) {
+		auto separator = value.rfind('=');
+		if (separator == std::string::npos) {
+			jobs.all = parseCount(value);
+			continue;
+		}
+		if (separator == 0)
+			throw std::invalid_argument("Invalid device jobs: " + value);
+		jobs.byName[value.substr(0, separator)] = parseCount(value.substr(separator + 1));
+	}
+	return jobs;
+}
+
+size_t DeviceJobs::limit(uint64_t device, size_t rotationalJobs) const
+{
+#ifdef __linux__
+	const DeviceInfo& info = deviceInfo(device);
+	for (const auto* name : { &info.number, &info.name, &info.disk }) {
+		if (auto it = byName.find(*name); !name->empty() && it != byName.end())
+			return it->second;
+	}
+	if (all)
+		return *all;
+	return info.rotational ? rotationalJobs : 0;
+#else
+	(void)device;
+	(void)rotationalJobs;
+	return all.value_or(0);
+#endif
+}
+
+void DeviceQueues::run(uint64_t device, ThreadPool::Task task)
+{
+	bool limited = false;
+	{
+		std::scoped_lock<std::mutex> lock(mutex_);
+		Queue& deviceQueue = queue(device);
+		if (deviceQueue.limit != 0) {
+			if (deviceQueue.running >= deviceQueue.limit) {
+				deviceQueue.pending.push_back(std::move(task));
+				Stats::add(StatCounter::DEVICE_QUEUED_TASKS);
+				return;
+			}
+			++deviceQueue.running;
+			limited = true;
+		}
+	}
+	if (!limited) {
+		tasks_.run(std::move(task));
+		return;
+	}
+	tasks_.run([this, device, task = std::move(task)]() mutable {
+		drain(device, std::move(task));
+		});
+}
+
+void DeviceQueues::drain(uint64_t device, ThreadPool::Task task)
+{
+	// Ошибка задачи не останавливает очередь: иначе ожидающие задачи устройства не выполнились бы
+	std::exception_ptr error;
+	for (;;) {
+		try {
+			task();
+		}
+		catch (...) {
+			if (!error)
+				error = std::current_exception();
+		}
+		std::scoped_lock<std::mutex> lock(mutex_);
+		Queue& deviceQueue = queues_.at(device);
+		if (deviceQueue.pending.empty()) {
+			--deviceQueue.running;
+			break;
+		}
+		task = std::move(deviceQueue.pending.front());
+		deviceQueue.pending.pop_front();
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+DeviceQueues::Queue& DeviceQueues::queue(uint64_t device)
+{
+	auto it = queues_.find(device);
+	if (it == queues_.end())
+		it = queues_.emplace(device, Queue{ jobs_.limit(device, rotationalJobs_), 0, {} }).first;
+	if (it->second.limit == 0)
+		it->second.limit = unlimitedJobs_;
+	return it->second;
+}
+
+uint64_t DeviceQueues::deviceOf(const std::string& path)
+{
+#ifndef _WIN32
+	struct stat st {};
+	if (::stat(path.c_str(), &st) == 0)
+		return static_cast<uint64_t>(st.st_dev);
+#else
+	(void)path;
+#endif
+	return 0;
+}
\ No newline at end of file
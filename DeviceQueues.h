@@ -0,0 +1,124 @@
+/**
+ * @file DeviceQueues.h
+ * @brief Заголовочный файл для класса DeviceQueues.
+ *
+ * Класс DeviceQueues распределяет задачи пула по очередям устройств с ограничением
+ * количества одновременно выполняемых задач каждого устройства.
+ */
+#pragma once
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct DeviceJobs
+ * @brief Ограничения одновременных задач устройств, заданные --device-jobs.
+ */
+struct DeviceJobs
+{
+	std::optional<size_t> all; ///< Ограничение для всех устройств (пусто - определяется автоматически).
+	std::map<std::string, size_t> byName; ///< Имя устройства (sda, nvme0n1) или major:minor -> ограничение.
+
+	/**
+	 * @brief Метод для разбора значений --device-jobs.
+	 * @param values Значения вида N или устройство=N (0 - без ограничения).
+	 * @return Ограничения устройств.
+	 * @throws std::invalid_argument Если значение имеет неверный формат.
+	 */
+	static DeviceJobs parse(const std::vector<std::string>& values);
+
+	/**
+	 * @brief Метод для определения ограничения устройства.
+	 *
+	 * Ограничение по имени устройства, иначе общее ограничение, иначе по
+	 * /sys/dev/block/MAJ:MIN/queue/rotational: rotationalJobs для вращающихся дисков,
+	 * без ограничения для остальных и для устройств без записи в sysfs. Сведения sysfs
+	 * читаются один раз для каждого устройства.
+	 * @param device Устройство.
+	 * @param rotationalJobs Ограничение вращающегося диска по умолчанию (0 - без ограничения).
+	 * @return Ограничение одновременных задач (0 - без ограничения).
+	 */
+	size_t limit(uint64_t device, size_t rotationalJobs = kRotationalJobs) const;
+
+	/// Одновременных задач вращающегося диска по умолчанию
+	static constexpr size_t kRotationalJobs = 1;
+};
+
+/**
+ * @class DeviceQueues
+ * @brief Очереди задач по устройствам (st_dev).
+ *
+ * Задачи устройства без ограничения сразу ставятся в пул. Задачи ограниченного
+ * устройства выполняются не более чем limit задачами пула одновременно, остальные
+ * ждут в очереди устройства в порядке постановки и не занимают рабочие потоки.
+ * Так сканирование нескольких устройств загружает каждое на своей глубине очереди:
+ * вращающийся диск не получает параллельных позиционирований головки, а NVMe не
+ * простаивает из-за него. Ограничение определяется DeviceJobs::limit. Ожидающие задачи
+ * выполняются задачами пула той же группы, поэтому ожидание группы дожидается и их.
+ */
+class DeviceQueues
+{
+public:
+	/**
+	 * @brief Конструктор класса DeviceQueues.
+	 * @param jobs Ограничения, заданные --device-jobs.
+	 * @param tasks Группа, в которой выполняются все задачи.
+	 * @param unlimitedJobs Ограничение для устройств без ограничения (0 - их задачи сразу ставятся в пул).
+	 * @param rotationalJobs Ограничение вращающегося диска по умолчанию (0 - без ограничения).
+	 */
+	DeviceQueues(const DeviceJobs& jobs, TaskGroup& tasks, size_t unlimitedJobs = 0, size_t rotationalJobs = DeviceJobs::kRotationalJobs)
+		: jobs_(jobs), tasks_(tasks), unlimitedJobs_(unlimitedJobs), rotationalJobs_(rotationalJobs)
+	{
+	}
+
+	/**
+	 * @brief Метод для постановки задачи устройства. Потокобезопасен.
+	 * @param device Устройство, к которому обращается задача.
+	 * @param task Задача.
+	 */
+	void run(uint64_t device, ThreadPool::Task task);
+
+	/**
+	 * @brief Метод для получения устройства, на котором находится путь.
+	 * @param path Путь.
+	 * @return Устройство (0, если путь недоступен).
+	 */
+	static uint64_t deviceOf(const std::string& path);
+
+private:
+	/// Очередь устройства
+	struct Queue
+	{
+		size_t limit; ///< Ограничение одновременных задач (0 - без ограничения).
+		size_t running{ 0 }; ///< Выполняемые задачи.
+		std::deque<ThreadPool::Task> pending; ///< Ожидающие задачи.
+	};
+
+	/**
+	 * @brief Метод для получения очереди устройства. Вызывается под mutex_.
+	 * @param device Устройство.
+	 * @return Очередь устройства.
+	 */
+	Queue& queue(uint64_t device);
+
+	/**
+	 * @brief Метод для выполнения задачи и ожидающих задач устройства, пока они есть.
+	 * @param device Устройство.
+	 * @param task Первая задача.
+	 */
+	void drain(uint64_t device, ThreadPool::Task task);
+
+	const DeviceJobs& jobs_; ///< Ограничения, заданные --device-jobs.
+	TaskGroup& tasks_; ///< Группа задач.
+	size_t unlimitedJobs_; ///< Ограничение для устройств без ограничения (0 - без очереди).
+	size_t rotationalJobs_; ///< Ограничение вращающегося диска по умолчанию.
+	std::mutex mutex_; ///< Мьютекс для синхронизации доступа к очередям.
+	std::unordered_map<uint64_t, Queue> queues_; ///< Очереди устройств.
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+/**
+ * @file Digest.h
+ * @brief Заголовочный файл для структуры Digest.
+ *
+ * Структура Digest хранит двоичный хэш фиксированной максимальной длины без выделения памяти.
+ */
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+
+/**
+ * @struct Digest
+ * @brief Двоичный хэш блока данных длиной до kMaxSize байт.
+ */
+struct Digest
+{
+	static constexpr size_t kMaxSize = 32; ///< Максимальная длина хэша, байт.
+
+	std::array<uint8_t, kMaxSize> bytes{}; ///< Байты хэша (неиспользуемые байты нулевые).
+	uint8_t length{ 0 }; ///< Длина хэша, байт.
+
+	/// Конструктор по умолчанию (пустой хэш)
+	Digest() = default;
+
+	/**
+	 * @brief Конструктор из последовательности байт.
+	 * @param data Указатель на байты хэша.
+	 * @param size Длина хэша (не больше kMaxSize).
+	 */
+	Digest(const void* data, size_t size) : length(static_cast<uint8_t>(size)) {
+		std::memcpy(bytes.data(), data, size);
+	}
+
+	bool operator==(const Digest&) const = default;
+
+	/// Байты хэша
+	std::span<const uint8_t> view() const { return { bytes.data(), length }; }
+
+	/**
+	 * @brief Метод для получения шестнадцатеричного представления хэша.
+	 * @return Строка из 2 * length шестнадцатеричных символов.
+	 */
+	std::string toHex() const {
+		static constexpr char digits[] = "0123456789abcdef";
+		std::string result(length * 2, '0');
+		for (size_t i = 0; i < length; ++i) {
+			result[2 * i] = digits[bytes[i] >> 4];
+			result[2 * i + 1] = digits[bytes[i] & 0x0f];
+		}
+		return result;
+	}
+};
+
+/// Хэшер для Digest: байты хэша уже равномерно распределены, поэтому берутся первые 8
+struct DigestHash
+{
+	size_t operator()(const Digest& digest) const {
+		uint64_t value;
+		std::memcpy(&value, digest.bytes.data(), sizeof(value));
+		return static_cast<size_t>(value ^ digest.length);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "DuplicateIndex.h"
+#include "BlockReader.h"
+#include "Stats.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+
+DuplicateIndex::DuplicateIndex(const ArgumentParser::ParserData& data, ThreadPool& pool, HashCache* cache)
+	: data_(data), hashCalculator_(data.hashAlgorithm.get(), data.blockSchedule.maxBlockSize()), fdBudget_(data.maxOpenFiles), pool_(pool), cache_(cache)
+{
+}
+
+void DuplicateIndex::seed(const FileIndex& files)
+{
+	// Хэши не вычисляются: файлы без группы дубликатов уже доказанно уникальны в своей группе по размеру
+	std::scoped_lock<std::mutex> lock(mutex_);
+	for (FileId id = 0; id < files.fileCount(); ++id)
+		insert(files.path(id), files.key(id));
+}
+
+void DuplicateIndex::submit(const ResultGroup& group)
+{
+	if (group.kind != ResultGroup::Kind::DUPLICATES || group.files.empty())
+		return;
+	Digest digest = group.digest;
+	if (digest.length == 0) {
+		// Группы без хэша (пустые файлы) получают его по первому файлу
+		std::optional<FileKey> key;
+		{
+			std::scoped_lock<std::mutex> lock(mutex_);
+			if (auto it = files_.find({ group.files.front().device, group.files.front().inode }); it != files_.end())
+				key = it->second.key;
+		}
+		if (!key || !digestFile(group.files.front().path, *key, digest))
+			return;
+	}
+	std::scoped_lock<std::mutex> lock(mutex_);
+	for (const auto& file : group.files) {
+		if (auto it = files_.find({ file.device, file.inode }); it != files_.end())
+			it->second.digest = digest;
+	}
+}
+
+void DuplicateIndex::update(const std::string& path)
+{
+	std::error_code ec;
+	std::optional<FileKey> key;
+	if (std::filesystem::is_regular_file(path, ec) && data_.maskMatcher.matches(std::filesystem::path(path).filename().string()))
+		key = FileKey::fromPath(path);
+	bool stale = false;
+	{
+		std::scoped_lock<std::mutex> lock(mutex_);
+		if (!key || key->size < data_.minFileSize || key->size > data_.maxFileSize) {
+			erase(path);
+			return;
+		}
+		stale = insert(path, *key);
+	}
+	if (stale)
+		resolve(key->size);
+}
+
+void DuplicateIndex::remove(const std::string& path)
+{
+	std::scoped_lock<std::mutex> lock(mutex_);
+	erase(path);
+}
+
+void DuplicateIndex::removeTree(const std::string& directory)
+{
+	std::string prefix = directory;
+	if (prefix.empty() || prefix.back() != '/')
+		prefix += '/';
+	std::scoped_lock<std::mutex> lock(mutex_);
+	std::vector<std::string> removed;
+	for (const auto& [path, id] : paths_) {
+		if (path.starts_with(prefix))
+			removed.push_back(path);
+	}
+	for (const auto& path : removed)
+		erase(path);
+}
+
+bool DuplicateIndex::insert(const std::string& path, const FileKey& key)
+{
+	InodeId id{ key.device, key.inode };
+	if (auto it = paths_.find(path); it != paths_.end() && it->second != id)
+		erase(path);
+	auto [it, inserted] = files_.try_emplace(id);
+	IndexedFile& file = it->second;
+	if (inserted) {
+		file.key = key;
+		sizes_[key.size].insert(id);
+	}
+	else if (file.key != key) {
+		// Содержимое изменилось: файл переходит в группу нового размера и хэшируется заново
+		if (auto bucket = sizes_.find(file.key.size); bucket != sizes_.end()) {
+			bucket->second.erase(id);
+			if (bucket->second.empty())
+				sizes_.erase(bucket);
+		}
+		file.key = key;
+		file.digest = Digest();
+		sizes_[key.size].insert(id);
+	}
+	file.paths.insert(path);
+	paths_[path] = id;
+	return file.digest.length == 0 && sizes_[key.size].size() > 1;
+}
+
+void DuplicateIndex::erase(const std::string& path)
+{
+	auto it = paths_.find(path);
+	if (it == paths_.end())
+		return;
+	auto fileIt = files_.find(it->second);
+	paths_.erase(it);
+	if (fileIt == files_.end())
+		return;
+	fileIt->second.paths.erase(path);
+	if (!fileIt->second.paths.empty())
+		return;
+	if (auto bucket = sizes_.find(fileIt->second.key.size); bucket != sizes_.end()) {
+		bucket->second.erase(fileIt->first);
+		if (bucket->second.empty())
+			sizes_.erase(bucket);
+	}
+	files_.erase(fileIt);
+}
+
+void DuplicateIndex::resolve(uint64_t size)
+{
+	/// Файл группы без хэша
+	struct Missing
+	{
+		InodeId id;
+		FileKey key;
+		std::string path;
+		Digest digest;
+		char ok{ 0 };
+	};
+	std::vector<Missing> missing;
+	{
+		std::scoped_lock<std::mutex> lock(mutex_);
+		auto bucket = sizes_.find(size);
+		if (bucket == sizes_.end() || bucket->second.size() < 2)
+			return;
+		for (const auto& id : bucket->second) {
+			const IndexedFile& file = files_.at(id);
+			if (file.digest.length == 0)
+				missing.push_back({ id, file.key, *file.paths.begin(), {} });
+		}
+	}
+	{
+		TaskGroup tasks(pool_);
+		for (auto& file : missing) {
+			tasks.run([this, &file]() {
+				file.ok = digestFile(file.path, file.key, file.digest);
+				});
+		}
+		tasks.wait();
+	}
+	std::scoped_lock<std::mutex> lock(mutex_);
+	for (const auto& file : missing) {
+		// Файл, изменившийся во время хэширования, будет обновлен следующим событием
+		if (auto it = files_.find(file.id); file.ok && it != files_.end() && it->second.key == file.key)
+			it->second.digest = file.digest;
+	}
+}
+
+bool DuplicateIndex::digestFile(const std::string& path, const FileKey& key, Digest& digest)
+{
+	const auto& schedule = data_.blockSchedule;
+	const size_t blockCount = schedule.blockCount(key.size);
+	std::vector<Digest> blockHashes;
+	if (cache_ && cache_->lookup(key, blockHashes) && blockHashes.size() > blockCount)
+		blockHashes.resize(blockCount);
+	if (blockHashes.size() < blockCount) {
+		size_t cachedBlocks = blockHashes.size();
+		DescriptorBudget::Holder descriptors;
+		fdBudget_.acquire(descriptors);
+		auto reader = BlockReaderFactory::create(data_.ioMode, data_.cachePolicy);
+		if (!reader->open(path, key.size)) {
+			fdBudget_.release(descriptors);
+			Stats::add(StatCounter::FILES_FAILED);
+			std::cerr << "Failed to open file: " << path << ". File will be skipped." << std::endl;
+			return false;
+		}
+		bool complete = true;
+		for (size_t block = cachedBlocks; block < blockCount; ++block) {
+			size_t length = schedule.length(block, key.size);
+			auto data = reader->read(schedule.offset(block), length);
+			Stats::add(StatCounter::BYTES_READ, data.size());
+			Stats::add(StatCounter::BLOCKS_READ);
+			// Файл укоротился после получения метаданных
+			if (data.size() != length) {
+				complete = false;
+				break;
+			}
+			blockHashes.push_back(hashCalculator_.calculateHash(data));
+		}
+		reader->close();
+		fdBudget_.release(descriptors);
+		if (!complete)
+			return false;
+		if (cache_)
+			cache_->store(key, blockHashes);
+	}
+	digest = blockHashes.empty() ? hashCalculator_.calculateHash({}) : hashCalculator_.combineHashes(blockHashes);
+	return true;
+}
+
+std::vector<ResultGroup> DuplicateIndex::groups()
+{
+	std::vector<ResultGroup> result;
+	std::scoped_lock<std::mutex> lock(mutex_);
+	for (const auto& [size, ids] : sizes_) {
+		if (ids.size() < 2)
+			continue;
+		std::unordered_map<Digest, std::vector<const IndexedFile*>, DigestHash> byDigest;
+		for (const auto& id : ids) {
+			const IndexedFile& file = files_.at(id);
+			if (file.digest.length != 0)
+				byDigest[file.digest].push_back(&file);
+		}
+		for (const auto& [digest, files] : byDigest) {
+			if (files.size() < 2)
+				continue;
+			ResultGroup group;
+			group.size = size;
+			group.digest = digest;
+			for (const auto* file : files) {
+				for (const auto& path : file->paths)
+					group.files.push_back({ path, file->key.device, file->key.inode, file->key.mtime });
+			}
+			std::sort(group.files.begin(), group.files.end(), [](const ResultFile& lhs, const ResultFile& rhs) {
+				return lhs.path < rhs.path;
+				});
+			result.push_back(std::move(group));
+		}
+	}
+	std::sort(result.begin(), result.end(), [](const ResultGroup& lhs, const ResultGroup& rhs) {
+		return lhs.files.front().path < rhs.files.front().path;
+		});
+	return result;
+}
+
+std::vector<std::string> DuplicateIndex::paths()
+{
+	std::scoped_lock<std::mutex> lock(mutex_);
+	std::vector<std::string> result;
+	result.reserve(paths_.size());
+	for (const auto& [path, id] : paths_)
+		result.push_back(path);
+	return result;
+}
+
+size_t DuplicateIndex::pathCount()
+{
+	std::scoped_lock<std::mutex> lock(mutex_);
+	return paths_.size();
+}
+
+size_t DuplicateIndex::fileCount()
+{
+	std::scoped_lock<std::mutex> lock(mutex_);
+	return files_.size();
+}
\ No newline at end of file
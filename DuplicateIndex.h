@@ -0,0 +1,145 @@
+/**
+ * @file DuplicateIndex.h
+ * @brief Заголовочный файл для класса DuplicateIndex.
+ *
+ * Класс DuplicateIndex хранит найденные файлы и хэши их содержимого между изменениями
+ * для режима наблюдения.
+ */
+#pragma once
+#include "ArgumentParser.h"
+#include "DescriptorBudget.h"
+#include "FileCollector.h"
+#include "HashCache.h"
+#include "HashCalculator.h"
+#include "ResultWriter.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class DuplicateIndex
+ * @brief Инкрементальный индекс дубликатов.
+ *
+ * Индекс заполняется результатами полного сканирования: файлы групп дубликатов получают
+ * хэш содержимого, остальные файлы уже доказанно уникальны в своей группе по размеру
+ * и хэшируются только тогда, когда к их размеру добавляется новый файл. Изменившийся
+ * файл переносится в группу своего нового размера, и перечитываются только файлы этой
+ * группы без хэша, поэтому изменение нескольких файлов не требует повторного сканирования.
+ */
+class DuplicateIndex : public IGroupSink
+{
+public:
+	/**
+	 * @brief Конструктор класса DuplicateIndex.
+	 * @param data Данные, полученные из аргументов командной строки.
+	 * @param pool Пул потоков для хэширования.
+	 * @param cache Кэш хэшей (может отсутствовать).
+	 */
+	DuplicateIndex(const ArgumentParser::ParserData& data, ThreadPool& pool, HashCache* cache = nullptr);
+
+	/**
+	 * @brief Метод для заполнения индекса файлами полного сканирования (до сравнения).
+	 * @param files Все найденные файлы, включая группы из одного файла и псевдонимы.
+	 */
+	void seed(const FileIndex& files);
+
+	/**
+	 * @brief Метод для передачи группы дубликатов, найденной сравнением. Потокобезопасен.
+	 * @param group Группа дубликатов.
+	 */
+	void submit(const ResultGroup& group) override;
+
+	/**
+	 * @brief Метод для обновления файла после создания или изменения (удаленный файл исключается).
+	 * @param path Путь к файлу.
+	 */
+	void update(const std::string& path);
+
+	/**
+	 * @brief Метод для исключения файла.
+	 * @param path Путь к файлу.
+	 */
+	void remove(const std::string& path);
+
+	/**
+	 * @brief Метод для исключения всех файлов директории и ее поддиректорий.
+	 * @param directory Путь к директории.
+	 */
+	void removeTree(const std::string& directory);
+
+	/**
+	 * @brief Метод для получения текущих групп дубликатов.
+	 * @return Группы дубликатов, упорядоченные по первому пути.
+	 */
+	std::vector<ResultGroup> groups();
+
+	/**
+	 * @brief Метод для получения всех путей индекса.
+	 * @return Пути файлов в индексе.
+	 */
+	std::vector<std::string> paths();
+
+	/// Количество путей в индексе
+	size_t pathCount();
+
+	/// Количество файлов (inode) в индексе
+	size_t fileCount();
+
+private:
+	/// Идентификатор физического файла: устройство и inode
+	using InodeId = std::pair<uint64_t, uint64_t>;
+
+	/// Физический файл индекса
+	struct IndexedFile
+	{
+		FileKey key; ///< Ключ файла при последнем обновлении.
+		std::set<std::string> paths; ///< Пути к файлу.
+		Digest digest; ///< Хэш содержимого (пустой - не вычислен).
+	};
+
+	/**
+	 * @brief Метод для добавления пути к файлу. Вызывается под mutex_.
+	 * @param path Путь к файлу.
+	 * @param key Ключ файла.
+	 * @return true, если группу размера файла нужно дохэшировать.
+	 */
+	bool insert(const std::string& path, const FileKey& key);
+
+	/**
+	 * @brief Метод для исключения пути. Вызывается под mutex_.
+	 * @param path Путь к файлу.
+	 */
+	void erase(const std::string& path);
+
+	/**
+	 * @brief Метод для вычисления недостающих хэшей группы одного размера.
+	 * @param size Размер файлов группы.
+	 */
+	void resolve(uint64_t size);
+
+	/**
+	 * @brief Метод для вычисления хэша содержимого файла, как в выводе сравнения.
+	 * @param path Путь к файлу.
+	 * @param key Ключ файла.
+	 * @param digest Хэш содержимого.
+	 * @return false, если файл не удалось прочитать.
+	 */
+	bool digestFile(const std::string& path, const FileKey& key, Digest& digest);
+
+	const ArgumentParser::ParserData& data_; ///< Данные, полученные из аргументов командной строки.
+	HashCalculator hashCalculator_; ///< Калькулятор хэшей.
+	DescriptorBudget fdBudget_; ///< Бюджет открытых файлов.
+	ThreadPool& pool_; ///< Пул потоков.
+	HashCache* cache_; ///< Кэш хэшей.
+	std::mutex mutex_; ///< Мьютекс для синхронизации доступа к индексу.
+	std::map<InodeId, IndexedFile> files_; ///< Физические файлы.
+	std::unordered_map<std::string, InodeId, string_view_hash, string_view_equal> paths_; ///< Путь -> файл.
+	std::unordered_map<uint64_t, std::set<InodeId>> sizes_; ///< Размер -> файлы.
+};
\ No newline at end of file
@@ -1,111 +1,383 @@
-#include "FileCollector.h"
-#include <iostream>
-#include <future>
-#include <algorithm>
-#include <cctype>
-#include <cstdint>
-#include <exception>
-#include <filesystem>
-#include <mutex>
-#include <string>
-#include <vector>
-#include "ArgumentParser.h"
-
-std::string to_lower(const std::string& str) {
-	std::string result = str;
-	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) {
-		return std::tolower(c);
-		});
-	return result;
-}
-
-FileCollector::FileCollector(const ArgumentParser::ParserData& data) {
-	FilePaths allPaths;
-	std::vector<std::future<void>> futures;
-	for (const auto& path : data.directories) {
-		futures.push_back(std::async(std::launch::async, [this, path, &data, &allPaths]() {
-			try {
-				collectPaths(path, 0, data.level, allPaths);
-			}
-			catch (const std::exception& e) {
-				std::scoped_lock<std::mutex> lock(cout_mutex);
-				std::cerr << "Error: Failed to process directory " << path << ": " << e.what() << ". Skipping this directory." << std::endl;
-			}
-			}));
-	}
-	for (auto const& future : futures)
-		future.wait();
-	for (auto const& path : data.excludeDirectories)
-		allPaths.erase(path);
-	std::vector<std::future<void>> fileFutures;
-	for (std::filesystem::path const& dirPath : allPaths) {
-		fileFutures.push_back(std::async(std::launch::async, [this, dirPath, &data]() {
-			try {
-				processDirectory(dirPath, data);
-			}
-			catch (const std::exception& e) {
-				std::scoped_lock<std::mutex> lock(cout_mutex);
-				std::cerr << "Error: Failed to process directory " << dirPath << ": " << e.what() << ". Skipping this directory." << std::endl;
-			}
-			}));
-	}
-	for (auto const& future : fileFutures)
-		future.wait();
-}
-
-void FileCollector::collectPaths(const fs::path& root, size_t depth, size_t maxDepth, FilePaths& paths) {
-	if (depth > maxDepth)
-		return;
-	if (!fs::exists(root)) {
-		std::scoped_lock<std::mutex> lock(cout_mutex);
-		std::cout << "Error: Directory does not exist: " << root << ". Skipping this directory." << std::endl;
-		return;
-	}
-	if (!fs::is_directory(root)) {
-		std::scoped_lock<std::mutex> lock(cout_mutex);
-		std::cout << "Error: Path is not a directory: " << root << ". Skipping this path." << std::endl;
-		return;
-	}
-	try {
-		paths.insert(root.string());
-		for (const auto& entry : fs::directory_iterator(root)) {
-			if (fs::is_directory(entry)) {
-				collectPaths(entry.path(), depth + 1, maxDepth, paths);
-			}
-		}
-	}
-	catch (const fs::filesystem_error& e) {
-		std::scoped_lock<std::mutex> lock(cout_mutex);
-		std::cerr << "Error: Unable to access directory " << root << ": " << e.what() << ". Skipping this directory." << std::endl;
-	}
-}
-
-void FileCollector::processDirectory(const fs::path& dirPath, const ArgumentParser::ParserData& data) {
-	if (fs::exists(dirPath) && fs::is_directory(dirPath)) {
-		for (const auto& entry : fs::directory_iterator(dirPath)) {
-			if (fs::is_regular_file(entry)) {
-				uintmax_t fileSize = fs::file_size(entry);
-				auto const& entryPath = entry.path();
-				std::string filePath = entryPath.string();
-				std::string fileExtension = to_lower(entryPath.extension().string());
-
-				if (!data.masks.empty()) {
-					for (auto& mask : data.masks) {
-						if (to_lower(mask) != to_lower(fileExtension))
-							continue;
-						if (fileSize < data.minFileSize)
-							continue;
-						std::scoped_lock<std::mutex> lock(filesMutex_);
-						fileGroups_[fileSize].emplace_back(filePath);
-					}
-				}
-				else {
-					if (fileSize < data.minFileSize)
-						continue;
-					std::scoped_lock<std::mutex> lock(filesMutex_);
-					fileGroups_[fileSize].emplace_back(filePath);
-				}
-			}
-		}
-	}
+#include "FileCollector.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "ArgumentParser.h"
+#include "Stats.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace
+{
+	/**
+	 * @brief Функция для получения пути к элементу директории.
+	 * @param dirPath Путь к директории.
+	 * @param name Имя элемента.
+	 * @return Путь к элементу.
+	 */
+	std::string joinPath(const std::string& dirPath, std::string_view name)
+	{
+		std::string result;
+		result.reserve(dirPath.size() + name.size() + 1);
+		result = dirPath;
+		if (!result.empty() && result.back() != '/' && result.back() != static_cast<char>(fs::path::preferred_separator))
+			result += static_cast<char>(fs::path::preferred_separator);
+		result += name;
+		return result;
+	}
+
+	/**
+	 * @brief Функция для приведения пути директории к виду, в котором сравниваются исключения.
+	 * @param dirPath Путь к директории.
+	 * @return Нормализованный путь без завершающего разделителя.
+	 */
+	std::string normalizeDirectory(const std::string& dirPath)
+	{
+		std::string result = fs::path(dirPath).lexically_normal().string();
+		while (result.size() > 1 && (result.back() == '/' || result.back() == static_cast<char>(fs::path::preferred_separator)))
+			result.pop_back();
+		return result;
+	}
+
+#ifndef _WIN32
+	/**
+	 * @brief Функция для перебора элементов открытой директории с типом из d_type.
+	 * @param dirFd Дескриптор директории.
+	 * @param onEntry Функция, вызываемая для каждого элемента (кроме "." и "..").
+	 * @return false, если чтение директории завершилось ошибкой.
+	 */
+	template <typename OnEntry>
+	bool forEachEntry(int dirFd, OnEntry&& onEntry)
+	{
+		auto isDots = [](const char* name) {
+			return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+			};
+#ifdef __linux__
+		// getdents64 возвращает пачку записей за один системный вызов
+		struct LinuxDirent64
+		{
+			uint64_t d_ino;
+			int64_t d_off;
+			unsigned short d_reclen;
+			unsigned char d_type;
+			char d_name[1];
+		};
+		alignas(LinuxDirent64) char buffer[32 * 1024];
+		for (;;) {
+			long bytes = ::syscall(SYS_getdents64, dirFd, buffer, sizeof(buffer));
+			if (bytes < 0 && errno == EINTR)
+				continue;
+			if (bytes < 0)
+				return false;
+			if (bytes == 0)
+				return true;
+			for (long offset = 0; offset < bytes;) {
+				auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + offset);
+				offset += entry->d_reclen;
+				if (!isDots(entry->d_name))
+					onEntry(entry->d_name, entry->d_type);
+			}
+		}
+#else
+		int fd = ::dup(dirFd);
+		DIR* dir = fd >= 0 ? ::fdopendir(fd) : nullptr;
+		if (!dir) {
+			if (fd >= 0)
+				::close(fd);
+			return false;
+		}
+		errno = 0;
+		while (auto* entry = ::readdir(dir)) {
+			if (!isDots(entry->d_name))
+				onEntry(entry->d_name, entry->d_type);
+		}
+		bool ok = errno == 0;
+		::closedir(dir);
+		return ok;
+#endif
+	}
+#endif
+}
+
+FileCollector::FileCollector(const ArgumentParser::ParserData& data, ThreadPool& pool)
+	: data_(data), pool_(pool)
+{
+	StatTimer timer(StatCounter::WALK_NANOS);
+	for (auto const& path : data.excludeDirectories)
+		excluded_.insert(normalizeDirectory(path));
+	TaskGroup tasks(pool_);
+	DeviceQueues queues(data.deviceJobs, tasks);
+	for (const auto& path : data.directories) {
+		queues.run(DeviceQueues::deviceOf(path), [this, path, &queues]() {
+			try {
+				walkRoot(path, queues);
+			}
+			catch (const std::exception& e) {
+				std::scoped_lock<std::mutex> lock(cout_mutex);
+				std::cerr << "Error: Failed to process directory " << path << ": " << e.what() << ". Skipping this directory." << std::endl;
+			}
+			});
+	}
+	tasks.wait();
+	collapseAliases();
+}
+
+void FileCollector::walkRoot(const std::string& root, DeviceQueues& queues)
+{
+	std::error_code ec;
+	if (!fs::exists(root, ec)) {
+		std::scoped_lock<std::mutex> lock(cout_mutex);
+		std::cerr << "Error: Directory does not exist: " << fs::path(root) << ". Skipping this directory." << std::endl;
+		return;
+	}
+	if (!fs::is_directory(root, ec)) {
+		std::scoped_lock<std::mutex> lock(cout_mutex);
+		std::cerr << "Error: Path is not a directory: " << fs::path(root) << ". Skipping this path." << std::endl;
+		return;
+	}
+	walkDirectory(root, FileIndex::kNoDirectory, root, 0, queues);
+}
+
+bool FileCollector::markVisited(const std::string& dirPath, size_t depth)
+{
+	// Вместо строк хранятся 128-битные хэши путей: вероятность совпадения пренебрежимо мала
+	static const XXH128Hash pathHash;
+	Digest key = pathHash.calculateHash(dirPath);
+	std::scoped_lock<std::mutex> lock(visitedMutex_);
+	auto [it, inserted] = visited_.try_emplace(key, depth);
+	if (!inserted && it->second <= depth)
+		return false;
+	it->second = depth;
+	return true;
+}
+
+DirectoryId FileCollector::addDirectory(DirectoryId parent, std::string_view name)
+{
+	std::scoped_lock<std::mutex> lock(filesMutex_);
+	return index_.addDirectory(parent, name);
+}
+
+void FileCollector::addFiles(DirectoryId directory, const DirectoryFiles& files)
+{
+	if (files.files.empty())
+		return;
+	Stats::add(StatCounter::FILES_COLLECTED, files.files.size());
+	std::scoped_lock<std::mutex> lock(filesMutex_);
+	size_t offset = 0;
+	for (const auto& [length, key] : files.files) {
+		index_.addFile(directory, std::string_view(files.names).substr(offset, length), key);
+		offset += length;
+	}
+}
+
+void FileCollector::walkDirectory(const std::string& dirPath, DirectoryId parent, std::string_view name, size_t depth, DeviceQueues& queues)
+{
+	std::string normalized = normalizeDirectory(dirPath);
+	if (excluded_.contains(normalized))
+		return;
+	// Директория, найденная через пересекающиеся корни, обходится один раз с наименьшей глубины
+	if (!markVisited(normalized, depth))
+		return;
+	readDirectory(dirPath, addDirectory(parent, name), depth, queues);
+}
+
+#ifndef _WIN32
+void FileCollector::readDirectory(const std::string& dirPath, DirectoryId directory, size_t depth, DeviceQueues& queues)
+{
+	auto reportError = [&]() {
+		int error = errno;
+		std::scoped_lock<std::mutex> lock(cout_mutex);
+		std::cerr << "Error: Unable to access directory " << fs::path(dirPath) << ": " << std::strerror(error) << ". Skipping this directory." << std::endl;
+		};
+
+	int dirFd = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dirFd < 0) {
+		reportError();
+		return;
+	}
+	// Поддиректории ставятся в очередь устройства этой директории: точки монтирования внутри редки
+	struct stat dirStat {};
+	uint64_t device = ::fstat(dirFd, &dirStat) == 0 ? static_cast<uint64_t>(dirStat.st_dev) : 0;
+
+	DirectoryFiles files;
+	std::vector<std::string> subdirectories;
+	uint64_t entries = 0;
+	uint64_t statCalls = 0;
+	auto addRegularFile = [&](const char* name, const struct stat& st) {
+		if (static_cast<uintmax_t>(st.st_size) < data_.minFileSize || static_cast<uintmax_t>(st.st_size) > data_.maxFileSize)
+			return;
+		size_t length = std::strlen(name);
+		files.names.append(name, length);
+		files.files.emplace_back(length, FileKey::fromStat(st));
+		};
+
+	bool ok = forEachEntry(dirFd, [&](const char* name, unsigned char type) {
+		struct stat st {};
+		++entries;
+		switch (type) {
+		case DT_DIR:
+			if (depth < data_.level)
+				subdirectories.emplace_back(name);
+			break;
+		case DT_REG:
+			// Тип известен из d_type: stat нужен только для размера и inode подходящих по маске файлов
+			if (!data_.maskMatcher.matches(name))
+				break;
+			++statCalls;
+			if (::fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+				addRegularFile(name, st);
+			break;
+		case DT_LNK:
+		case DT_UNKNOWN:
+			// Символические ссылки разыменовываются, тип неизвестен на части файловых систем
+			++statCalls;
+			if (::fstatat(dirFd, name, &st, 0) != 0)
+				break;
+			if (S_ISDIR(st.st_mode)) {
+				if (depth < data_.level)
+					subdirectories.emplace_back(name);
+			}
+			else if (S_ISREG(st.st_mode) && data_.maskMatcher.matches(name)) {
+				addRegularFile(name, st);
+			}
+			break;
+		default:
+			break;
+		}
+		});
+	if (!ok)
+		reportError();
+	::close(dirFd);
+	Stats::add(StatCounter::DIRECTORIES);
+	Stats::add(StatCounter::ENTRIES, entries);
+	Stats::add(StatCounter::STAT_CALLS, statCalls);
+
+	addFiles(directory, files);
+	// Поддиректории обходятся параллельно задачами пула
+	for (const auto& name : subdirectories) {
+		queues.run(device, [this, subPath = joinPath(dirPath, name), directory, name, depth, &queues]() {
+			walkDirectory(subPath, directory, name, depth + 1, queues);
+			});
+	}
+}
+#else
+void FileCollector::readDirectory(const std::string& dirPath, DirectoryId directory, size_t depth, DeviceQueues& queues)
+{
+	DirectoryFiles files;
+	// Без st_dev все директории попадают в одну очередь
+	uint64_t device = 0;
+	std::vector<std::string> subdirectories;
+	uint64_t entries = 0;
+	try {
+		// На Windows тип и размер приходят вместе с элементом директории
+		for (const auto& entry : fs::directory_iterator(dirPath)) {
+			std::error_code ec;
+			++entries;
+			std::string name = entry.path().filename().string();
+			if (entry.is_directory(ec)) {
+				if (depth < data_.level)
+					subdirectories.push_back(std::move(name));
+			}
+			else if (entry.is_regular_file(ec) && data_.maskMatcher.matches(name)) {
+				uintmax_t fileSize = entry.file_size(ec);
+				if (ec || fileSize < data_.minFileSize || fileSize > data_.maxFileSize)
+					continue;
+				auto mtime = entry.last_write_time(ec);
+				if (ec)
+					continue;
+				// Без inode файл идентифицируется хэшем пути, как в FileKey::fromPath
+				FileKey key{ 0, std::hash<std::string>{}(joinPath(dirPath, name)), fileSize, static_cast<int64_t>(mtime.time_since_epoch().count()) };
+				files.names += name;
+				files.files.emplace_back(name.size(), key);
+			}
+		}
+	}
+	catch (const fs::filesystem_error& e) {
+		std::scoped_lock<std::mutex> lock(cout_mutex);
+		std::cerr << "Error: Unable to access directory " << fs::path(dirPath) << ": " << e.what() << ". Skipping this directory." << std::endl;
+	}
+	Stats::add(StatCounter::DIRECTORIES);
+	Stats::add(StatCounter::ENTRIES, entries);
+
+	addFiles(directory, files);
+	for (const auto& name : subdirectories) {
+		queues.run(device, [this, subPath = joinPath(dirPath, name), directory, name, depth, &queues]() {
+			walkDirectory(subPath, directory, name, depth + 1, queues);
+			});
+	}
+}
+#endif
+
+void FileCollector::collapseAliases()
+{
+	// Пути к одному inode оказываются рядом; полные пути собираются только для них, чтобы первым
+	// в группе шел лексикографически меньший путь
+	std::vector<FileId> files(index_.fileCount());
+	std::iota(files.begin(), files.end(), FileId{ 0 });
+	std::sort(files.begin(), files.end(), [this](FileId lhs, FileId rhs) {
+		const FileKey& left = index_.key(lhs);
+		const FileKey& right = index_.key(rhs);
+		if (std::tie(left.size, left.device, left.inode) != std::tie(right.size, right.device, right.inode))
+			return std::tie(left.size, left.device, left.inode) < std::tie(right.size, right.device, right.inode);
+		return index_.path(lhs) < index_.path(rhs);
+		});
+
+	// Один путь на физический файл сдвигается к началу массива, на месте
+	size_t kept = 0;
+	for (size_t first = 0; first < files.size();) {
+		const FileKey& key = index_.key(files[first]);
+		size_t last = first + 1;
+		std::vector<FileId> entries{ files[first] };
+		std::string previous;
+		for (; last < files.size() && index_.key(files[last]).device == key.device && index_.key(files[last]).inode == key.inode; ++last) {
+			if (previous.empty())
+				previous = index_.path(entries.back());
+			// Один и тот же путь, найденный через пересекающиеся корни, псевдонимом не считается
+			std::string path = index_.path(files[last]);
+			if (path != previous) {
+				entries.push_back(files[last]);
+				previous = std::move(path);
+				Stats::add(StatCounter::ALIAS_PATHS);
+			}
+		}
+		files[kept++] = entries.front();
+		if (entries.size() > 1)
+			aliases_.push_back(std::move(entries));
+		first = last;
+	}
+	files.resize(kept);
+	files.shrink_to_fit();
+	groupedFiles_ = std::move(files);
+
+	// Группы из одного файла не сравниваются и в группы не попадают
+	for (size_t first = 0; first < groupedFiles_.size();) {
+		uintmax_t fileSize = index_.key(groupedFiles_[first]).size;
+		size_t last = first + 1;
+		while (last < groupedFiles_.size() && index_.key(groupedFiles_[last]).size == fileSize)
+			++last;
+		if (last - first > 1)
+			fileGroups_.push_back({ fileSize, std::span<const FileId>(groupedFiles_).subspan(first, last - first) });
+		first = last;
+	}
+	// Группы не пересекаются, поэтому порядок задается первым путем
+	std::sort(aliases_.begin(), aliases_.end(), [this](const auto& lhs, const auto& rhs) {
+		return index_.path(lhs.front()) < index_.path(rhs.front());
+		});
 }
\ No newline at end of file
@@ -1,83 +1,175 @@
-/**
- * @file FileCollector.h
- * @brief Заголовочный файл для класса FileCollector.
- *
- * Класс FileCollector предназначен для сбора файлов из указанных директорий.
- */
-#pragma once
-#include "ArgumentParser.h"
-#include <vector>
-#include <filesystem>
-#include <unordered_set>
-#include <string>
-#include <unordered_map>
-#include <cstdint>
-#include <mutex>
-
-namespace fs = std::filesystem;
-
-/// Вектор групп путей к файлам сгруппированных по размерам файлов
-using FileGroups = std::unordered_map<uintmax_t, std::vector<std::string>>;
-
-/// Прозрачный хэшер для std::string_view
-struct string_view_hash
-{
-	using is_transparent = void; //Включаем поддержку прозрачного хэширования
-
-	std::size_t operator()(std::string_view sv) const {
-		return std::hash<std::string_view>{}(sv);
-	}
-};
-
-/// Прозрачный компаратор для std::string_view
-struct string_view_equal
-{
-	using is_transparent = void; //Включаем поддержку прозрачного сравнения
-
-	bool operator()(std::string_view lhs, std::string_view rhs) const {
-		return lhs == rhs;
-	}
-};
-
-using FilePaths = std::unordered_set<std::string, string_view_hash, string_view_equal>;
-
-/**
- * @class FileCollector
- * @brief Класс для сбора файлов из указанных директорий.
- */
-class FileCollector
-{
-public:
-	/**
-	 * @brief Конструктор класса FileCollector.
-	 * @param data Данные, полученные из аргументов командной строки.
-	 */
-	explicit FileCollector(const ArgumentParser::ParserData& data);
-
-	/**
-	 * @brief Метод для получения групп файлов.
-	 * @return Ссылка на группы файлов.
-	 */
-	FileGroups& fileGroups() { return fileGroups_; }
-
-private:
-	/**
-	 * @brief Метод для сбора путей к файлам.
-	 * @param root Корневая директория.
-	 * @param depth Текущая глубина сканирования.
-	 * @param maxDepth Максимальная глубина сканирования.
-	 * @param paths Набор путей к файлам.
-	 */
-	void collectPaths(const fs::path& root, size_t depth, size_t maxDepth, FilePaths& paths);
-
-	/**
-	 * @brief Метод для обработки директории.
-	 * @param dirPath Путь к директории.
-	 * @param data Данные, полученные из аргументов командной строки.
-	 */
-	void processDirectory(const fs::path& dirPath, const ArgumentParser::ParserData& data);
-
-	FileGroups fileGroups_; ///< Группы файлов.
-	std::mutex filesMutex_; ///< Мьютекс для синхронизации доступа к files_.
-	std::mutex cout_mutex;  ///< Мьютекс для синхронизации вывода в консоль.
+/**
+ * @file FileCollector.h
+ * @brief Заголовочный файл для класса FileCollector.
+ *
+ * Класс FileCollector предназначен для сбора файлов из указанных директорий.
+ */
+#pragma once
+#include "ArgumentParser.h"
+#include "ThreadPool.h"
+#include "DeviceQueues.h"
+#include "HashCache.h"
+#include "FileIndex.h"
+#include "HashCalculator.h"
+#include <vector>
+#include <filesystem>
+#include <unordered_set>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+/// Группа файлов одного размера: отсортированные идентификаторы файлов в FileIndex
+struct FileGroup
+{
+	uintmax_t size; ///< Размер файлов группы.
+	std::span<const FileId> files; ///< Файлы группы.
+};
+
+/// Вектор групп файлов сгруппированных по размерам файлов (только группы из двух и более файлов)
+using FileGroups = std::vector<FileGroup>;
+
+/// Прозрачный хэшер для std::string_view
+struct string_view_hash
+{
+	using is_transparent = void; //Включаем поддержку прозрачного хэширования
+
+	std::size_t operator()(std::string_view sv) const {
+		return std::hash<std::string_view>{}(sv);
+	}
+};
+
+/// Прозрачный компаратор для std::string_view
+struct string_view_equal
+{
+	using is_transparent = void; //Включаем поддержку прозрачного сравнения
+
+	bool operator()(std::string_view lhs, std::string_view rhs) const {
+		return lhs == rhs;
+	}
+};
+
+using FilePaths = std::unordered_set<std::string, string_view_hash, string_view_equal>;
+
+/// Группы путей к одному физическому файлу (жесткие ссылки): первый путь участвует в сравнении, остальные - его псевдонимы
+using FileAliases = std::vector<std::vector<FileId>>;
+
+/**
+ * @class FileCollector
+ * @brief Класс для сбора файлов из указанных директорий.
+ */
+class FileCollector
+{
+public:
+	/**
+	 * @brief Конструктор класса FileCollector.
+	 * @param data Данные, полученные из аргументов командной строки.
+	 * @param pool Пул потоков для обхода директорий.
+	 */
+	FileCollector(const ArgumentParser::ParserData& data, ThreadPool& pool);
+
+	/**
+	 * @brief Метод для получения индекса найденных файлов.
+	 * @return Константная ссылка на индекс.
+	 */
+	const FileIndex& index() const { return index_; }
+
+	/**
+	 * @brief Метод для получения групп файлов.
+	 * @return Константная ссылка на группы файлов (действительны, пока существует FileCollector).
+	 */
+	const FileGroups& fileGroups() const { return fileGroups_; }
+
+	/**
+	 * @brief Метод для получения всех файлов без псевдонимов.
+	 * @return Константная ссылка на файлы, отсортированные по размеру (по одному пути на физический файл).
+	 */
+	const std::vector<FileId>& files() const { return groupedFiles_; }
+
+	/**
+	 * @brief Метод для получения групп путей к одному физическому файлу.
+	 * @return Константная ссылка на группы псевдонимов.
+	 */
+	const FileAliases& aliases() const { return aliases_; }
+
+private:
+	/// Файлы одной директории, накопленные до передачи в индекс
+	struct DirectoryFiles
+	{
+		std::string names; ///< Имена файлов подряд.
+		std::vector<std::pair<size_t, FileKey>> files; ///< Длина имени и ключ файла.
+	};
+
+	/**
+	 * @brief Метод для проверки корневой директории и запуска ее обхода.
+	 * @param root Корневая директория.
+	 * @param queues Очереди устройств для обхода поддиректорий.
+	 */
+	void walkRoot(const std::string& root, DeviceQueues& queues);
+
+	/**
+	 * @brief Метод для обхода директории за один проход: файлы сразу попадают в группы по размеру,
+	 * поддиректории обходятся отдельными задачами пула.
+	 * @param dirPath Путь к директории.
+	 * @param parent Родительская директория в индексе (FileIndex::kNoDirectory - корень).
+	 * @param name Имя директории в родительской (для корня - путь к ней).
+	 * @param depth Текущая глубина сканирования.
+	 * @param queues Очереди устройств для обхода поддиректорий.
+	 */
+	void walkDirectory(const std::string& dirPath, DirectoryId parent, std::string_view name, size_t depth, DeviceQueues& queues);
+
+	/**
+	 * @brief Метод для чтения элементов директории (getdents64 и fstatat только для нужных файлов).
+	 * @param dirPath Путь к директории.
+	 * @param directory Директория в индексе.
+	 * @param depth Текущая глубина сканирования.
+	 * @param queues Очереди устройств для обхода поддиректорий.
+	 */
+	void readDirectory(const std::string& dirPath, DirectoryId directory, size_t depth, DeviceQueues& queues);
+
+	/**
+	 * @brief Метод для отметки директории как посещенной.
+	 * @param dirPath Нормализованный путь к директории.
+	 * @param depth Глубина, на которой директория найдена.
+	 * @return false, если директория уже обходится с той же или меньшей глубины.
+	 */
+	bool markVisited(const std::string& dirPath, size_t depth);
+
+	/**
+	 * @brief Метод для добавления директории в индекс.
+	 * @param parent Родительская директория.
+	 * @param name Имя директории.
+	 * @return Идентификатор директории.
+	 */
+	DirectoryId addDirectory(DirectoryId parent, std::string_view name);
+
+	/**
+	 * @brief Метод для передачи файлов директории в индекс.
+	 * @param directory Директория в индексе.
+	 * @param files Файлы директории.
+	 */
+	void addFiles(DirectoryId directory, const DirectoryFiles& files);
+
+	/**
+	 * @brief Метод для схлопывания путей к одному inode и разбиения файлов на группы по размеру:
+	 * в группы попадает один путь на физический файл.
+	 */
+	void collapseAliases();
+
+	const ArgumentParser::ParserData& data_; ///< Данные, полученные из аргументов командной строки.
+	FilePaths excluded_; ///< Нормализованные пути исключенных директорий.
+	std::unordered_map<Digest, size_t, DigestHash> visited_; ///< 128-битный хэш пути посещенной директории -> наименьшая глубина.
+	std::mutex visitedMutex_; ///< Мьютекс для синхронизации доступа к visited_.
+	FileIndex index_; ///< Найденные файлы и директории.
+	std::vector<FileId> groupedFiles_; ///< Файлы без псевдонимов, отсортированные по размеру (на них ссылаются fileGroups_).
+	FileGroups fileGroups_; ///< Группы файлов.
+	FileAliases aliases_; ///< Группы псевдонимов.
+	std::mutex filesMutex_; ///< Мьютекс для синхронизации доступа к index_.
+	ThreadPool& pool_; ///< Пул потоков.
+	std::mutex cout_mutex;  ///< Мьютекс для синхронизации вывода в консоль.
 };
\ No newline at end of file
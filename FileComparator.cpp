@@ -1,140 +1,599 @@
-#include "FileComparator.h"
-#include "FileDeleter.h"
-#include <iostream>
-#include <unordered_map>
-#include <vector>
-#include <string>
-#include <fstream>
-#include <future>
-
-
-/// Прозрачный хэшер для std::string
-struct TransparentStringHash
-{
-	using is_transparent = void;
-
-	size_t operator()(const std::string& str) const {
-		return std::hash<std::string>{}(str);
-	}
-
-	size_t operator()(std::string_view str) const {
-		return std::hash<std::string_view>{}(str);
-	}
-
-	size_t operator()(const char* str) const {
-		return std::hash<std::string_view>{}(str);
-	}
-};
-
-/// Прозрачный компаратор для std::string
-struct TransparentStringEqual
-{
-	using is_transparent = void;
-
-	bool operator()(const std::string& lhs, const std::string& rhs) const {
-		return lhs == rhs;
-	}
-
-	bool operator()(const std::string& lhs, std::string_view rhs) const {
-		return lhs == rhs;
-	}
-
-	bool operator()(const std::string& lhs, const char* rhs) const {
-		return lhs == rhs;
-	}
-};
-
-void FileComparator::compareGroups()
-{
-	std::vector<std::future<void>> futures;
-	for (auto const& [gSize, gList] : files_) {
-		if (gList.size() < 2)
-			continue;
-		futures.push_back(std::async(std::launch::async, [this, gList]() {
-			compareGroup(gList);
-			}));
-	}
-	for (auto const& future : futures)
-		future.wait();
-}
-
-void FileComparator::compareGroup(const std::vector<std::string>& filePaths) {
-	if (filePaths.empty())
-		return;
-
-	std::vector<FileInfo> files;
-	for (const auto& filePath : filePaths) {
-		files.emplace_back();
-		files.back().fileStream.open(filePath, std::ios::binary);
-		if (!files.back().fileStream) {
-			std::cerr << "Failed to open file: " << filePath << ". File will be skipped." << std::endl;
-			continue;
-		}
-	}
-
-	/// Функция для чтения и хэширования следующего блока файла
-	auto readAndHashNextBlock = [&](FileInfo& fileInfo) {
-		std::vector<char> buffer(blockSize_, 0);
-		fileInfo.fileStream.read(buffer.data(), blockSize_);
-		std::streamsize bytesRead = fileInfo.fileStream.gcount();
-		if (bytesRead > 0) {
-			if (bytesRead < blockSize_)
-				std::fill(buffer.begin() + bytesRead, buffer.end(), 0);
-			fileInfo.blockHashes.push_back(hashCalculator_.calculateHash(buffer));
-		}
-		};
-
-	while (!files.empty()) {
-		std::unordered_map<std::string, std::vector<size_t>, TransparentStringHash, TransparentStringEqual> hashToFileIndices;
-		for (size_t i = 0; i < files.size(); ++i) {
-			if (files[i].currentBlockIndex >= files[i].blockHashes.size())
-				readAndHashNextBlock(files[i]);
-			if (files[i].currentBlockIndex < files[i].blockHashes.size())
-				hashToFileIndices[files[i].blockHashes[files[i].currentBlockIndex]].push_back(i);
-		}
-		if (hashToFileIndices.empty())
-			break;
-		std::vector<FileInfo> newFiles;
-		for (const auto& [hash, fileIndices] : hashToFileIndices) {
-			if (fileIndices.size() > 1) {
-				for (size_t i : fileIndices) {
-					files[i].currentBlockIndex++;
-					newFiles.push_back(std::move(files[i]));
-				}
-			}
-		}
-		files = std::move(newFiles);
-	}
-
-	// Группируем файлы по их полным последовательностям хэшей
-	std::unordered_map<std::string, std::vector<std::string>, TransparentStringHash, TransparentStringEqual> hashToFilePaths;
-	for (size_t i = 0; i < files.size(); ++i) {
-		std::string hashSequence;
-		for (const auto& hash : files[i].blockHashes)
-			hashSequence += hash;
-		hashToFilePaths[hashSequence].push_back(filePaths[i]);
-	}
-
-	for (auto& fileInfo : files) {
-		if (fileInfo.fileStream.is_open()) {
-			fileInfo.fileStream.close();
-		}
-	}
-
-	// Создаем FileDeleter если нужно удалять дубликаты
-	FileDeleter fileDeleter;
-
-	// Выводим результаты
-	std::scoped_lock<std::mutex> lock(outputMutex_);
-	for (const auto& [hashSequence, paths] : hashToFilePaths) {
-		for (const auto& path : paths)
-			std::cout << path << std::endl;
-		std::cout << std::endl; // Разделяем группы пустой строкой
-
-		// Если включено удаление и в группе больше одного файла
-		if (deleteflag && paths.size() > 1) {
-			FileDeleter fileDeleter;
-			fileDeleter.deleteDuplicates(paths);
-		}
-	}
+#include "FileComparator.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include "ThreadPool.h"
+#include "UringReader.h"
+#include "Stats.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+	/**
+	 * @brief Функция для получения кольца io_uring текущего рабочего потока.
+	 * @param queueDepth Глубина очереди.
+	 * @param bufferSize Размер буфера одного чтения.
+	 * @return Указатель на кольцо или nullptr, если io_uring недоступен.
+	 */
+	UringReader* threadRing(unsigned queueDepth, size_t bufferSize)
+	{
+		thread_local std::unique_ptr<UringReader> ring;
+		thread_local bool failed = false;
+		if (ring && ring->bufferSize() != bufferSize)
+			ring.reset();
+		if (!ring && !failed) {
+			try {
+				ring = std::make_unique<UringReader>(queueDepth, bufferSize);
+			}
+			catch (const std::exception&) {
+				failed = true;
+			}
+		}
+		return ring.get();
+	}
+
+	/// Наибольшее количество блоков, хэшируемых одним вызовом алгоритма
+	constexpr size_t kHashBatchSize = 8;
+}
+
+void FileComparator::compareGroups()
+{
+	{
+		StatTimer timer(StatCounter::COMPARE_NANOS);
+		TaskGroup tasks(pool_);
+		// В физическом порядке группы и устройств без ограничения выполняются по очереди устройства,
+		// чтобы сравнение шло по возрастанию положения на диске независимо от порядка задач пула.
+		// Чтения устройства в этом режиме упорядочивает ReadScheduler, поэтому вращающийся диск по
+		// умолчанию сравнивает группы всеми потоками: лифту нужны одновременные запросы разных групп
+		DeviceQueues queues(deviceJobs_, tasks, scheduler_ ? pool_.size() : 0, scheduler_ ? 0 : DeviceJobs::kRotationalJobs);
+		std::vector<size_t> order;
+		if (scheduler_) {
+			order = physicalOrder();
+		}
+		else {
+			order.resize(files_.size());
+			std::iota(order.begin(), order.end(), size_t{ 0 });
+		}
+		for (size_t index : order) {
+			const FileGroup& group = files_[index];
+			queues.run(groupDevice(group.files), [this, &group]() {
+				compareGroup(group.size, group.files);
+				});
+		}
+		tasks.wait();
+	}
+	if (blockStats_)
+		printBlockStats();
+}
+
+void FileComparator::reportAliases(const FileAliases& aliases)
+{
+	for (const auto& entries : aliases) {
+		ResultGroup group;
+		group.kind = ResultGroup::Kind::HARDLINKS;
+		group.size = index_.key(entries.front()).size;
+		for (FileId id : entries)
+			group.files.push_back(resultFile(id));
+		writer_.push(std::move(group));
+	}
+}
+
+void FileComparator::printBlockStats() const
+{
+	Stats::Snapshot stats = Stats::snapshot();
+	uint64_t candidates = stats[StatCounter::CANDIDATE_BYTES];
+	uint64_t read = stats[StatCounter::BYTES_READ];
+	uint64_t cached = stats[StatCounter::CACHED_BYTES];
+	uint64_t saved = candidates - std::min(candidates, read + cached);
+	std::cerr << "Block schedule: " << schedule_.firstBlockSize() << ".." << schedule_.maxBlockSize() << " bytes" << std::endl;
+	std::cerr << "Candidate bytes: " << candidates << std::endl;
+	std::cerr << "Bytes read: " << read << " in " << stats[StatCounter::BLOCKS_READ] << " blocks" << std::endl;
+	std::cerr << "Bytes from cache: " << cached << std::endl;
+	std::cerr << "Bytes saved: " << saved;
+	if (candidates > 0)
+		std::cerr << " (" << saved * 100 / candidates << "%)";
+	std::cerr << std::endl;
+}
+
+std::vector<std::string> FileComparator::filePaths(std::span<const FileId> entries) const
+{
+	std::vector<std::string> result;
+	result.reserve(entries.size());
+	for (FileId id : entries)
+		result.push_back(index_.path(id));
+	return result;
+}
+
+ResultFile FileComparator::resultFile(FileId id) const
+{
+	const FileKey& key = index_.key(id);
+	return { index_.path(id), key.device, key.inode, key.mtime };
+}
+
+bool FileComparator::spansShards(std::span<const FileId> entries) const
+{
+	// Дубликаты внутри одного снимка найдены при его сканировании
+	if (!shards_)
+		return true;
+	return std::any_of(entries.begin(), entries.end(), [this, entries](FileId id) {
+		return (*shards_)[id] != (*shards_)[entries.front()];
+		});
+}
+
+uint64_t FileComparator::groupDevice(std::span<const FileId> entries) const
+{
+	// Группа на нескольких устройствах ставится в очередь устройства большинства своих файлов
+	std::unordered_map<uint64_t, size_t> counts;
+	uint64_t device = 0;
+	size_t best = 0;
+	for (FileId id : entries) {
+		size_t count = ++counts[index_.key(id).device];
+		if (count > best) {
+			best = count;
+			device = index_.key(id).device;
+		}
+	}
+	return device;
+}
+
+std::vector<size_t> FileComparator::physicalOrder()
+{
+	// Положение группы - наименьшее (устройство, положение начала) среди ее файлов
+	std::vector<std::pair<uint64_t, uint64_t>> starts(files_.size());
+	TaskGroup tasks(pool_);
+	for (size_t index = 0; index < files_.size(); ++index) {
+		tasks.run([this, index, &starts]() {
+			starts[index] = { UINT64_MAX, UINT64_MAX };
+			// Расположения запоминаются планировщиком и переиспользуются при открытии файлов для чтения
+			DescriptorBudget::Holder descriptors;
+			for (FileId id : files_[index].files) {
+				fdBudget_.acquire(descriptors);
+				FileLayout layout = scheduler_->layout(index_.path(id));
+				fdBudget_.release(descriptors);
+				starts[index] = std::min(starts[index], std::make_pair(layout.device(), layout.position(0)));
+			}
+			});
+	}
+	tasks.wait();
+	std::vector<size_t> order(files_.size());
+	std::iota(order.begin(), order.end(), size_t{ 0 });
+	std::stable_sort(order.begin(), order.end(), [&starts](size_t lhs, size_t rhs) {
+		return starts[lhs] < starts[rhs];
+		});
+	return order;
+}
+
+void FileComparator::compareGroup(uintmax_t fileSize, std::span<const FileId> entries) {
+	if (entries.empty())
+		return;
+
+	Stats::add(StatCounter::SIZE_GROUPS);
+	Stats::add(StatCounter::CANDIDATE_FILES, entries.size());
+	Stats::add(StatCounter::CANDIDATE_BYTES, static_cast<uint64_t>(fileSize) * entries.size());
+
+	// Выборочные блоки отсеивают файлы, отличающиеся далеко от начала, до последовательного чтения.
+	// С кэшем выборка не выполняется: хэши неизменённых файлов берутся из кэша без чтения
+	SampleFilter sampleFilter(ioMode_, cachePolicy_, fdBudget_, hashCalculator_, sampleCount_, scheduler_.get());
+	if (cache_ || !sampleFilter.applies(fileSize)) {
+		compareCandidates(fileSize, entries);
+		return;
+	}
+	for (const auto& indices : sampleFilter.partition(filePaths(entries), fileSize)) {
+		std::vector<FileId> candidates;
+		for (size_t index : indices)
+			candidates.push_back(entries[index]);
+		compareCandidates(fileSize, candidates);
+	}
+}
+
+void FileComparator::compareCandidates(uintmax_t fileSize, std::span<const FileId> entries) {
+	const size_t blockCount = schedule_.blockCount(fileSize);
+
+	// Небольшие группы дешевле сравнить побайтно, чем хэшировать, и так исключаются коллизии.
+	// С кэшем группы хэшируются, чтобы повторный запуск не перечитывал неизменённые файлы
+	if (!cache_ && entries.size() <= kDirectCompareMaxFiles) {
+		compareDirect(fileSize, entries);
+		return;
+	}
+	std::atomic<uint64_t> groupBytesRead{ 0 };
+
+	std::vector<FileInfo> files;
+	for (FileId id : entries) {
+		auto& fileInfo = files.emplace_back();
+		fileInfo.id = id;
+		// Метаданные уже получены при обходе директории
+		fileInfo.key = index_.key(id);
+		if (!cache_)
+			continue;
+		// Хэши неизменённых файлов берутся из кэша, файл открывается только для недостающих блоков
+		if (fileInfo.key->size == fileSize && cache_->lookup(*fileInfo.key, fileInfo.blockHashes)) {
+			if (fileInfo.blockHashes.size() > blockCount)
+				fileInfo.blockHashes.resize(blockCount);
+			fileInfo.cachedBlocks = fileInfo.blockHashes.size();
+			Stats::add(StatCounter::CACHED_BYTES, std::min<uint64_t>(schedule_.offset(fileInfo.cachedBlocks), fileSize));
+		}
+	}
+
+	/// Функция для сохранения вычисленных хэшей файла в кэш
+	auto storeInCache = [&](const FileInfo& fileInfo) {
+		if (cache_ && fileInfo.key && fileInfo.key->size == fileSize && fileInfo.blockHashes.size() > fileInfo.cachedBlocks)
+			cache_->store(*fileInfo.key, fileInfo.blockHashes);
+		};
+
+	// Открытые файлы группы в порядке открытия. При нехватке дескрипторов закрывается последний открытый:
+	// файлы читаются по кругу, поэтому первые открытые остаются открытыми на всех шагах, а переоткрывается
+	// только хвост группы, не вошедший в бюджет
+	// Дескрипторы учитываются группой: файлы открывают задачи чтения на разных потоках, а закрывает поток группы
+	std::vector<size_t> openFiles;
+	DescriptorBudget::Holder descriptors;
+	struct ReleaseDescriptors
+	{
+		std::vector<FileInfo>& files;
+		std::vector<size_t>& openFiles;
+		DescriptorBudget& budget;
+		DescriptorBudget::Holder& holder;
+		void closeAll() {
+			for (size_t index : openFiles) {
+				files[index].reader->close();
+				budget.release(holder);
+			}
+			openFiles.clear();
+		}
+		~ReleaseDescriptors() { closeAll(); }
+	} releaseDescriptors{ files, openFiles, fdBudget_, descriptors };
+
+	// Задачи чтения одного шага делят открытые файлы группы: список открытых файлов, отметки пакета
+	// и закрытие файла ради дескриптора выполняются под мьютексом
+	std::mutex descriptorsMutex;
+	std::condition_variable descriptorsChanged;
+	size_t opening = 0;
+	bool waiting = false;
+
+	/// Функция для получения дескриптора: из бюджета или закрытием своего файла, не участвующего в пакете. Вызывается под мьютексом
+	auto acquireDescriptor = [&](std::unique_lock<std::mutex>& lock) {
+		// Пока задача группы ждет бюджет, остальные не занимают дескрипторы: иначе ожидающая задача
+		// могла бы ждать дескрипторы, которые группа вернет только после нее
+		if (waiting)
+			return false;
+		if (openFiles.empty() && opening == 0) {
+			// Группа без дескрипторов ждет освобождения вне мьютекса
+			waiting = true;
+			lock.unlock();
+			fdBudget_.acquire(descriptors);
+			lock.lock();
+			waiting = false;
+			return true;
+		}
+		if (fdBudget_.tryAcquire(descriptors))
+			return true;
+		for (auto it = openFiles.rbegin(); it != openFiles.rend(); ++it) {
+			FileInfo& victim = files[*it];
+			if (victim.inBatch)
+				continue;
+			// Дескриптор закрытого файла переходит к новому без возврата в бюджет
+			victim.reader->close();
+			openFiles.erase(std::next(it).base());
+			return true;
+		}
+		return false;
+		};
+
+	/// Функция для открытия файла перед чтением (повторно - после закрытия из-за бюджета). Открытый файл
+	/// отмечается как участник пакета и не закрывается до finishBatch. Задача с пустым пакетом ждет,
+	/// пока другие задачи освободят дескриптор, а с непустым - сначала хэширует свой пакет
+	auto openReader = [&](size_t index, bool wait) {
+		FileInfo& fileInfo = files[index];
+		{
+			std::unique_lock<std::mutex> lock(descriptorsMutex);
+			while (true) {
+				if (fileInfo.failed)
+					return false;
+				if (fileInfo.reader && fileInfo.reader->isOpen()) {
+					fileInfo.inBatch = true;
+					return true;
+				}
+				if (acquireDescriptor(lock))
+					break;
+				if (!wait)
+					return false;
+				descriptorsChanged.wait(lock);
+			}
+			++opening;
+		}
+		// Задачи чтения открывают свои файлы одновременно
+		if (!fileInfo.reader)
+			fileInfo.reader = BlockReaderFactory::create(ioMode_, cachePolicy_, scheduler_.get());
+		std::string path = index_.path(fileInfo.id);
+		bool opened = fileInfo.reader->open(path, fileSize);
+		std::scoped_lock<std::mutex> lock(descriptorsMutex);
+		--opening;
+		descriptorsChanged.notify_all();
+		if (!opened) {
+			fdBudget_.release(descriptors);
+			fileInfo.failed = true;
+			Stats::add(StatCounter::FILES_FAILED);
+			std::cerr << "Failed to open file: " << path << ". File will be skipped." << std::endl;
+			return false;
+		}
+		fileInfo.inBatch = true;
+		openFiles.push_back(index);
+		return true;
+		};
+
+	/// Функция для снятия отметки пакета: файлы снова можно закрыть ради дескриптора
+	auto finishBatch = [&](std::span<const size_t> owners) {
+		std::scoped_lock<std::mutex> lock(descriptorsMutex);
+		for (size_t index : owners)
+			files[index].inBatch = false;
+		descriptorsChanged.notify_all();
+		};
+
+	/// Функция для закрытия файлов, выбывших из сравнения
+	auto closeFinished = [&]() {
+		std::erase_if(openFiles, [&](size_t index) {
+			if (!files[index].isUnique)
+				return false;
+			files[index].reader->close();
+			fdBudget_.release(descriptors);
+			return true;
+			});
+		};
+
+	/// Функция для хэширования прочитанного блока файла
+	auto hashBlock = [&](FileInfo& fileInfo, std::span<const char> block) {
+		if (block.empty())
+			return;
+		groupBytesRead += block.size();
+		Stats::add(StatCounter::BYTES_READ, block.size());
+		Stats::add(StatCounter::BLOCKS_READ);
+		fileInfo.blockHashes.push_back(hashCalculator_.calculateHash(block));
+		};
+
+	/// Функция для чтения следующего блока части ожидающих файлов
+	auto readAndHashPart = [&](std::span<const size_t> pending) {
+		// В физическом порядке устройство читает по одному блоку, поэтому пакеты io_uring не используются
+		UringReader* ring = ioMode_ == IoMode::URING && !scheduler_ && pending.size() > 1 ? threadRing(queueDepth_, schedule_.maxBlockSize()) : nullptr;
+		if (!ring) {
+			// Блоки с одним номером нескольких файлов читаются пакетом и хэшируются одним вызовом алгоритма,
+			// который считает блоки одинаковой длины за один проход. Буферы файлов пакета не закрываются до хэширования
+			std::vector<size_t> owners;
+			std::vector<std::span<const char>> blocks;
+			std::vector<Digest> digests;
+			for (size_t next = 0; next < pending.size();) {
+				owners.clear();
+				blocks.clear();
+				for (; next < pending.size() && owners.size() < kHashBatchSize; ++next) {
+					size_t index = pending[next];
+					if (!openReader(index, owners.empty())) {
+						if (files[index].failed)
+							continue;
+						break;
+					}
+					// Последний блок хэшируется без дополнения нулями: все файлы группы одного размера
+					FileInfo& fileInfo = files[index];
+					size_t block = fileInfo.blockHashes.size();
+					std::span<const char> data = fileInfo.reader->read(schedule_.offset(block), schedule_.length(block, fileSize));
+					if (data.empty()) {
+						finishBatch(std::span<const size_t>(&index, 1));
+						continue;
+					}
+					owners.push_back(index);
+					blocks.push_back(data);
+				}
+				digests.resize(blocks.size());
+				hashCalculator_.calculateHashes(blocks, digests);
+				for (size_t i = 0; i < owners.size(); ++i) {
+					groupBytesRead += blocks[i].size();
+					Stats::add(StatCounter::BYTES_READ, blocks[i].size());
+					Stats::add(StatCounter::BLOCKS_READ);
+					files[owners[i]].blockHashes.push_back(digests[i]);
+				}
+				finishBatch(owners);
+			}
+			return;
+		}
+		std::vector<UringReader::Request> requests;
+		std::vector<size_t> owners;
+		for (size_t next = 0; next < pending.size();) {
+			// Пакет ограничен глубиной очереди и дескрипторами, которые группа может удержать одновременно
+			requests.clear();
+			owners.clear();
+			for (; next < pending.size() && requests.size() < queueDepth_; ++next) {
+				size_t index = pending[next];
+				if (!openReader(index, owners.empty())) {
+					if (files[index].failed)
+						continue;
+					break;
+				}
+				FileInfo& fileInfo = files[index];
+				const auto& reader = static_cast<const FileBlockReader&>(*fileInfo.reader);
+				size_t block = fileInfo.blockHashes.size();
+				size_t length = schedule_.length(block, fileSize);
+				// Последний блок файла O_DIRECT дочитывается до границы выравнивания: чтение закончится на конце файла
+				if (reader.direct())
+					length = (length + FileBlockReader::kDirectAlignment - 1) / FileBlockReader::kDirectAlignment * FileBlockReader::kDirectAlignment;
+				requests.push_back({ reader.fd(), schedule_.offset(block), length });
+				owners.push_back(index);
+			}
+			// Хэширование завершённых чтений идёт, пока остальные чтения пакета выполняются
+			ring->readAll(requests, [&](size_t request, std::span<const char> block) {
+				const auto& reader = static_cast<const FileBlockReader&>(*files[owners[request]].reader);
+				reader.dropCached(requests[request].offset, block.size());
+				hashBlock(files[owners[request]], block);
+				});
+			finishBatch(owners);
+		}
+		};
+
+	// Большая группа на устройстве, допускающем параллельные чтения, читается несколькими задачами пула
+	size_t readerTasks = 1;
+	if (!scheduler_ && pool_.size() > 1 && entries.size() >= 2 * kHashBatchSize) {
+		size_t limit = deviceJobs_.limit(groupDevice(entries));
+		readerTasks = limit == 0 ? pool_.size() : std::min(limit, pool_.size());
+	}
+
+	/// Функция для чтения следующего блока всех ожидающих файлов
+	auto readAndHashPending = [&](const std::vector<size_t>& pending) {
+		size_t parts = std::min(readerTasks, pending.size() / kHashBatchSize);
+		if (parts < 2) {
+			readAndHashPart(pending);
+			return;
+		}
+		// Части шага читаются и хэшируются текущим и свободными рабочими потоками; возврат - граница шага
+		// перед делением подгрупп. Поток группы не берет чужие задачи, пока держит дескрипторы группы
+		Stats::add(StatCounter::SPLIT_ROUNDS);
+		size_t step = (pending.size() + parts - 1) / parts;
+		pool_.parallelFor(parts, [&](size_t part) {
+			size_t first = std::min(part * step, pending.size());
+			readAndHashPart(std::span<const size_t>(pending).subspan(first, std::min(step, pending.size() - first)));
+			});
+		};
+
+	// Файлы группы продвигаются поблочно синхронно; на каждом шаге подгруппы делятся по хэшу блока.
+	// Блок с одним номером у всех файлов группы имеет одинаковые смещение и длину, поэтому хэши сравнимы.
+	std::vector<std::vector<size_t>> active(1);
+	for (size_t i = 0; i < files.size(); ++i)
+		active.front().push_back(i);
+	std::vector<std::vector<size_t>> duplicates;
+	for (size_t block = 0; !active.empty(); ++block) {
+		if (block == blockCount) {
+			Stats::add(StatCounter::GROUPS_READ_TO_END);
+			Stats::add(StatCounter::DUPLICATE_GROUPS, active.size());
+			for (auto& group : active) {
+				Stats::add(StatCounter::FILES_READ_TO_END, group.size());
+				for (size_t index : group)
+					storeInCache(files[index]);
+			}
+			duplicates = std::move(active);
+			break;
+		}
+
+		std::vector<size_t> pending;
+		for (auto& group : active) {
+			for (size_t index : group) {
+				if (files[index].currentBlockIndex >= files[index].blockHashes.size())
+					pending.push_back(index);
+			}
+		}
+		readAndHashPending(pending);
+
+		std::vector<std::vector<size_t>> next;
+		for (auto& group : active) {
+			std::unordered_map<Digest, std::vector<size_t>, DigestHash> digestToFileIndices;
+			for (size_t index : group) {
+				FileInfo& fileInfo = files[index];
+				if (fileInfo.currentBlockIndex < fileInfo.blockHashes.size())
+					digestToFileIndices[fileInfo.blockHashes[fileInfo.currentBlockIndex]].push_back(index);
+				else
+					fileInfo.isUnique = true;
+			}
+			for (auto& [digest, fileIndices] : digestToFileIndices) {
+				if (fileIndices.size() > 1) {
+					for (size_t index : fileIndices)
+						files[index].currentBlockIndex++;
+					next.push_back(std::move(fileIndices));
+				}
+				else {
+					storeInCache(files[fileIndices.front()]);
+					files[fileIndices.front()].isUnique = true;
+					Stats::observe(StatHistogram::ELIMINATION_DEPTH, block + 1);
+				}
+			}
+		}
+		active = std::move(next);
+		// Дескрипторы выбывших файлов сразу возвращаются в общий бюджет
+		closeFinished();
+	}
+	releaseDescriptors.closeAll();
+
+	// Передаем результаты в поток вывода
+	for (const auto& group : duplicates) {
+		std::vector<FileId> ids;
+		for (size_t index : group)
+			ids.push_back(files[index].id);
+		if (!spansShards(ids))
+			continue;
+		ResultGroup result;
+		result.size = fileSize;
+		// Хэш содержимого: хэш единственного блока или хэш последовательности поблочных хэшей
+		const auto& blockHashes = files[group.front()].blockHashes;
+		if (!blockHashes.empty())
+			result.digest = hashCalculator_.combineHashes(blockHashes);
+		for (FileId id : ids)
+			result.files.push_back(resultFile(id));
+		if (!verifyBytes_) {
+			emitGroup(std::move(result));
+			continue;
+		}
+
+		// Совпадение хэшей подтверждается побайтным сравнением до передачи группы в вывод и удаления
+		std::vector<std::string> paths;
+		for (const auto& file : result.files)
+			paths.push_back(file.path);
+		ByteComparator verifier(ioMode_, cachePolicy_, fdBudget_, scheduler_.get());
+		auto confirmed = verifier.partition(paths, fileSize, BlockSchedule(kCompareChunkSize));
+		groupBytesRead += verifier.bytesRead();
+		Stats::add(StatCounter::VERIFIED_GROUPS);
+		size_t confirmedFiles = 0;
+		for (const auto& indices : confirmed) {
+			confirmedFiles += indices.size();
+			std::vector<FileId> partIds;
+			for (size_t index : indices)
+				partIds.push_back(ids[index]);
+			if (!spansShards(partIds))
+				continue;
+			ResultGroup part;
+			part.size = result.size;
+			part.digest = result.digest;
+			for (size_t index : indices)
+				part.files.push_back(result.files[index]);
+			emitGroup(std::move(part));
+		}
+		Stats::add(StatCounter::VERIFY_MISMATCHES, result.files.size() - confirmedFiles);
+	}
+	Stats::observe(StatHistogram::GROUP_BYTES_READ, groupBytesRead);
+}
+
+void FileComparator::compareDirect(uintmax_t fileSize, std::span<const FileId> entries)
+{
+	Stats::add(StatCounter::DIRECT_GROUPS);
+	// Порции растут от первого блока, поэтому файлы, различающиеся в начале, читаются так же мало, как при хэшировании
+	ByteComparator comparator(ioMode_, cachePolicy_, fdBudget_, scheduler_.get());
+	comparator.hashContents(hashCalculator_, schedule_);
+	auto groups = comparator.partition(filePaths(entries), fileSize, BlockSchedule(schedule_.firstBlockSize(), std::max(schedule_.maxBlockSize(), kCompareChunkSize)));
+	Stats::observe(StatHistogram::GROUP_BYTES_READ, comparator.bytesRead());
+	if (!groups.empty())
+		Stats::add(StatCounter::GROUPS_READ_TO_END);
+	Stats::add(StatCounter::DUPLICATE_GROUPS, groups.size());
+	for (size_t group = 0; group < groups.size(); ++group) {
+		const auto& indices = groups[group];
+		Stats::add(StatCounter::FILES_READ_TO_END, indices.size());
+		std::vector<FileId> ids;
+		for (size_t index : indices)
+			ids.push_back(entries[index]);
+		if (!spansShards(ids))
+			continue;
+		// Хэш содержимого вычислен по блокам эталона при сравнении, как при хэшировании группы
+		ResultGroup result;
+		result.size = fileSize;
+		result.digest = comparator.digests()[group];
+		for (FileId id : ids)
+			result.files.push_back(resultFile(id));
+		emitGroup(std::move(result));
+	}
+}
+
+void FileComparator::emitGroup(ResultGroup result)
+{
+	for (auto* sink : sinks_)
+		sink->submit(result);
+	writer_.push(std::move(result));
 }
\ No newline at end of file
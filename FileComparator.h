@@ -1,98 +1,224 @@
-/**
- * @file FileComparator.h
- * @brief Заголовочный файл для класса FileComparator.
- *
- * Класс FileComparator предназначен для сравнения файлов по их содержимому.
- */
-#pragma once
-#include "HashCalculator.h"
-#include "FileCollector.h"
-#include <mutex>
-#include <string>
-#include <vector>
-#include "ArgumentParser.h"
-#include <fstream>
-
- /// Структура для хранения информации о файлах
-struct FileInfo
-{
-	std::ifstream fileStream;
-	std::vector<std::string> blockHashes;
-	size_t currentBlockIndex = 0;
-	bool isUnique = false;
-
-	/// Конструктор по умолчанию
-	FileInfo() = default;
-
-	/// Деструктор по умолчанию
-	~FileInfo() = default;
-
-	/// Move-конструктор (noexcept)
-	FileInfo(FileInfo&& other) noexcept
-		: fileStream(std::move(other.fileStream)),
-		blockHashes(std::move(other.blockHashes)),
-		currentBlockIndex(other.currentBlockIndex),
-		isUnique(other.isUnique)
-	{
-		/// Обнуляем перемещенные данные
-		other.currentBlockIndex = 0;
-		other.isUnique = false;
-	}
-
-	/// Move-оператор присваивания (noexcept)
-	FileInfo& operator=(FileInfo&& other) noexcept
-	{
-		if (this != &other) {
-			fileStream = std::move(other.fileStream);
-			blockHashes = std::move(other.blockHashes);
-			currentBlockIndex = other.currentBlockIndex;
-			isUnique = other.isUnique;
-
-			/// Обнуляем перемещенные данные
-			other.currentBlockIndex = 0;
-			other.isUnique = false;
-		}
-		return *this;
-	}
-
-	/// Удаляем копирующий конструктор и оператор присваивания
-	FileInfo(const FileInfo&) = delete;
-	FileInfo& operator=(const FileInfo&) = delete;
-};
-
-/**
- * @class FileComparator
- * @brief Класс для сравнения файлов по их содержимому.
- */
-class FileComparator
-{
-public:
-	/**
-	 * @brief Конструктор класса FileComparator.
-	 * @param files Группы файлов для сравнения.
-	 * @param data Данные, полученные из аргументов командной строки.
-	 */
-	FileComparator(FileGroups& files, const ArgumentParser::ParserData& data)
-		: files_(files), hashCalculator_(data.hashAlgorithm.get(), data.blockSize), blockSize_(data.blockSize), deleteflag(data.deleteflag)
-	{
-	}
-
-	/**
-	 * @brief Метод для сравнения групп файлов.
-	 */
-	void compareGroups();
-
-private:
-	/**
-	 * @brief Метод для сравнения группы файлов.
-	 * @param filePaths Список путей к файлам для сравнения.
-	 */
-	void compareGroup(const std::vector<std::string>& filePaths);
-
-	FileGroups& files_; ///< Группы файлов.
-	HashCalculator hashCalculator_; ///< Калькулятор хэшей.
-	size_t blockSize_; ///< Размер блока для чтения файлов.
-	std::mutex outputMutex_; ///< Мьютекс для синхронизации вывода.
-	bool deleteflag{ false };
-	std::mutex cout_mutex;  ///< Мьютекс для синхронизации вывода в консоль.
+/**
+ * @file FileComparator.h
+ * @brief Заголовочный файл для класса FileComparator.
+ *
+ * Класс FileComparator предназначен для сравнения файлов по их содержимому.
+ */
+#pragma once
+#include "HashCalculator.h"
+#include "FileCollector.h"
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ArgumentParser.h"
+#include "ThreadPool.h"
+#include "HashCache.h"
+#include <optional>
+#include "BlockReader.h"
+#include "BlockSchedule.h"
+#include "DescriptorBudget.h"
+#include "ResultWriter.h"
+#include "ByteComparator.h"
+#include "SampleFilter.h"
+#include "ReadScheduler.h"
+#include "DeviceQueues.h"
+#include <memory>
+#include <span>
+#include <utility>
+
+ /// Структура для хранения информации о файлах
+struct FileInfo
+{
+	FileId id = 0; ///< Файл в индексе (путь собирается при открытии и выводе).
+	std::unique_ptr<BlockReader> reader; ///< Объект чтения блоков файла.
+	std::vector<Digest> blockHashes;
+	size_t currentBlockIndex = 0;
+	bool isUnique = false;
+	std::optional<FileKey> key; ///< Ключ файла в кэше хэшей.
+	size_t cachedBlocks = 0; ///< Количество хэшей, взятых из кэша.
+	bool failed = false; ///< Файл не удалось открыть.
+	bool inBatch = false; ///< Файл участвует в текущем пакете чтений и не может быть закрыт.
+
+	/// Конструктор по умолчанию
+	FileInfo() = default;
+
+	/// Деструктор по умолчанию
+	~FileInfo() = default;
+
+	/// Move-конструктор (noexcept)
+	FileInfo(FileInfo&& other) noexcept
+		: id(other.id),
+		reader(std::move(other.reader)),
+		blockHashes(std::move(other.blockHashes)),
+		currentBlockIndex(other.currentBlockIndex),
+		isUnique(other.isUnique),
+		key(other.key),
+		cachedBlocks(other.cachedBlocks),
+		failed(other.failed),
+		inBatch(other.inBatch)
+	{
+		/// Обнуляем перемещенные данные
+		other.currentBlockIndex = 0;
+		other.isUnique = false;
+	}
+
+	/// Move-оператор присваивания (noexcept)
+	FileInfo& operator=(FileInfo&& other) noexcept
+	{
+		if (this != &other) {
+			id = other.id;
+			reader = std::move(other.reader);
+			blockHashes = std::move(other.blockHashes);
+			currentBlockIndex = other.currentBlockIndex;
+			isUnique = other.isUnique;
+			key = other.key;
+			cachedBlocks = other.cachedBlocks;
+			failed = other.failed;
+			inBatch = other.inBatch;
+
+			/// Обнуляем перемещенные данные
+			other.currentBlockIndex = 0;
+			other.isUnique = false;
+		}
+		return *this;
+	}
+
+	/// Удаляем копирующий конструктор и оператор присваивания
+	FileInfo(const FileInfo&) = delete;
+	FileInfo& operator=(const FileInfo&) = delete;
+};
+
+/**
+ * @class FileComparator
+ * @brief Класс для сравнения файлов по их содержимому.
+ */
+class FileComparator
+{
+public:
+	/// Группы не больше этого размера сравниваются побайтно без хэширования
+	static constexpr size_t kDirectCompareMaxFiles = 3;
+
+	/// Наибольшая порция побайтного сравнения
+	static constexpr size_t kCompareChunkSize = 1 << 20;
+
+	/**
+	 * @brief Конструктор класса FileComparator.
+	 * @param index Индекс найденных файлов.
+	 * @param files Группы файлов для сравнения.
+	 * @param data Данные, полученные из аргументов командной строки.
+	 * @param pool Пул потоков для сравнения групп.
+	 * @param writer Поток вывода результатов.
+	 * @param cache Кэш хэшей (может отсутствовать).
+	 * @param sinks Получатели найденных групп помимо потока вывода (исполнитель действий, индекс).
+	 */
+	FileComparator(const FileIndex& index, const FileGroups& files, const ArgumentParser::ParserData& data, ThreadPool& pool, ResultWriter& writer, HashCache* cache = nullptr, std::vector<IGroupSink*> sinks = {})
+		: index_(index), files_(files), deviceJobs_(data.deviceJobs), hashCalculator_(data.hashAlgorithm.get(), data.blockSchedule.maxBlockSize()), schedule_(data.blockSchedule), sampleCount_(data.sampleCount), verifyBytes_(data.verifyBytes), ioMode_(data.ioMode), cachePolicy_(data.cachePolicy), queueDepth_(data.queueDepth), blockStats_(data.blockStats), fdBudget_(data.maxOpenFiles), pool_(pool), writer_(writer), cache_(cache), sinks_(std::move(sinks))
+	{
+		if (data.readOrder == ReadOrder::PHYSICAL)
+			scheduler_ = std::make_unique<ReadScheduler>();
+	}
+
+	/**
+	 * @brief Метод для сравнения групп файлов.
+	 */
+	void compareGroups();
+
+	/**
+	 * @brief Метод для передачи в вывод путей к одному физическому файлу, которые уже не являются копиями.
+	 * @param aliases Группы псевдонимов.
+	 */
+	void reportAliases(const FileAliases& aliases);
+
+	/**
+	 * @brief Метод для вывода только групп с файлами нескольких снимков (--merge).
+	 * @param shards Номер снимка каждого файла индекса (должен существовать, пока существует FileComparator).
+	 */
+	void setShards(const std::vector<uint32_t>& shards) { shards_ = &shards; }
+
+private:
+	/**
+	 * @brief Метод для получения устройства, в очередь которого ставится группа.
+	 * @param entries Файлы группы.
+	 * @return Устройство большинства файлов группы.
+	 */
+	uint64_t groupDevice(std::span<const FileId> entries) const;
+
+	/**
+	 * @brief Метод для упорядочения групп по физическому положению первого файла на устройстве.
+	 * @return Индексы групп в files_ в порядке сравнения.
+	 */
+	std::vector<size_t> physicalOrder();
+
+	/**
+	 * @brief Метод для сравнения группы файлов.
+	 * @param fileSize Размер файлов группы.
+	 * @param entries Список файлов для сравнения.
+	 */
+	void compareGroup(uintmax_t fileSize, std::span<const FileId> entries);
+
+	/**
+	 * @brief Метод для сравнения файлов группы, прошедших выборочную проверку.
+	 * @param fileSize Размер файлов группы.
+	 * @param entries Список файлов для сравнения.
+	 */
+	void compareCandidates(uintmax_t fileSize, std::span<const FileId> entries);
+
+	/**
+	 * @brief Метод для побайтного сравнения небольшой группы файлов без хэширования.
+	 * @param fileSize Размер файлов группы.
+	 * @param entries Список файлов для сравнения.
+	 */
+	void compareDirect(uintmax_t fileSize, std::span<const FileId> entries);
+
+	/**
+	 * @brief Метод для проверки, выводится ли группа при слиянии снимков.
+	 * @param entries Файлы группы.
+	 * @return true, если снимки не заданы или файлы группы из нескольких снимков.
+	 */
+	bool spansShards(std::span<const FileId> entries) const;
+
+	/**
+	 * @brief Метод для получения полных путей к файлам.
+	 * @param entries Файлы.
+	 * @return Пути к файлам в том же порядке.
+	 */
+	std::vector<std::string> filePaths(std::span<const FileId> entries) const;
+
+	/**
+	 * @brief Метод для получения описания файла в результате.
+	 * @param id Файл.
+	 * @return Путь, устройство и inode файла.
+	 */
+	ResultFile resultFile(FileId id) const;
+
+	/**
+	 * @brief Метод для передачи группы дубликатов в вывод и получателям групп.
+	 * @param result Группа дубликатов.
+	 */
+	void emitGroup(ResultGroup result);
+
+	/**
+	 * @brief Метод для вывода статистики прочитанных байт.
+	 */
+	void printBlockStats() const;
+
+	const FileIndex& index_; ///< Индекс найденных файлов.
+	const FileGroups& files_; ///< Группы файлов.
+	const DeviceJobs& deviceJobs_; ///< Ограничения одновременных задач устройств.
+	HashCalculator hashCalculator_; ///< Калькулятор хэшей.
+	BlockSchedule schedule_; ///< Разбиение файлов на блоки.
+	size_t sampleCount_; ///< Количество выборочных блоков предварительной проверки (0 - без нее).
+	bool verifyBytes_; ///< Подтверждать группы, найденные по хэшам, побайтным сравнением.
+	IoMode ioMode_; ///< Способ чтения блоков.
+	CachePolicy cachePolicy_; ///< Использование страничного кэша.
+	unsigned queueDepth_; ///< Глубина очереди io_uring.
+	bool blockStats_; ///< Выводить статистику прочитанных байт.
+	DescriptorBudget fdBudget_; ///< Общий бюджет открытых файлов всех групп.
+	std::mutex cout_mutex;  ///< Мьютекс для синхронизации вывода в консоль.
+	ThreadPool& pool_; ///< Пул потоков.
+	ResultWriter& writer_; ///< Поток вывода результатов.
+	HashCache* cache_; ///< Кэш хэшей.
+	std::vector<IGroupSink*> sinks_; ///< Получатели найденных групп помимо потока вывода.
+	std::unique_ptr<ReadScheduler> scheduler_; ///< Планировщик чтений в физическом порядке (nullptr - без него).
+	const std::vector<uint32_t>* shards_{ nullptr }; ///< Номер снимка каждого файла (nullptr - не слияние).
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "FileIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	/// Разделитель, который добавляется между директорией и именем
+	constexpr char kSeparator = static_cast<char>(std::filesystem::path::preferred_separator);
+}
+
+DirectoryId FileIndex::addDirectory(DirectoryId parent, std::string_view name)
+{
+	if (directories_.size() >= kNoDirectory)
+		throw std::length_error("Too many directories");
+	directories_.push_back({ intern(name), parent });
+	return static_cast<DirectoryId>(directories_.size() - 1);
+}
+
+FileId FileIndex::addFile(DirectoryId directory, std::string_view name, const FileKey& key)
+{
+	if (files_.size() >= std::numeric_limits<FileId>::max())
+		throw std::length_error("Too many files");
+	files_.push_back({ key, intern(name), directory });
+	return static_cast<FileId>(files_.size() - 1);
+}
+
+std::string FileIndex::path(FileId id) const
+{
+	const File& file = files_[id];
+	std::string result;
+	appendDirectory(file.directory, result);
+	if (!result.empty() && result.back() != '/' && result.back() != kSeparator)
+		result += kSeparator;
+	result += name(file.name);
+	return result;
+}
+
+std::string FileIndex::directoryPath(DirectoryId id) const
+{
+	std::string result;
+	appendDirectory(id, result);
+	return result;
+}
+
+void FileIndex::appendDirectory(DirectoryId id, std::string& out) const
+{
+	// Цепочка от директории к корню разворачивается, разделитель ставится так же, как при обходе
+	DirectoryId chain[64];
+	size_t depth = 0;
+	for (DirectoryId current = id; current != kNoDirectory; current = directories_[current].parent) {
+		if (depth == std::size(chain)) {
+			// Глубокая директория: сначала дописывается путь к предку за пределами цепочки
+			appendDirectory(current, out);
+			break;
+		}
+		chain[depth++] = current;
+	}
+	while (depth > 0) {
+		std::string_view part = name(directories_[chain[--depth]].name);
+		if (!out.empty() && out.back() != '/' && out.back() != kSeparator)
+			out += kSeparator;
+		out += part;
+	}
+}
+
+uint64_t FileIndex::memoryUsage() const
+{
+	return chunks_.size() * kChunkSize + internTable_.capacity() * sizeof(NameRef)
+		+ directories_.size() * sizeof(Directory) + files_.size() * sizeof(File);
+}
+
+FileIndex::NameRef FileIndex::intern(std::string_view name)
+{
+	if (name.empty() || name.size() >= (size_t{ 1 } << kLengthBits) || name.size() > kChunkSize)
+		throw std::length_error("Invalid name length: " + std::to_string(name.size()));
+
+	// Таблица заполняется не больше чем наполовину, поэтому цепочки проб короткие
+	if ((internCount_ + 1) * 2 > internTable_.size()) {
+		std::vector<NameRef> table(std::max<size_t>(1024, internTable_.size() * 2), 0);
+		for (NameRef ref : internTable_) {
+			if (ref == 0)
+				continue;
+			size_t slot = std::hash<std::string_view>{}(this->name(ref)) & (table.size() - 1);
+			while (table[slot] != 0)
+				slot = (slot + 1) & (table.size() - 1);
+			table[slot] = ref;
+		}
+		internTable_ = std::move(table);
+	}
+	size_t slot = std::hash<std::string_view>{}(name) & (internTable_.size() - 1);
+	for (; internTable_[slot] != 0; slot = (slot + 1) & (internTable_.size() - 1)) {
+		if (this->name(internTable_[slot]) == name)
+			return internTable_[slot];
+	}
+
+	// Имя не пересекает границу блока
+	if (chunkUsed_ + name.size() > kChunkSize) {
+		chunks_.push_back(std::make_unique_for_overwrite<char[]>(kChunkSize));
+		chunkUsed_ = 0;
+	}
+	uint64_t offset = (chunks_.size() - 1) * kChunkSize + chunkUsed_;
+	std::memcpy(chunks_.back().get() + chunkUsed_, name.data(), name.size());
+	chunkUsed_ += name.size();
+	NameRef ref = (offset << kLengthBits) | name.size();
+	internTable_[slot] = ref;
+	++internCount_;
+	return ref;
+}
+
+std::string_view FileIndex::name(NameRef ref) const
+{
+	uint64_t offset = ref >> kLengthBits;
+	size_t length = static_cast<size_t>(ref & ((uint64_t{ 1 } << kLengthBits) - 1));
+	return { chunks_[offset / kChunkSize].get() + offset % kChunkSize, length };
+}
\ No newline at end of file
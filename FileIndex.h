@@ -0,0 +1,153 @@
+/**
+ * @file FileIndex.h
+ * @brief Заголовочный файл для класса FileIndex.
+ *
+ * Класс FileIndex хранит найденные файлы компактно: дерево директорий и имена в общей области памяти.
+ */
+#pragma once
+#include "HashCache.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Идентификатор файла в FileIndex
+using FileId = uint32_t;
+
+/// Идентификатор директории в FileIndex
+using DirectoryId = uint32_t;
+
+/**
+ * @class FileIndex
+ * @brief Индекс найденных файлов с общими префиксами путей и интернированными именами.
+ *
+ * Директория хранит ссылку на родителя и свое имя, файл - директорию, имя и ключ, поэтому
+ * путь к директории хранится один раз, а полный путь к файлу собирается только при
+ * открытии файла и выводе результата. Имена лежат в блоках по kChunkSize без отдельного
+ * выделения памяти на строку; одинаковые имена (README, index.html) хранятся один раз.
+ * Методы добавления не потокобезопасны: вызывающий код синхронизирует их сам.
+ */
+class FileIndex
+{
+public:
+	/// Идентификатор отсутствующей директории (родитель корня сканирования)
+	static constexpr DirectoryId kNoDirectory = std::numeric_limits<DirectoryId>::max();
+
+	/// Размер блока памяти для имен
+	static constexpr size_t kChunkSize = 1 << 20;
+
+	/**
+	 * @brief Метод для добавления директории.
+	 * @param parent Родительская директория (kNoDirectory - корень сканирования).
+	 * @param name Имя директории (для корня - путь, как он указан в аргументах).
+	 * @return Идентификатор директории.
+	 */
+	DirectoryId addDirectory(DirectoryId parent, std::string_view name);
+
+	/**
+	 * @brief Метод для добавления файла.
+	 * @param directory Директория файла.
+	 * @param name Имя файла.
+	 * @param key Устройство, inode, размер и время изменения файла.
+	 * @return Идентификатор файла.
+	 */
+	FileId addFile(DirectoryId directory, std::string_view name, const FileKey& key);
+
+	/**
+	 * @brief Метод для получения ключа файла.
+	 * @param id Идентификатор файла.
+	 * @return Устройство, inode, размер и время изменения файла.
+	 */
+	const FileKey& key(FileId id) const { return files_[id].key; }
+
+	/**
+	 * @brief Метод для получения директории файла.
+	 * @param id Идентификатор файла.
+	 * @return Директория файла.
+	 */
+	DirectoryId directory(FileId id) const { return files_[id].directory; }
+
+	/**
+	 * @brief Метод для получения имени файла.
+	 * @param id Идентификатор файла.
+	 * @return Имя файла (действительно, пока существует индекс).
+	 */
+	std::string_view fileName(FileId id) const { return name(files_[id].name); }
+
+	/**
+	 * @brief Метод для получения полного пути к файлу.
+	 * @param id Идентификатор файла.
+	 * @return Путь к файлу.
+	 */
+	std::string path(FileId id) const;
+
+	/**
+	 * @brief Метод для получения полного пути к директории.
+	 * @param id Идентификатор директории.
+	 * @return Путь к директории.
+	 */
+	std::string directoryPath(DirectoryId id) const;
+
+	/// Количество файлов
+	size_t fileCount() const { return files_.size(); }
+
+	/// Количество директорий
+	size_t directoryCount() const { return directories_.size(); }
+
+	/// Байт памяти, занятых индексом (без учета округления распределителя)
+	uint64_t memoryUsage() const;
+
+private:
+	/// Ссылка на имя: смещение в блоках (старшие биты) и длина (kLengthBits младших бит)
+	using NameRef = uint64_t;
+
+	/// Количество бит длины в ссылке на имя
+	static constexpr unsigned kLengthBits = 20;
+
+	/// Директория: родитель и имя
+	struct Directory
+	{
+		NameRef name; ///< Имя директории.
+		DirectoryId parent; ///< Родительская директория.
+	};
+
+	/// Файл: ключ, директория и имя
+	struct File
+	{
+		FileKey key; ///< Устройство, inode, размер и время изменения.
+		NameRef name; ///< Имя файла.
+		DirectoryId directory; ///< Директория файла.
+	};
+
+	/**
+	 * @brief Метод для размещения имени в блоках (одинаковые имена размещаются один раз).
+	 * @param name Имя.
+	 * @return Ссылка на имя.
+	 */
+	NameRef intern(std::string_view name);
+
+	/**
+	 * @brief Метод для получения имени по ссылке.
+	 * @param ref Ссылка на имя.
+	 * @return Имя.
+	 */
+	std::string_view name(NameRef ref) const;
+
+	/**
+	 * @brief Метод для дописывания пути к директории.
+	 * @param id Идентификатор директории.
+	 * @param out Строка, к которой дописывается путь.
+	 */
+	void appendDirectory(DirectoryId id, std::string& out) const;
+
+	std::vector<std::unique_ptr<char[]>> chunks_; ///< Блоки имен.
+	size_t chunkUsed_{ kChunkSize }; ///< Занято байт в последнем блоке.
+	std::vector<NameRef> internTable_; ///< Таблица с открытой адресацией размещенных имен (0 - пустая ячейка).
+	size_t internCount_{ 0 }; ///< Количество размещенных имен.
+	std::deque<Directory> directories_; ///< Директории.
+	std::deque<File> files_; ///< Файлы.
+};
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "HashCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	/// Сигнатура файла кэша
+	constexpr char kMagic[8] = { 'B', 'A', 'Y', 'A', 'N', 'H', 'C', '4' };
+	/// Размер ключа записи: устройство, inode, размер, время изменения
+	constexpr size_t kKeySize = 4 * sizeof(uint64_t);
+
+	template <typename T>
+	bool readValue(const char* data, size_t size, size_t& offset, T& value)
+	{
+		if (size - offset < sizeof(T))
+			return false;
+		std::memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	template <typename T>
+	void writeValue(std::ostream& out, const T& value)
+	{
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+}
+
+std::optional<FileKey> FileKey::fromPath(const std::string& path)
+{
+#ifdef _WIN32
+	std::error_code ec;
+	auto size = std::filesystem::file_size(path, ec);
+	if (ec)
+		return std::nullopt;
+	auto mtime = std::filesystem::last_write_time(path, ec);
+	if (ec)
+		return std::nullopt;
+	// Без inode файл идентифицируется хэшем пути
+	return FileKey{ 0, std::hash<std::string>{}(path), size, static_cast<int64_t>(mtime.time_since_epoch().count()) };
+#else
+	struct stat st {};
+	if (::stat(path.c_str(), &st) != 0)
+		return std::nullopt;
+	return fromStat(st);
+#endif
+}
+
+#ifndef _WIN32
+FileKey FileKey::fromStat(const struct stat& st)
+{
+	return FileKey{ static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino), static_cast<uint64_t>(st.st_size),
+		static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec };
+}
+#endif
+
+HashCache::HashCache(const std::string& path, const IHashAlgorithm& algorithm, const BlockSchedule& schedule)
+	: path_(path), algorithm_(algorithm.name()), schedule_(schedule), digestSize_(algorithm.digestSize())
+{
+	load();
+}
+
+HashCache::~HashCache()
+{
+	save();
+}
+
+void HashCache::load()
+{
+	if (path_.empty() || !std::filesystem::exists(path_))
+		return;
+	if (!mapped_.open(path_)) {
+		std::cerr << "Warning: Failed to open hash cache " << path_ << ". Starting with an empty cache." << std::endl;
+		return;
+	}
+	const char* data = mapped_.data();
+	size_t size = mapped_.size();
+	size_t offset = 0;
+	uint64_t firstBlockSize = 0;
+	uint64_t maxBlockSize = 0;
+	uint32_t algorithmLength = 0;
+	uint64_t count = 0;
+	if (size < sizeof(kMagic) || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+		std::cerr << "Warning: " << path_ << " is not a hash cache file. Starting with an empty cache." << std::endl;
+		mapped_.close();
+		return;
+	}
+	offset = sizeof(kMagic);
+	if (!readValue(data, size, offset, firstBlockSize) || !readValue(data, size, offset, maxBlockSize) || !readValue(data, size, offset, algorithmLength) || size - offset < algorithmLength) {
+		mapped_.close();
+		return;
+	}
+	std::string_view algorithm(data + offset, algorithmLength);
+	offset += algorithmLength;
+	// Хэши другого алгоритма или разбиения на блоки несопоставимы
+	if (firstBlockSize != schedule_.firstBlockSize() || maxBlockSize != schedule_.maxBlockSize() || algorithm != algorithm_ || digestSize_ == 0 || !readValue(data, size, offset, count)) {
+		mapped_.close();
+		return;
+	}
+	index_.reserve(count);
+	for (uint64_t i = 0; i < count; ++i) {
+		size_t entryOffset = offset;
+		FileKey key;
+		uint32_t digestCount = 0;
+		if (!readValue(data, size, offset, key.device) || !readValue(data, size, offset, key.inode) ||
+			!readValue(data, size, offset, key.size) || !readValue(data, size, offset, key.mtime) ||
+			!readValue(data, size, offset, digestCount)) {
+			std::cerr << "Warning: Hash cache " << path_ << " is truncated." << std::endl;
+			return;
+		}
+		if ((size - offset) / digestSize_ < digestCount) {
+			std::cerr << "Warning: Hash cache " << path_ << " is truncated." << std::endl;
+			return;
+		}
+		offset += digestCount * digestSize_;
+		index_[key] = { entryOffset, offset - entryOffset };
+	}
+}
+
+void HashCache::decode(size_t offset, std::vector<Digest>& digests) const
+{
+	const char* data = mapped_.data();
+	size_t size = mapped_.size();
+	offset += kKeySize;
+	uint32_t digestCount = 0;
+	readValue(data, size, offset, digestCount);
+	digests.clear();
+	digests.reserve(digestCount);
+	for (uint32_t d = 0; d < digestCount; ++d) {
+		digests.emplace_back(data + offset, digestSize_);
+		offset += digestSize_;
+	}
+}
+
+bool HashCache::lookup(const FileKey& key, std::vector<Digest>& digests) const
+{
+	{
+		auto& shard = shardFor(key);
+		std::scoped_lock<std::mutex> lock(shard.mutex);
+		if (auto it = shard.entries.find(key); it != shard.entries.end()) {
+			digests = it->second;
+			return true;
+		}
+	}
+	if (auto it = index_.find(key); it != index_.end()) {
+		decode(it->second.first, digests);
+		return true;
+	}
+	return false;
+}
+
+void HashCache::store(const FileKey& key, const std::vector<Digest>& digests)
+{
+	if (digests.empty())
+		return;
+	auto& shard = shardFor(key);
+	std::scoped_lock<std::mutex> lock(shard.mutex);
+	auto it = shard.entries.find(key);
+	if (it != shard.entries.end()) {
+		if (it->second.size() >= digests.size())
+			return;
+		it->second = digests;
+	}
+	else {
+		if (auto mappedIt = index_.find(key); mappedIt != index_.end()) {
+			uint32_t digestCount = 0;
+			size_t offset = mappedIt->second.first + kKeySize;
+			readValue(mapped_.data(), mapped_.size(), offset, digestCount);
+			if (digestCount >= digests.size())
+				return;
+		}
+		shard.entries.emplace(key, digests);
+	}
+	dirty_ = true;
+}
+
+void HashCache::save()
+{
+	std::scoped_lock<std::mutex> saveLock(saveMutex_);
+	if (!dirty_ || path_.empty())
+		return;
+
+	std::string tmpPath = path_ + ".tmp";
+	std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cerr << "Error: Failed to write hash cache " << tmpPath << std::endl;
+		return;
+	}
+
+	uint64_t count = index_.size();
+	for (auto& shard : shards_) {
+		std::scoped_lock<std::mutex> lock(shard.mutex);
+		for (const auto& [key, digests] : shard.entries)
+			if (!index_.contains(key))
+				++count;
+	}
+
+	out.write(kMagic, sizeof(kMagic));
+	writeValue(out, static_cast<uint64_t>(schedule_.firstBlockSize()));
+	writeValue(out, static_cast<uint64_t>(schedule_.maxBlockSize()));
+	writeValue(out, static_cast<uint32_t>(algorithm_.size()));
+	out.write(algorithm_.data(), algorithm_.size());
+	writeValue(out, count);
+
+	for (auto& shard : shards_) {
+		std::scoped_lock<std::mutex> lock(shard.mutex);
+		for (const auto& [key, digests] : shard.entries) {
+			writeValue(out, key.device);
+			writeValue(out, key.inode);
+			writeValue(out, key.size);
+			writeValue(out, key.mtime);
+			writeValue(out, static_cast<uint32_t>(digests.size()));
+			for (const auto& digest : digests)
+				out.write(reinterpret_cast<const char*>(digest.bytes.data()), digestSize_);
+		}
+	}
+	// Неизменённые записи копируются из отображения без декодирования
+	for (const auto& [key, entry] : index_) {
+		auto& shard = shardFor(key);
+		std::scoped_lock<std::mutex> lock(shard.mutex);
+		if (!shard.entries.contains(key))
+			out.write(mapped_.data() + entry.first, entry.second);
+	}
+	out.close();
+	if (!out) {
+		std::cerr << "Error: Failed to write hash cache " << tmpPath << std::endl;
+		return;
+	}
+
+	index_.clear();
+	mapped_.close();
+	std::error_code ec;
+	std::filesystem::rename(tmpPath, path_, ec);
+	if (ec) {
+		std::cerr << "Error: Failed to replace hash cache " << path_ << ": " << ec.message() << std::endl;
+		return;
+	}
+	dirty_ = false;
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+/**
+ * @file HashCache.h
+ * @brief Заголовочный файл для класса HashCache.
+ *
+ * Класс HashCache хранит на диске поблочные хэши файлов между запусками,
+ * чтобы неизменённые файлы не читались повторно.
+ */
+#pragma once
+#include "MappedFile.h"
+#include "HashCalculator.h"
+#include "BlockSchedule.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+/// Идентификатор версии файла: устройство, inode, размер и время изменения
+struct FileKey
+{
+	uint64_t device{ 0 }; ///< Идентификатор устройства.
+	uint64_t inode{ 0 }; ///< Номер inode.
+	uint64_t size{ 0 }; ///< Размер файла.
+	int64_t mtime{ 0 }; ///< Время последнего изменения, нс.
+
+	bool operator==(const FileKey&) const = default;
+
+	/**
+	 * @brief Метод для получения ключа файла по его метаданным.
+	 * @param path Путь к файлу.
+	 * @return Ключ файла или std::nullopt, если метаданные недоступны.
+	 */
+	static std::optional<FileKey> fromPath(const std::string& path);
+
+#ifndef _WIN32
+	/**
+	 * @brief Метод для получения ключа файла из уже полученных метаданных.
+	 * @param st Результат stat.
+	 * @return Ключ файла.
+	 */
+	static FileKey fromStat(const struct stat& st);
+#endif
+};
+
+/// Хэшер для FileKey
+struct FileKeyHash
+{
+	size_t operator()(const FileKey& key) const {
+		uint64_t h = key.inode * 0x9E3779B97F4A7C15ull;
+		h ^= key.device + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+		h ^= key.size + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+		h ^= static_cast<uint64_t>(key.mtime) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+		return static_cast<size_t>(h);
+	}
+};
+
+/**
+ * @class HashCache
+ * @brief Персистентный кэш поблочных хэшей файлов.
+ *
+ * Записи имеют фиксированный размер хэша. Файл кэша отображается в память при загрузке; новые записи накапливаются в
+ * сегментированной (по мьютексу на сегмент) таблице и атомарно записываются
+ * через временный файл и переименование в save(). Кэш привязан к алгоритму
+ * хэширования и разбиению на блоки: при их несовпадении он начинается с нуля.
+ * Ключ включает размер и время изменения, поэтому изменённые файлы
+ * автоматически не находятся в кэше.
+ */
+class HashCache
+{
+public:
+	/**
+	 * @brief Конструктор класса HashCache. Загружает кэш из файла, если он существует.
+	 * @param path Путь к файлу кэша (пусто - кэш только в памяти).
+	 * @param algorithm Алгоритм хэширования.
+	 * @param schedule Разбиение файлов на блоки.
+	 */
+	HashCache(const std::string& path, const IHashAlgorithm& algorithm, const BlockSchedule& schedule);
+
+	/**
+	 * @brief Деструктор класса HashCache. Сохраняет изменения.
+	 */
+	~HashCache();
+
+	HashCache(const HashCache&) = delete;
+	HashCache& operator=(const HashCache&) = delete;
+
+	/**
+	 * @brief Метод для поиска хэшей файла в кэше.
+	 * @param key Ключ файла.
+	 * @param digests Найденные хэши первых блоков файла.
+	 * @return true, если файл найден.
+	 */
+	bool lookup(const FileKey& key, std::vector<Digest>& digests) const;
+
+	/**
+	 * @brief Метод для сохранения хэшей файла в кэш. Более короткая цепочка не заменяет более длинную.
+	 * @param key Ключ файла.
+	 * @param digests Хэши первых блоков файла.
+	 */
+	void store(const FileKey& key, const std::vector<Digest>& digests);
+
+	/**
+	 * @brief Метод для записи кэша на диск.
+	 */
+	void save();
+
+private:
+	static constexpr size_t kShards = 16; ///< Количество сегментов таблицы изменений.
+
+	/// Сегмент таблицы изменений
+	struct Shard
+	{
+		mutable std::mutex mutex; ///< Мьютекс сегмента.
+		std::unordered_map<FileKey, std::vector<Digest>, FileKeyHash> entries; ///< Новые записи.
+	};
+
+	/**
+	 * @brief Метод для построения индекса по отображённому файлу кэша.
+	 */
+	void load();
+
+	/**
+	 * @brief Метод для декодирования хэшей записи из отображения.
+	 * @param offset Смещение начала записи.
+	 * @param digests Декодированные хэши.
+	 */
+	void decode(size_t offset, std::vector<Digest>& digests) const;
+
+	/// Сегмент для ключа
+	Shard& shardFor(const FileKey& key) const { return shards_[FileKeyHash{}(key) % kShards]; }
+
+	std::string path_; ///< Путь к файлу кэша.
+	std::string algorithm_; ///< Название алгоритма хэширования.
+	BlockSchedule schedule_; ///< Разбиение файлов на блоки.
+	size_t digestSize_; ///< Длина хэша.
+	MappedFile mapped_; ///< Отображение загруженного файла кэша.
+	std::unordered_map<FileKey, std::pair<size_t, size_t>, FileKeyHash> index_; ///< Ключ -> (смещение записи, длина записи).
+	mutable std::array<Shard, kShards> shards_; ///< Записи, добавленные в текущем запуске.
+	std::mutex saveMutex_; ///< Мьютекс записи на диск.
+	std::atomic<bool> dirty_{ false }; ///< Признак наличия несохранённых изменений.
+};
\ No newline at end of file
@@ -1,44 +1,128 @@
-#include "HashCalculator.h"
-#include <boost/algorithm/hex.hpp>
-#include <boost/crc.hpp>
-#include <boost/uuid/detail/md5.hpp>
-#include <bit>
-
-std::string CRC32Hash::calculateHash(const std::vector<char>& block) const
-{
-	boost::crc_32_type result;
-	result.process_bytes(block.data(), block.size());
-	return std::to_string(result.checksum());
-}
-
-std::string MD5Hash::calculateHash(const std::vector<char>& block) const
-{
-	boost::uuids::detail::md5 hash;
-	hash.process_bytes(block.data(), block.size());
-	boost::uuids::detail::md5::digest_type digest;
-	hash.get_digest(digest);
-	const auto charDigest = std::bit_cast<const char*>(&digest);
-	std::string result;
-	boost::algorithm::hex(charDigest, charDigest + sizeof(boost::uuids::detail::md5::digest_type), std::back_inserter(result));
-	return result;
-}
-
-HashCalculator::HashCalculator(IHashAlgorithm* algorithm, size_t blockSize)
-	: algorithm_(algorithm), blockSize_(blockSize)
-{
-}
-
-std::string HashCalculator::calculateHash(const std::vector<char>& block) const
-{
-	return algorithm_->calculateHash(block);
-}
-
-std::unique_ptr<IHashAlgorithm> HashAlgorithmFactory::create(const std::string_view& algorithm) {
-	if (algorithm == "crc32") {
-		return std::make_unique<CRC32Hash>();
-	}
-	else if (algorithm == "md5") {
-		return std::make_unique<MD5Hash>();
-	}
-	throw std::invalid_argument("Invalid hash algorithm");
+#include "HashCalculator.h"
+#include "Stats.h"
+#include <boost/crc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+Digest CRC32Hash::calculateHash(std::span<const char> block) const
+{
+	boost::crc_32_type result;
+	result.process_bytes(block.data(), block.size());
+	uint32_t checksum = result.checksum();
+	return Digest(&checksum, sizeof(checksum));
+}
+
+HashCalculator::HashCalculator(IHashAlgorithm* algorithm, size_t blockSize)
+	: algorithm_(algorithm), blockSize_(blockSize)
+{
+}
+
+Digest HashCalculator::calculateHash(std::span<const char> block) const
+{
+	Stats::add(StatCounter::HASHED_BYTES, block.size());
+	StatTimer timer(StatCounter::HASH_NANOS);
+	return algorithm_->calculateHash(block);
+}
+
+void HashCalculator::calculateHashes(std::span<const std::span<const char>> blocks, std::span<Digest> digests) const
+{
+	for (const auto& block : blocks)
+		Stats::add(StatCounter::HASHED_BYTES, block.size());
+	StatTimer timer(StatCounter::HASH_NANOS);
+	algorithm_->calculateHashes(blocks, digests);
+}
+
+Digest HashCalculator::combineHashes(const std::vector<Digest>& blockHashes) const
+{
+	if (blockHashes.size() == 1)
+		return blockHashes.front();
+	std::vector<char> concatenated;
+	concatenated.reserve(blockHashes.size() * Digest::kMaxSize);
+	for (const auto& digest : blockHashes) {
+		auto bytes = digest.view();
+		concatenated.insert(concatenated.end(), bytes.begin(), bytes.end());
+	}
+	return calculateHash(concatenated);
+}
+
+std::unique_ptr<IHashAlgorithm> HashAlgorithmFactory::create(const std::string_view& algorithm) {
+	if (algorithm == "crc32") {
+		return std::make_unique<CRC32Hash>();
+	}
+	else if (algorithm == "md5") {
+		return std::make_unique<MD5Hash>();
+	}
+	else if (algorithm == "crc32c") {
+		return std::make_unique<CRC32CHash>();
+	}
+	else if (algorithm == "xxh3") {
+		return std::make_unique<XXH3Hash>();
+	}
+	else if (algorithm == "xxh128") {
+		return std::make_unique<XXH128Hash>();
+	}
+	else if (algorithm == "blake3") {
+		return std::make_unique<Blake3Hash>();
+	}
+	throw std::invalid_argument("Invalid hash algorithm");
+}
+
+std::vector<std::string_view> HashAlgorithmFactory::names()
+{
+	return { "crc32", "md5", "crc32c", "xxh3", "xxh128", "blake3" };
+}
+
+namespace
+{
+	volatile uint8_t benchmarkSink = 0;
+}
+
+void HashAlgorithmFactory::benchmark(std::ostream& out, size_t blockSize)
+{
+	// Псевдослучайные данные, чтобы результат не зависел от содержимого
+	std::vector<char> buffer(std::max<size_t>(blockSize, 1));
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	for (auto& byte : buffer) {
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		byte = static_cast<char>(state >> 56);
+	}
+	constexpr auto duration = std::chrono::milliseconds(300);
+	// Пакет из 8 блоков показывает выигрыш алгоритмов, хэширующих несколько блоков за проход
+	constexpr size_t batchSize = 8;
+	std::vector<std::span<const char>> batch(batchSize, std::span<const char>(buffer));
+	std::vector<Digest> digests(batchSize);
+	out << "Hash throughput, block size " << buffer.size() << " bytes:" << std::endl;
+	for (auto name : names()) {
+		auto algorithm = create(name);
+		uint8_t sink = 0;
+
+		/// Функция для измерения пропускной способности, МБ/с
+		auto measure = [&](auto&& hashOnce) {
+			size_t bytes = 0;
+			auto start = std::chrono::steady_clock::now();
+			auto elapsed = std::chrono::steady_clock::duration::zero();
+			while (elapsed < duration) {
+				for (int i = 0; i < 16; ++i)
+					bytes += hashOnce();
+				elapsed = std::chrono::steady_clock::now() - start;
+			}
+			double seconds = std::chrono::duration<double>(elapsed).count();
+			return static_cast<uint64_t>(bytes / seconds / (1024 * 1024));
+			};
+
+		uint64_t single = measure([&]() {
+			sink ^= algorithm->calculateHash(buffer).bytes[0];
+			return buffer.size();
+			});
+		uint64_t batched = measure([&]() {
+			algorithm->calculateHashes(batch, digests);
+			sink ^= digests.back().bytes[0];
+			return buffer.size() * batchSize;
+			});
+		// Результат сохраняется, чтобы компилятор не выбросил расчет
+		benchmarkSink = sink;
+		out << "  " << name << ": " << single << " MB/s, batch of " << batchSize << ": " << batched << " MB/s" << std::endl;
+	}
 }
\ No newline at end of file
@@ -1,92 +1,242 @@
-/**
- * @file IHashAlgorithm.h
- * @brief Заголовочный файл для интерфейса IHashAlgorithm.
- *
- * Интерфейс IHashAlgorithm определяет методы для расчета хэша данных.
- */
-#pragma once
-#include <vector>
-#include <string>
-#include <memory>
-
- /**
-  * @class IHashAlgorithm
-  * @brief Интерфейс для расчета хэша данных.
-  */
-class IHashAlgorithm
-{
-public:
-
-	/**
-	 * @brief Деструктор класса IHashAlgorithm.
-	 */
-	virtual ~IHashAlgorithm() = default;
-
-	/**
-	 * @brief Метод для расчета хэша блока данных.
-	 * @param block Блок данных.
-	 * @return Хэш блока данных.
-	 */
-	virtual std::string calculateHash(const std::vector<char>& block) const = 0;
-};
-
-/**
- * @class HashCalculator
- * @brief Класс для расчета хэша данных с использованием заданного алгоритма.
- */
-class HashCalculator
-{
-public:
-	/**
-	 * @brief Конструктор класса HashCalculator.
-	 * @param algorithm Указатель на алгоритм хэширования.
-	 * @param blockSize Размер блока данных.
-	 */
-	HashCalculator(IHashAlgorithm* algorithm, size_t blockSize);
-
-	/**
-	 * @brief Метод для расчета хэша блока данных.
-	 * @param block Блок данных.
-	 * @return Хэш блока данных.
-	 */
-	std::string calculateHash(const std::vector<char>& block) const;
-
-private:
-	IHashAlgorithm* algorithm_; ///< Указатель на алгоритм хэширования.
-	size_t blockSize_; ///< Размер блока данных.
-};
-
-/**
- * @class HashAlgorithmFactory
- * @brief Класс для создания объектов алгоритмов хэширования.
- */
-class HashAlgorithmFactory
-{
-public:
-	/**
-	 * @brief Метод для создания объекта алгоритма хэширования.
-	 * @param algorithm Название алгоритма.
-	 * @return Указатель на объект алгоритма хэширования.
-	 */
-	static std::unique_ptr<IHashAlgorithm> create(const std::string_view& algorithm);
-};
-
-/**
- * @class CRC32Hash
- * @brief Класс для расчета хэша CRC32.
- */
-class CRC32Hash : public IHashAlgorithm
-{
-public:
-	std::string calculateHash(const std::vector<char>& block) const override;
-};
-
-/**
- * @class MD5Hash
- * @brief Класс для расчета хэша MD5.
- */
-class MD5Hash : public IHashAlgorithm
-{
-public:
-	std::string calculateHash(const std::vector<char>& block) const override;
+/**
+ * @file IHashAlgorithm.h
+ * @brief Заголовочный файл для интерфейса IHashAlgorithm.
+ *
+ * Интерфейс IHashAlgorithm определяет методы для расчета хэша данных.
+ */
+#pragma once
+#include "Digest.h"
+#include <span>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+class ThreadPool;
+
+ /**
+  * @class IHashAlgorithm
+  * @brief Интерфейс для расчета хэша данных.
+  */
+class IHashAlgorithm
+{
+public:
+
+	/**
+	 * @brief Деструктор класса IHashAlgorithm.
+	 */
+	virtual ~IHashAlgorithm() = default;
+
+	/**
+	 * @brief Метод для расчета хэша блока данных.
+	 * @param block Блок данных.
+	 * @return Хэш блока данных.
+	 */
+	virtual Digest calculateHash(std::span<const char> block) const = 0;
+
+	/**
+	 * @brief Метод для расчета хэшей блоков нескольких файлов за один вызов.
+	 * @param blocks Блоки данных (обычно блоки с одним номером файлов одного размера).
+	 * @param digests Хэши блоков; размер равен количеству блоков.
+	 */
+	virtual void calculateHashes(std::span<const std::span<const char>> blocks, std::span<Digest> digests) const = 0;
+
+	/**
+	 * @brief Метод для получения названия алгоритма.
+	 * @return Название алгоритма.
+	 */
+	virtual std::string_view name() const = 0;
+
+	/**
+	 * @brief Метод для получения длины хэша.
+	 * @return Длина хэша, байт.
+	 */
+	virtual size_t digestSize() const = 0;
+
+	/**
+	 * @brief Метод для передачи пула потоков алгоритмам, умеющим хэшировать большой блок параллельно.
+	 * @param pool Пул потоков.
+	 */
+	virtual void setThreadPool(ThreadPool* /*pool*/) {}
+};
+
+/**
+ * @class HashAlgorithm
+ * @brief Базовый класс алгоритма хэширования с пакетным расчетом без виртуального вызова на каждый блок.
+ * @tparam Algorithm Класс алгоритма, определяющий calculateHash.
+ */
+template <typename Algorithm>
+class HashAlgorithm : public IHashAlgorithm
+{
+public:
+	void calculateHashes(std::span<const std::span<const char>> blocks, std::span<Digest> digests) const override
+	{
+		// Вызов с указанием класса не виртуальный и встраивается в цикл
+		const auto& algorithm = static_cast<const Algorithm&>(*this);
+		for (size_t i = 0; i < blocks.size(); ++i)
+			digests[i] = algorithm.Algorithm::calculateHash(blocks[i]);
+	}
+};
+
+/**
+ * @class HashCalculator
+ * @brief Класс для расчета хэша данных с использованием заданного алгоритма.
+ */
+class HashCalculator
+{
+public:
+	/**
+	 * @brief Конструктор класса HashCalculator.
+	 * @param algorithm Указатель на алгоритм хэширования.
+	 * @param blockSize Размер блока данных.
+	 */
+	HashCalculator(IHashAlgorithm* algorithm, size_t blockSize);
+
+	/**
+	 * @brief Метод для расчета хэша блока данных.
+	 * @param block Блок данных.
+	 * @return Хэш блока данных.
+	 */
+	Digest calculateHash(std::span<const char> block) const;
+
+	/**
+	 * @brief Метод для расчета хэшей блоков нескольких файлов за один вызов алгоритма.
+	 * @param blocks Блоки данных.
+	 * @param digests Хэши блоков; размер равен количеству блоков.
+	 */
+	void calculateHashes(std::span<const std::span<const char>> blocks, std::span<Digest> digests) const;
+
+	/**
+	 * @brief Метод для расчета хэша содержимого файла по хэшам его блоков.
+	 * @param blockHashes Хэши всех блоков файла.
+	 * @return Хэш единственного блока или хэш последовательности поблочных хэшей.
+	 */
+	Digest combineHashes(const std::vector<Digest>& blockHashes) const;
+
+	/**
+	 * @brief Метод для получения алгоритма хэширования.
+	 * @return Ссылка на алгоритм хэширования.
+	 */
+	const IHashAlgorithm& algorithm() const { return *algorithm_; }
+
+private:
+	IHashAlgorithm* algorithm_; ///< Указатель на алгоритм хэширования.
+	size_t blockSize_; ///< Размер блока данных.
+};
+
+/**
+ * @class HashAlgorithmFactory
+ * @brief Класс для создания объектов алгоритмов хэширования.
+ */
+class HashAlgorithmFactory
+{
+public:
+	/**
+	 * @brief Метод для создания объекта алгоритма хэширования.
+	 * @param algorithm Название алгоритма.
+	 * @return Указатель на объект алгоритма хэширования.
+	 */
+	static std::unique_ptr<IHashAlgorithm> create(const std::string_view& algorithm);
+
+	/**
+	 * @brief Метод для получения названий всех поддерживаемых алгоритмов.
+	 * @return Список названий.
+	 */
+	static std::vector<std::string_view> names();
+
+	/**
+	 * @brief Метод для измерения пропускной способности всех алгоритмов на блоках заданного размера.
+	 * @param out Поток для вывода результатов.
+	 * @param blockSize Размер блока.
+	 */
+	static void benchmark(std::ostream& out, size_t blockSize);
+};
+
+/**
+ * @class CRC32Hash
+ * @brief Класс для расчета хэша CRC32.
+ */
+class CRC32Hash final : public HashAlgorithm<CRC32Hash>
+{
+public:
+	Digest calculateHash(std::span<const char> block) const override;
+	std::string_view name() const override { return "crc32"; }
+	size_t digestSize() const override { return 4; }
+};
+
+/**
+ * @class MD5Hash
+ * @brief Класс для расчета хэша MD5.
+ *
+ * Пакет блоков одинаковой длины хэшируется с AVX2 по 8 блоков за проход:
+ * каждая 32-битная полоса вектора ведет состояние своего блока.
+ */
+class MD5Hash final : public HashAlgorithm<MD5Hash>
+{
+public:
+	Digest calculateHash(std::span<const char> block) const override;
+	void calculateHashes(std::span<const std::span<const char>> blocks, std::span<Digest> digests) const override;
+	std::string_view name() const override { return "md5"; }
+	size_t digestSize() const override { return 16; }
+};
+
+/**
+ * @class CRC32CHash
+ * @brief Класс для расчета хэша CRC32C (полином Кастаньоли).
+ *
+ * Использует инструкции SSE4.2 или ARMv8 CRC, если процессор их поддерживает,
+ * иначе - табличный расчет slicing-by-8. В пакете блоки одинаковой длины считаются
+ * по три одновременно: независимые цепочки инструкций CRC скрывают их задержку.
+ */
+class CRC32CHash final : public HashAlgorithm<CRC32CHash>
+{
+public:
+	Digest calculateHash(std::span<const char> block) const override;
+	void calculateHashes(std::span<const std::span<const char>> blocks, std::span<Digest> digests) const override;
+	std::string_view name() const override { return "crc32c"; }
+	size_t digestSize() const override { return 4; }
+};
+
+/**
+ * @class XXH3Hash
+ * @brief Класс для расчета 64-битного хэша XXH3 (SSE2/AVX2).
+ */
+class XXH3Hash final : public HashAlgorithm<XXH3Hash>
+{
+public:
+	Digest calculateHash(std::span<const char> block) const override;
+	std::string_view name() const override { return "xxh3"; }
+	size_t digestSize() const override { return 8; }
+};
+
+/**
+ * @class XXH128Hash
+ * @brief Класс для расчета 128-битного хэша XXH3 (SSE2/AVX2).
+ */
+class XXH128Hash final : public HashAlgorithm<XXH128Hash>
+{
+public:
+	Digest calculateHash(std::span<const char> block) const override;
+	std::string_view name() const override { return "xxh128"; }
+	size_t digestSize() const override { return 16; }
+};
+
+/**
+ * @class Blake3Hash
+ * @brief Класс для расчета криптографического хэша BLAKE3.
+ *
+ * Полные килобайтные фрагменты блока хэшируются по 8 за раз с AVX2, а для
+ * больших блоков - параллельно задачами пула потоков.
+ */
+class Blake3Hash final : public HashAlgorithm<Blake3Hash>
+{
+public:
+	Digest calculateHash(std::span<const char> block) const override;
+	std::string_view name() const override { return "blake3"; }
+	size_t digestSize() const override { return 32; }
+	void setThreadPool(ThreadPool* pool) override { pool_ = pool; }
+
+private:
+	ThreadPool* pool_{ nullptr }; ///< Пул потоков для больших блоков.
 };
\ No newline at end of file
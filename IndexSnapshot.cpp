@@ -0,0 +1,302 @@
+#include "IndexSnapshot.h"
+#include "BlockReader.h"
+#include "DescriptorBudget.h"
+#include "Stats.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace
+{
+	/// Сигнатура файла снимка
+	constexpr char kMagic[8] = { 'B', 'A', 'Y', 'A', 'N', 'I', 'X', '1' };
+	/// Размер записи таблицы секций: наименьший и наибольший размер, смещение, количество
+	constexpr size_t kSectionEntrySize = 4 * sizeof(uint64_t);
+	/// Размер записи файла без имени и хэшей: ключ, директория, длина имени, количество хэшей
+	constexpr size_t kEntryHeaderSize = 4 * sizeof(uint64_t) + 3 * sizeof(uint32_t);
+
+	template <typename T>
+	bool readValue(const char* data, size_t size, size_t& offset, T& value)
+	{
+		if (size - offset < sizeof(T))
+			return false;
+		std::memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	template <typename T>
+	void writeValue(std::ostream& out, const T& value)
+	{
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	/**
+	 * @brief Функция для получения абсолютного пути директории без "..", "." и символических ссылок.
+	 *
+	 * Снимок читается из другой рабочей директории, поэтому относительные корни сканирования не годятся.
+	 * @param path Путь к директории.
+	 * @return Канонический путь (абсолютный путь, если директория недоступна).
+	 */
+	std::string absolutePath(const std::string& path)
+	{
+		std::error_code ec;
+		auto canonical = std::filesystem::weakly_canonical(std::filesystem::absolute(path, ec), ec);
+		if (!ec)
+			return canonical.string();
+		auto absolute = std::filesystem::absolute(path, ec);
+		return ec ? path : absolute.string();
+	}
+
+	/**
+	 * @brief Функция для получения границ секции.
+	 * @param section Номер секции.
+	 * @return Наименьший и наибольший размер файла секции.
+	 */
+	std::pair<uint64_t, uint64_t> sectionBounds(size_t section)
+	{
+		if (section == 0)
+			return { 0, 0 };
+		uint64_t maxSize = section == 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t{ 1 } << section) - 1;
+		return { uint64_t{ 1 } << (section - 1), maxSize };
+	}
+}
+
+std::string IndexSnapshot::hostName()
+{
+#ifdef _WIN32
+	const char* name = std::getenv("COMPUTERNAME");
+	return name ? name : "";
+#else
+	char name[256] = {};
+	if (::gethostname(name, sizeof(name) - 1) != 0)
+		return {};
+	return name;
+#endif
+}
+
+size_t IndexSnapshot::sectionOf(uint64_t size)
+{
+	return static_cast<size_t>(std::bit_width(size));
+}
+
+void IndexSnapshot::hashFiles(const FileIndex& index, std::span<const FileId> files, HashCache& cache,
+	const ArgumentParser::ParserData& data, ThreadPool& pool)
+{
+	const auto& schedule = data.blockSchedule;
+	HashCalculator hashCalculator(data.hashAlgorithm.get(), schedule.maxBlockSize());
+	DescriptorBudget budget(data.maxOpenFiles);
+	TaskGroup tasks(pool);
+	for (FileId id : files) {
+		tasks.run([&, id]() {
+			const FileKey& key = index.key(id);
+			const size_t blockCount = schedule.blockCount(key.size);
+			std::vector<Digest> blockHashes;
+			if (cache.lookup(key, blockHashes) && blockHashes.size() >= blockCount)
+				return;
+			std::string path = index.path(id);
+			DescriptorBudget::Holder descriptors;
+			budget.acquire(descriptors);
+			auto reader = BlockReaderFactory::create(data.ioMode, data.cachePolicy);
+			if (!reader->open(path, key.size)) {
+				budget.release(descriptors);
+				Stats::add(StatCounter::FILES_FAILED);
+				std::cerr << "Failed to open file: " << path << ". File will be exported without hashes." << std::endl;
+				return;
+			}
+			bool complete = true;
+			for (size_t block = blockHashes.size(); block < blockCount; ++block) {
+				size_t length = schedule.length(block, key.size);
+				auto blockData = reader->read(schedule.offset(block), length);
+				Stats::add(StatCounter::BYTES_READ, blockData.size());
+				Stats::add(StatCounter::BLOCKS_READ);
+				// Файл укоротился после сканирования: неполная цепочка хэшей не сохраняется
+				if (blockData.size() != length) {
+					complete = false;
+					break;
+				}
+				blockHashes.push_back(hashCalculator.calculateHash(blockData));
+			}
+			reader->close();
+			budget.release(descriptors);
+			if (complete)
+				cache.store(key, blockHashes);
+			});
+	}
+	tasks.wait();
+}
+
+bool IndexSnapshot::write(const std::string& path, const FileIndex& index, std::span<const FileId> files, const HashCache* cache,
+	const IHashAlgorithm& algorithm, const BlockSchedule& schedule)
+{
+	// В таблицу директорий попадают только директории файлов снимка
+	std::unordered_map<DirectoryId, uint32_t> directoryIds;
+	std::vector<DirectoryId> directories;
+	for (FileId id : files) {
+		if (directoryIds.emplace(index.directory(id), static_cast<uint32_t>(directories.size())).second)
+			directories.push_back(index.directory(id));
+	}
+
+	std::string tmpPath = path + ".tmp";
+	std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+	if (!out)
+		return false;
+	std::string_view algorithmName = algorithm.name();
+	std::string origin = hostName();
+	size_t digestSize = algorithm.digestSize();
+	out.write(kMagic, sizeof(kMagic));
+	writeValue(out, static_cast<uint64_t>(schedule.firstBlockSize()));
+	writeValue(out, static_cast<uint64_t>(schedule.maxBlockSize()));
+	writeValue(out, static_cast<uint32_t>(algorithmName.size()));
+	out.write(algorithmName.data(), algorithmName.size());
+	writeValue(out, static_cast<uint32_t>(digestSize));
+	writeValue(out, static_cast<uint32_t>(origin.size()));
+	out.write(origin.data(), origin.size());
+	writeValue(out, static_cast<uint64_t>(directories.size()));
+	for (DirectoryId directory : directories) {
+		std::string directoryPath = absolutePath(index.directoryPath(directory));
+		writeValue(out, static_cast<uint32_t>(directoryPath.size()));
+		out.write(directoryPath.data(), directoryPath.size());
+	}
+
+	// Таблица секций заполняется после записи секций
+	std::array<Section, kSectionCount> sections{};
+	auto tableOffset = out.tellp();
+	std::array<char, kSectionCount * kSectionEntrySize> emptyTable{};
+	out.write(emptyTable.data(), emptyTable.size());
+
+	std::vector<Digest> digests;
+	for (FileId id : files) {
+		const FileKey& key = index.key(id);
+		Section& section = sections[sectionOf(key.size)];
+		if (section.count++ == 0)
+			section.offset = static_cast<uint64_t>(out.tellp());
+		digests.clear();
+		if (cache && cache->lookup(key, digests) && digests.size() > schedule.blockCount(key.size))
+			digests.resize(schedule.blockCount(key.size));
+		std::string_view name = index.fileName(id);
+		writeValue(out, key.device);
+		writeValue(out, key.inode);
+		writeValue(out, key.size);
+		writeValue(out, key.mtime);
+		writeValue(out, directoryIds.at(index.directory(id)));
+		writeValue(out, static_cast<uint32_t>(name.size()));
+		writeValue(out, static_cast<uint32_t>(digests.size()));
+		out.write(name.data(), name.size());
+		for (const auto& digest : digests)
+			out.write(reinterpret_cast<const char*>(digest.bytes.data()), digestSize);
+	}
+
+	out.seekp(tableOffset);
+	for (size_t k = 0; k < kSectionCount; ++k) {
+		auto [minSize, maxSize] = sectionBounds(k);
+		writeValue(out, minSize);
+		writeValue(out, maxSize);
+		writeValue(out, sections[k].offset);
+		writeValue(out, sections[k].count);
+	}
+	out.close();
+	if (!out)
+		return false;
+	std::error_code ec;
+	std::filesystem::rename(tmpPath, path, ec);
+	return !ec;
+}
+
+void IndexSnapshot::open(const std::string& path)
+{
+	path_ = path;
+	if (!mapped_.open(path))
+		throw std::runtime_error("Failed to open index snapshot " + path);
+	const char* data = mapped_.data();
+	size_t size = mapped_.size();
+	if (size < sizeof(kMagic) || std::memcmp(data, kMagic, sizeof(kMagic)) != 0)
+		throw std::runtime_error(path + " is not an index snapshot");
+	size_t offset = sizeof(kMagic);
+	const std::runtime_error truncated("Index snapshot " + path + " is truncated");
+
+	/// Функция для чтения строки с 32-битной длиной
+	auto readString = [&](std::string_view& value) {
+		uint32_t length = 0;
+		if (!readValue(data, size, offset, length) || size - offset < length)
+			return false;
+		value = std::string_view(data + offset, length);
+		offset += length;
+		return true;
+		};
+
+	std::string_view algorithm;
+	std::string_view origin;
+	uint32_t digestSize = 0;
+	uint64_t directoryCount = 0;
+	if (!readValue(data, size, offset, firstBlockSize_) || !readValue(data, size, offset, maxBlockSize_) || !readString(algorithm) ||
+		!readValue(data, size, offset, digestSize) || !readString(origin) || !readValue(data, size, offset, directoryCount))
+		throw truncated;
+	algorithm_ = algorithm;
+	origin_ = origin;
+	digestSize_ = digestSize;
+	if (digestSize_ > Digest::kMaxSize)
+		throw std::runtime_error("Index snapshot " + path + " has an unsupported digest size");
+	if (directoryCount > (size - offset) / sizeof(uint32_t))
+		throw truncated;
+	directories_.resize(directoryCount);
+	for (auto& directory : directories_) {
+		if (!readString(directory))
+			throw truncated;
+	}
+	for (size_t k = 0; k < kSectionCount; ++k) {
+		Section section;
+		if (!readValue(data, size, offset, section.minSize) || !readValue(data, size, offset, section.maxSize) ||
+			!readValue(data, size, offset, section.offset) || !readValue(data, size, offset, section.count))
+			throw truncated;
+		if (std::make_pair(section.minSize, section.maxSize) != sectionBounds(k) || section.offset > size)
+			throw std::runtime_error("Index snapshot " + path + " is corrupted");
+		if (section.count > 0)
+			sections_.push_back(section);
+	}
+}
+
+bool IndexSnapshot::compatible(const IHashAlgorithm& algorithm, const BlockSchedule& schedule) const
+{
+	return algorithm_ == algorithm.name() && digestSize_ == algorithm.digestSize() &&
+		firstBlockSize_ == schedule.firstBlockSize() && maxBlockSize_ == schedule.maxBlockSize();
+}
+
+std::vector<IndexSnapshot::Entry> IndexSnapshot::entries(const Section& section) const
+{
+	const char* data = mapped_.data();
+	size_t size = mapped_.size();
+	size_t offset = section.offset;
+	std::vector<Entry> result;
+	result.reserve(std::min<uint64_t>(section.count, (size - offset) / kEntryHeaderSize));
+	for (uint64_t i = 0; i < section.count; ++i) {
+		Entry& entry = result.emplace_back();
+		uint32_t nameLength = 0;
+		if (!readValue(data, size, offset, entry.key.device) || !readValue(data, size, offset, entry.key.inode) ||
+			!readValue(data, size, offset, entry.key.size) || !readValue(data, size, offset, entry.key.mtime) ||
+			!readValue(data, size, offset, entry.directory) || !readValue(data, size, offset, nameLength) ||
+			!readValue(data, size, offset, entry.digestCount) || size - offset < nameLength)
+			throw std::runtime_error("Index snapshot " + path_ + " is truncated");
+		entry.name = std::string_view(data + offset, nameLength);
+		offset += nameLength;
+		if (entry.directory >= directories_.size() || entry.key.size < section.minSize || entry.key.size > section.maxSize)
+			throw std::runtime_error("Index snapshot " + path_ + " is corrupted");
+		if (digestSize_ > 0 && (size - offset) / digestSize_ < entry.digestCount)
+			throw std::runtime_error("Index snapshot " + path_ + " is truncated");
+		entry.digests = data + offset;
+		offset += static_cast<size_t>(entry.digestCount) * digestSize_;
+	}
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+/**
+ * @file IndexSnapshot.h
+ * @brief Заголовочный файл для класса IndexSnapshot.
+ *
+ * Класс IndexSnapshot записывает и читает снимок индекса найденных файлов
+ * с вычисленными поблочными хэшами для слияния результатов нескольких машин.
+ */
+#pragma once
+#include "ArgumentParser.h"
+#include "FileIndex.h"
+#include "HashCache.h"
+#include "HashCalculator.h"
+#include "BlockSchedule.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class IndexSnapshot
+ * @brief Снимок индекса файлов, разбитый на секции по диапазонам размеров.
+ *
+ * Файл снимка содержит заголовок (алгоритм хэширования, разбиение на блоки, имя машины),
+ * таблицу директорий, таблицу секций и сами секции. Секция k содержит файлы размером
+ * от 2^(k-1) до 2^k - 1 байт (секция 0 - пустые файлы) в порядке возрастания размера,
+ * поэтому у всех снимков одинаковые границы секций: при слиянии секции одного диапазона
+ * обрабатываются независимо и параллельно, а диапазон --min-size/--max-size читает только
+ * пересекающиеся с ним секции. Для каждого файла хранятся ключ, директория, имя и хэши
+ * всех блоков (hashFiles), поэтому при слиянии файл другой машины сравнивается без чтения.
+ * Директории хранятся абсолютными путями.
+ */
+class IndexSnapshot
+{
+public:
+	/// Количество секций (классов размера)
+	static constexpr size_t kSectionCount = 65;
+
+	/// Секция снимка
+	struct Section
+	{
+		uint64_t minSize{ 0 }; ///< Наименьший размер файла секции.
+		uint64_t maxSize{ 0 }; ///< Наибольший размер файла секции.
+		uint64_t offset{ 0 }; ///< Смещение первой записи секции.
+		uint64_t count{ 0 }; ///< Количество файлов секции.
+	};
+
+	/// Файл снимка
+	struct Entry
+	{
+		FileKey key; ///< Устройство, inode, размер и время изменения.
+		uint32_t directory{ 0 }; ///< Директория в таблице директорий снимка.
+		std::string_view name; ///< Имя файла (указывает в отображение снимка).
+		const char* digests{ nullptr }; ///< Хэши первых блоков подряд (указывает в отображение снимка).
+		uint32_t digestCount{ 0 }; ///< Количество хэшей.
+	};
+
+	/**
+	 * @brief Метод для получения имени текущей машины.
+	 * @return Имя машины (пусто, если неизвестно).
+	 */
+	static std::string hostName();
+
+	/**
+	 * @brief Метод для получения секции файла заданного размера.
+	 * @param size Размер файла.
+	 * @return Номер секции.
+	 */
+	static size_t sectionOf(uint64_t size);
+
+	/**
+	 * @brief Метод для вычисления хэшей всех блоков файлов снимка.
+	 *
+	 * Файл, уникальный по размеру на этой машине, при сравнении не читается, но при слиянии
+	 * может оказаться дубликатом файла другой машины, который открыть нельзя. Хэши, уже
+	 * найденные в кэше, не пересчитываются. Файлы хэшируются параллельными задачами пула.
+	 * @param index Индекс найденных файлов.
+	 * @param files Файлы снимка.
+	 * @param cache Кэш, в который записываются хэши.
+	 * @param data Данные, полученные из аргументов командной строки.
+	 * @param pool Пул потоков.
+	 */
+	static void hashFiles(const FileIndex& index, std::span<const FileId> files, HashCache& cache,
+		const ArgumentParser::ParserData& data, ThreadPool& pool);
+
+	/**
+	 * @brief Метод для записи снимка. Файл заменяется атомарно.
+	 * @param path Путь к файлу снимка.
+	 * @param index Индекс найденных файлов.
+	 * @param files Файлы снимка, отсортированные по размеру.
+	 * @param cache Кэш с вычисленными хэшами (может отсутствовать).
+	 * @param algorithm Алгоритм хэширования.
+	 * @param schedule Разбиение файлов на блоки.
+	 * @return false, если файл не удалось записать.
+	 */
+	static bool write(const std::string& path, const FileIndex& index, std::span<const FileId> files, const HashCache* cache,
+		const IHashAlgorithm& algorithm, const BlockSchedule& schedule);
+
+	/**
+	 * @brief Метод для открытия снимка.
+	 * @param path Путь к файлу снимка.
+	 * @throws std::runtime_error Если файл недоступен или не является снимком.
+	 */
+	void open(const std::string& path);
+
+	/**
+	 * @brief Метод для проверки, сравнимы ли хэши снимка с хэшами текущего запуска.
+	 * @param algorithm Алгоритм хэширования.
+	 * @param schedule Разбиение файлов на блоки.
+	 * @return true, если совпадают алгоритм, длина хэша и разбиение на блоки.
+	 */
+	bool compatible(const IHashAlgorithm& algorithm, const BlockSchedule& schedule) const;
+
+	/**
+	 * @brief Метод для чтения файлов секции.
+	 * @param section Секция.
+	 * @return Файлы секции в порядке возрастания размера.
+	 * @throws std::runtime_error Если секция повреждена.
+	 */
+	std::vector<Entry> entries(const Section& section) const;
+
+	/// Путь к файлу снимка
+	const std::string& path() const { return path_; }
+
+	/// Имя машины, на которой записан снимок
+	const std::string& origin() const { return origin_; }
+
+	/// Непустые секции по возрастанию размера
+	const std::vector<Section>& sections() const { return sections_; }
+
+	/// Путь к директории из таблицы директорий снимка
+	std::string_view directory(uint32_t id) const { return directories_[id]; }
+
+	/// Количество директорий
+	size_t directoryCount() const { return directories_.size(); }
+
+	/// Длина хэша
+	size_t digestSize() const { return digestSize_; }
+
+private:
+	std::string path_; ///< Путь к файлу снимка.
+	MappedFile mapped_; ///< Отображение файла снимка.
+	std::string algorithm_; ///< Название алгоритма хэширования.
+	uint64_t firstBlockSize_{ 0 }; ///< Размер первого блока.
+	uint64_t maxBlockSize_{ 0 }; ///< Наибольший размер блока.
+	size_t digestSize_{ 0 }; ///< Длина хэша.
+	std::string origin_; ///< Имя машины.
+	std::vector<std::string_view> directories_; ///< Пути к директориям (указывают в отображение снимка).
+	std::vector<Section> sections_; ///< Непустые секции.
+};
\ No newline at end of file
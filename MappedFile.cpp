@@ -0,0 +1,151 @@
+#include "MappedFile.h"
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other) {
+		close();
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		std::swap(opened_, other.opened_);
+		std::swap(fd_, other.fd_);
+#ifdef _WIN32
+		std::swap(mapping_, other.mapping_);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return false;
+	}
+	size_ = static_cast<size_t>(fileSize.QuadPart);
+	if (size_ == 0) {
+		CloseHandle(file);
+		opened_ = true;
+		return true;
+	}
+	mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping_)
+		return false;
+	data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (!data_) {
+		CloseHandle(mapping_);
+		mapping_ = nullptr;
+		return false;
+	}
+	opened_ = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_)
+		UnmapViewOfFile(data_);
+	if (mapping_)
+		CloseHandle(mapping_);
+	data_ = nullptr;
+	mapping_ = nullptr;
+	size_ = 0;
+	opened_ = false;
+}
+
+void MappedFile::adviseSequential() const
+{
+}
+
+void MappedFile::adviseDone(size_t, size_t) const
+{
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+	struct stat st {};
+	if (::fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+	size_ = static_cast<size_t>(st.st_size);
+	if (size_ == 0) {
+		fd_ = fd;
+		opened_ = true;
+		return true;
+	}
+	void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (addr == MAP_FAILED) {
+		::close(fd);
+		size_ = 0;
+		return false;
+	}
+	data_ = static_cast<const char*>(addr);
+	fd_ = fd;
+	opened_ = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_)
+		::munmap(const_cast<char*>(data_), size_);
+	if (fd_ >= 0)
+		::close(fd_);
+	fd_ = -1;
+	data_ = nullptr;
+	size_ = 0;
+	opened_ = false;
+}
+
+void MappedFile::adviseSequential() const
+{
+	if (data_)
+		::madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+}
+
+void MappedFile::adviseDone(size_t offset, size_t length) const
+{
+	if (!data_ || offset >= size_)
+		return;
+	// madvise требует начала на границе страницы; концом может быть любой адрес внутри отображения
+	static const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+	size_t start = offset / pageSize * pageSize;
+	size_t end = std::min(offset + length, size_);
+#ifdef MADV_PAGEOUT
+	::madvise(const_cast<char*>(data_) + start, end - start, MADV_PAGEOUT);
+#else
+	::madvise(const_cast<char*>(data_) + start, end - start, MADV_DONTNEED);
+#endif
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+/**
+ * @file MappedFile.h
+ * @brief Заголовочный файл для класса MappedFile.
+ *
+ * Класс MappedFile отображает файл в память только для чтения.
+ */
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief RAII-обёртка над отображением файла в память (только чтение).
+ *
+ * Дескриптор файла (POSIX) остается открытым вместе с отображением: по нему запрашивается
+ * расположение файла на устройстве.
+ */
+class MappedFile
+{
+public:
+	/**
+	 * @brief Конструктор по умолчанию (пустое отображение).
+	 */
+	MappedFile() = default;
+
+	/**
+	 * @brief Конструктор, отображающий файл в память.
+	 * @param path Путь к файлу.
+	 */
+	explicit MappedFile(const std::string& path) { open(path); }
+
+	/**
+	 * @brief Деструктор класса MappedFile.
+	 */
+	~MappedFile() { close(); }
+
+	/// Move-конструктор
+	MappedFile(MappedFile&& other) noexcept;
+
+	/// Move-оператор присваивания
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * @brief Метод для отображения файла в память.
+	 * @param path Путь к файлу.
+	 * @return true, если файл успешно отображён (пустой файл считается отображённым).
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * @brief Метод для снятия отображения.
+	 */
+	void close();
+
+	/**
+	 * @brief Метод для подсказки ядру о последовательном чтении.
+	 */
+	void adviseSequential() const;
+
+	/**
+	 * @brief Метод для вытеснения страниц прочитанного диапазона из памяти и страничного кэша.
+	 * @param offset Смещение диапазона.
+	 * @param length Размер диапазона.
+	 */
+	void adviseDone(size_t offset, size_t length) const;
+
+	/// Признак успешного отображения
+	bool isOpen() const { return opened_; }
+
+	/// Указатель на начало отображения
+	const char* data() const { return data_; }
+
+	/// Размер отображения
+	size_t size() const { return size_; }
+
+	/// Дескриптор отображенного файла (-1 в Windows и без отображения)
+	int fd() const { return fd_; }
+
+private:
+	const char* data_{ nullptr }; ///< Начало отображения.
+	size_t size_{ 0 }; ///< Размер отображения.
+	bool opened_{ false }; ///< Признак успешного отображения.
+	int fd_{ -1 }; ///< Дескриптор файла (POSIX).
+#ifdef _WIN32
+	void* mapping_{ nullptr }; ///< Дескриптор объекта отображения.
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "MaskMatcher.h"
+#include <cstdint>
+
+namespace
+{
+	/// Перевод символа ASCII в нижний регистр (остальные байты не меняются)
+	inline unsigned char lower(unsigned char c)
+	{
+		return c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+	}
+
+	/// Признак маски glob
+	bool isPattern(std::string_view mask)
+	{
+		return mask.find_first_of("*?[") != std::string_view::npos;
+	}
+
+	/**
+	 * @brief Функция для получения расширения имени файла (как std::filesystem::path::extension).
+	 * @param name Имя файла.
+	 * @return Расширение с точкой или пустая строка.
+	 */
+	std::string_view extensionOf(std::string_view name)
+	{
+		size_t dot = name.rfind('.');
+		if (dot == std::string_view::npos || dot == 0 || name == "..")
+			return {};
+		return name.substr(dot);
+	}
+}
+
+size_t MaskMatcher::CaseInsensitiveHash::operator()(std::string_view value) const
+{
+	// FNV-1a по байтам в нижнем регистре
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (unsigned char c : value) {
+		hash ^= lower(c);
+		hash *= 0x100000001b3ull;
+	}
+	return static_cast<size_t>(hash);
+}
+
+bool MaskMatcher::CaseInsensitiveEqual::operator()(std::string_view lhs, std::string_view rhs) const
+{
+	if (lhs.size() != rhs.size())
+		return false;
+	for (size_t i = 0; i < lhs.size(); ++i) {
+		if (lower(static_cast<unsigned char>(lhs[i])) != lower(static_cast<unsigned char>(rhs[i])))
+			return false;
+	}
+	return true;
+}
+
+MaskMatcher::MaskMatcher(const std::vector<std::string>& masks)
+{
+	for (const auto& mask : masks) {
+		if (mask.empty())
+			continue;
+		if (isPattern(mask))
+			patterns_.push_back(compile(mask));
+		else if (mask.front() == '.' && mask.find('.', 1) == std::string::npos)
+			extensions_.insert(mask);
+		else if (mask.front() == '.')
+			patterns_.push_back(compile("*" + mask)); // составное расширение вида .tar.gz
+		else
+			names_.insert(mask);
+	}
+}
+
+std::vector<MaskMatcher::Token> MaskMatcher::compile(std::string_view mask)
+{
+	std::vector<Token> tokens;
+	for (size_t i = 0; i < mask.size(); ++i) {
+		char c = mask[i];
+		if (c == '*') {
+			// Несколько звездочек подряд эквивалентны одной
+			if (tokens.empty() || tokens.back().kind != Token::Kind::ANY_STRING)
+				tokens.push_back({ Token::Kind::ANY_STRING });
+		}
+		else if (c == '?') {
+			tokens.push_back({ Token::Kind::ANY_CHAR });
+		}
+		else if (c == '[') {
+			// Класс [abc], [a-z] или [!abc]; ']' сразу после '[' или '[!' входит в класс
+			size_t j = i + 1;
+			bool negate = j < mask.size() && (mask[j] == '!' || mask[j] == '^');
+			if (negate)
+				++j;
+			size_t end = mask.find(']', j + 1);
+			if (end == std::string_view::npos) {
+				tokens.push_back({ Token::Kind::LITERAL, '[' });
+				continue;
+			}
+			CharClass charClass;
+			for (size_t k = j; k < end; ++k) {
+				unsigned char from = static_cast<unsigned char>(mask[k]);
+				unsigned char to = from;
+				if (k + 2 < end && mask[k + 1] == '-') {
+					to = static_cast<unsigned char>(mask[k + 2]);
+					k += 2;
+				}
+				for (unsigned value = from; value <= to; ++value)
+					charClass.set(lower(static_cast<unsigned char>(value)));
+			}
+			if (negate) {
+				for (auto& byte : charClass.bits)
+					byte = static_cast<unsigned char>(~byte);
+			}
+			classes_.push_back(charClass);
+			tokens.push_back({ Token::Kind::CHAR_CLASS, 0, classes_.size() - 1 });
+			i = end;
+		}
+		else {
+			tokens.push_back({ Token::Kind::LITERAL, static_cast<char>(lower(static_cast<unsigned char>(c))) });
+		}
+	}
+	return tokens;
+}
+
+bool MaskMatcher::matchPattern(const std::vector<Token>& pattern, std::string_view name) const
+{
+	// Жадное сопоставление с возвратом к последней '*': O(длина шаблона * длина имени) без рекурсии
+	size_t p = 0;
+	size_t n = 0;
+	size_t starToken = SIZE_MAX;
+	size_t starName = 0;
+	while (n < name.size()) {
+		if (p < pattern.size()) {
+			const Token& token = pattern[p];
+			unsigned char c = lower(static_cast<unsigned char>(name[n]));
+			bool matched = false;
+			switch (token.kind) {
+			case Token::Kind::ANY_STRING:
+				starToken = p++;
+				starName = n;
+				continue;
+			case Token::Kind::ANY_CHAR:
+				matched = true;
+				break;
+			case Token::Kind::LITERAL:
+				matched = c == static_cast<unsigned char>(token.literal);
+				break;
+			case Token::Kind::CHAR_CLASS:
+				matched = classes_[token.classIndex].test(c);
+				break;
+			}
+			if (matched) {
+				++p;
+				++n;
+				continue;
+			}
+		}
+		if (starToken == SIZE_MAX)
+			return false;
+		p = starToken + 1;
+		n = ++starName;
+	}
+	while (p < pattern.size() && pattern[p].kind == Token::Kind::ANY_STRING)
+		++p;
+	return p == pattern.size();
+}
+
+bool MaskMatcher::matches(std::string_view name) const
+{
+	if (empty())
+		return true;
+	if (!extensions_.empty()) {
+		std::string_view extension = extensionOf(name);
+		if (!extension.empty() && extensions_.contains(extension))
+			return true;
+	}
+	if (!names_.empty() && names_.contains(name))
+		return true;
+	for (const auto& pattern : patterns_) {
+		if (matchPattern(pattern, name))
+			return true;
+	}
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+/**
+ * @file MaskMatcher.h
+ * @brief Заголовочный файл для класса MaskMatcher.
+ *
+ * Класс MaskMatcher проверяет имена файлов по маскам --masks без учета регистра.
+ */
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @class MaskMatcher
+ * @brief Скомпилированный набор масок имен файлов.
+ *
+ * Маски компилируются один раз при разборе аргументов:
+ * - ".ext" без спецсимволов - расширение файла, ищется в хэш-таблице
+ *   (составное расширение вида ".tar.gz" сопоставляется как шаблон "*.tar.gz");
+ * - имя без спецсимволов - точное имя файла, ищется в хэш-таблице;
+ * - маска с '*', '?' или '[...]' - шаблон glob для всего имени файла
+ *   (например IMG_*.jp?g), сопоставляется последовательностью токенов.
+ * Проверка имени не выделяет память.
+ */
+class MaskMatcher
+{
+public:
+	/// Конструктор по умолчанию: пустой набор масок подходит под любое имя
+	MaskMatcher() = default;
+
+	/**
+	 * @brief Конструктор из списка масок.
+	 * @param masks Маски имен файлов.
+	 */
+	explicit MaskMatcher(const std::vector<std::string>& masks);
+
+	/**
+	 * @brief Метод для проверки имени файла.
+	 * @param name Имя файла (без директории).
+	 * @return true, если имя подходит хотя бы под одну маску или маски не заданы.
+	 */
+	bool matches(std::string_view name) const;
+
+	/// Признак отсутствия масок
+	bool empty() const { return extensions_.empty() && names_.empty() && patterns_.empty(); }
+
+private:
+	/// Хэшер строк без учета регистра
+	struct CaseInsensitiveHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view value) const;
+	};
+
+	/// Сравнение строк без учета регистра
+	struct CaseInsensitiveEqual
+	{
+		using is_transparent = void;
+		bool operator()(std::string_view lhs, std::string_view rhs) const;
+	};
+
+	using NameSet = std::unordered_set<std::string, CaseInsensitiveHash, CaseInsensitiveEqual>;
+
+	/// Токен шаблона glob
+	struct Token
+	{
+		enum class Kind { LITERAL, ANY_CHAR, ANY_STRING, CHAR_CLASS } kind; ///< Вид токена.
+		char literal{ 0 }; ///< Символ (в нижнем регистре) для LITERAL.
+		size_t classIndex{ 0 }; ///< Номер класса символов для CHAR_CLASS.
+	};
+
+	/// Класс символов [...]: 256-битная маска допустимых байт
+	struct CharClass
+	{
+		unsigned char bits[32]{}; ///< Биты допустимых байт (в нижнем регистре).
+
+		void set(unsigned char c) { bits[c >> 3] |= static_cast<unsigned char>(1u << (c & 7)); }
+		bool test(unsigned char c) const { return (bits[c >> 3] >> (c & 7)) & 1u; }
+	};
+
+	/**
+	 * @brief Метод для компиляции маски glob в токены.
+	 * @param mask Маска.
+	 * @return Токены шаблона.
+	 */
+	std::vector<Token> compile(std::string_view mask);
+
+	/**
+	 * @brief Метод для сопоставления имени с шаблоном.
+	 * @param pattern Токены шаблона.
+	 * @param name Имя файла.
+	 * @return true, если имя подходит под шаблон.
+	 */
+	bool matchPattern(const std::vector<Token>& pattern, std::string_view name) const;
+
+	NameSet extensions_; ///< Расширения вида ".ext".
+	NameSet names_; ///< Точные имена файлов.
+	std::vector<std::vector<Token>> patterns_; ///< Шаблоны glob.
+	std::vector<CharClass> classes_; ///< Классы символов шаблонов.
+};
\ No newline at end of file
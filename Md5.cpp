@@ -0,0 +1,208 @@
+#include "HashCalculator.h"
+#include <boost/uuid/detail/md5.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BAYAN_MD5_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	/// Количество блоков, хэшируемых за один проход
+	constexpr size_t kLanes = 8;
+
+	Digest md5Scalar(std::span<const char> block)
+	{
+		boost::uuids::detail::md5 hash;
+		hash.process_bytes(block.data(), block.size());
+		boost::uuids::detail::md5::digest_type digest;
+		hash.get_digest(digest);
+		return Digest(&digest, sizeof(digest));
+	}
+
+#if BAYAN_MD5_AVX2
+	constexpr uint32_t kConstants[64] = {
+		0xD76AA478u, 0xE8C7B756u, 0x242070DBu, 0xC1BDCEEEu, 0xF57C0FAFu, 0x4787C62Au, 0xA8304613u, 0xFD469501u,
+		0x698098D8u, 0x8B44F7AFu, 0xFFFF5BB1u, 0x895CD7BEu, 0x6B901122u, 0xFD987193u, 0xA679438Eu, 0x49B40821u,
+		0xF61E2562u, 0xC040B340u, 0x265E5A51u, 0xE9B6C7AAu, 0xD62F105Du, 0x02441453u, 0xD8A1E681u, 0xE7D3FBC8u,
+		0x21E1CDE6u, 0xC33707D6u, 0xF4D50D87u, 0x455A14EDu, 0xA9E3E905u, 0xFCEFA3F8u, 0x676F02D9u, 0x8D2A4C8Au,
+		0xFFFA3942u, 0x8771F681u, 0x6D9D6122u, 0xFDE5380Cu, 0xA4BEEA44u, 0x4BDECFA9u, 0xF6BB4B60u, 0xBEBFBC70u,
+		0x289B7EC6u, 0xEAA127FAu, 0xD4EF3085u, 0x04881D05u, 0xD9D4D039u, 0xE6DB99E5u, 0x1FA27CF8u, 0xC4AC5665u,
+		0xF4292244u, 0x432AFF97u, 0xAB9423A7u, 0xFC93A039u, 0x655B59C3u, 0x8F0CCC92u, 0xFFEFF47Du, 0x85845DD1u,
+		0x6FA87E4Fu, 0xFE2CE6E0u, 0xA3014314u, 0x4E0811A1u, 0xF7537E82u, 0xBD3AF235u, 0x2AD7D2BBu, 0xEB86D391u,
+	};
+
+	inline uint32_t load32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+	/// Циклический сдвиг влево; величина сдвига - константа шага раунда
+	template <int Shift>
+	__attribute__((target("avx2"))) inline __m256i rotl(__m256i x)
+	{
+		return _mm256_or_si256(_mm256_slli_epi32(x, Shift), _mm256_srli_epi32(x, 32 - Shift));
+	}
+
+	/// Шаг раунда: a = b + rotl(a + f + m + k, s)
+	template <int Shift>
+	__attribute__((target("avx2"))) inline __m256i step(__m256i a, __m256i b, __m256i f, __m256i m, uint32_t k)
+	{
+		__m256i sum = _mm256_add_epi32(_mm256_add_epi32(a, f), _mm256_add_epi32(m, _mm256_set1_epi32(static_cast<int>(k))));
+		return _mm256_add_epi32(b, rotl<Shift>(sum));
+	}
+
+	/// Сжатие очередного 64-байтного фрагмента каждой полосы
+	__attribute__((target("avx2")))
+	void compress8(__m256i state[4], const unsigned char* const chunks[kLanes])
+	{
+		__m256i m[16];
+		for (size_t w = 0; w < 16; ++w) {
+			m[w] = _mm256_setr_epi32(
+				static_cast<int>(load32(chunks[0] + 4 * w)), static_cast<int>(load32(chunks[1] + 4 * w)),
+				static_cast<int>(load32(chunks[2] + 4 * w)), static_cast<int>(load32(chunks[3] + 4 * w)),
+				static_cast<int>(load32(chunks[4] + 4 * w)), static_cast<int>(load32(chunks[5] + 4 * w)),
+				static_cast<int>(load32(chunks[6] + 4 * w)), static_cast<int>(load32(chunks[7] + 4 * w)));
+		}
+		const __m256i ones = _mm256_set1_epi32(-1);
+		__m256i a = state[0], b = state[1], c = state[2], d = state[3];
+		for (size_t i = 0; i < 16; i += 4) {
+			a = step<7>(a, b, _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d))), m[i], kConstants[i]);
+			d = step<12>(d, a, _mm256_xor_si256(c, _mm256_and_si256(a, _mm256_xor_si256(b, c))), m[i + 1], kConstants[i + 1]);
+			c = step<17>(c, d, _mm256_xor_si256(b, _mm256_and_si256(d, _mm256_xor_si256(a, b))), m[i + 2], kConstants[i + 2]);
+			b = step<22>(b, c, _mm256_xor_si256(a, _mm256_and_si256(c, _mm256_xor_si256(d, a))), m[i + 3], kConstants[i + 3]);
+		}
+		for (size_t i = 16; i < 32; i += 4) {
+			a = step<5>(a, b, _mm256_xor_si256(c, _mm256_and_si256(d, _mm256_xor_si256(b, c))), m[(5 * i + 1) % 16], kConstants[i]);
+			d = step<9>(d, a, _mm256_xor_si256(b, _mm256_and_si256(c, _mm256_xor_si256(a, b))), m[(5 * i + 6) % 16], kConstants[i + 1]);
+			c = step<14>(c, d, _mm256_xor_si256(a, _mm256_and_si256(b, _mm256_xor_si256(d, a))), m[(5 * i + 11) % 16], kConstants[i + 2]);
+			b = step<20>(b, c, _mm256_xor_si256(d, _mm256_and_si256(a, _mm256_xor_si256(c, d))), m[(5 * i + 16) % 16], kConstants[i + 3]);
+		}
+		for (size_t i = 32; i < 48; i += 4) {
+			a = step<4>(a, b, _mm256_xor_si256(_mm256_xor_si256(b, c), d), m[(3 * i + 5) % 16], kConstants[i]);
+			d = step<11>(d, a, _mm256_xor_si256(_mm256_xor_si256(a, b), c), m[(3 * i + 8) % 16], kConstants[i + 1]);
+			c = step<16>(c, d, _mm256_xor_si256(_mm256_xor_si256(d, a), b), m[(3 * i + 11) % 16], kConstants[i + 2]);
+			b = step<23>(b, c, _mm256_xor_si256(_mm256_xor_si256(c, d), a), m[(3 * i + 14) % 16], kConstants[i + 3]);
+		}
+		for (size_t i = 48; i < 64; i += 4) {
+			a = step<6>(a, b, _mm256_xor_si256(c, _mm256_or_si256(b, _mm256_xor_si256(d, ones))), m[(7 * i) % 16], kConstants[i]);
+			d = step<10>(d, a, _mm256_xor_si256(b, _mm256_or_si256(a, _mm256_xor_si256(c, ones))), m[(7 * i + 7) % 16], kConstants[i + 1]);
+			c = step<15>(c, d, _mm256_xor_si256(a, _mm256_or_si256(d, _mm256_xor_si256(b, ones))), m[(7 * i + 14) % 16], kConstants[i + 2]);
+			b = step<21>(b, c, _mm256_xor_si256(d, _mm256_or_si256(c, _mm256_xor_si256(a, ones))), m[(7 * i + 21) % 16], kConstants[i + 3]);
+		}
+		state[0] = _mm256_add_epi32(state[0], a);
+		state[1] = _mm256_add_epi32(state[1], b);
+		state[2] = _mm256_add_epi32(state[2], c);
+		state[3] = _mm256_add_epi32(state[3], d);
+	}
+
+	/// Порядок байт слов хэша, совпадающий с результатом boost (зависит от версии boost)
+	enum class WordOrder
+	{
+		UNSUPPORTED,
+		LITTLE_ENDIAN_WORDS, ///< Стандартный порядок байт MD5.
+		BIG_ENDIAN_WORDS, ///< Байты каждого слова переставлены.
+	};
+
+	/// MD5 восьми блоков одинаковой длины; лишние полосы повторяют первый блок
+	__attribute__((target("avx2")))
+	void md5x8(const unsigned char* const inputs[kLanes], size_t size, WordOrder order, Digest* out, size_t count)
+	{
+		__m256i state[4] = {
+			_mm256_set1_epi32(0x67452301), _mm256_set1_epi32(static_cast<int>(0xEFCDAB89u)),
+			_mm256_set1_epi32(static_cast<int>(0x98BADCFEu)), _mm256_set1_epi32(0x10325476),
+		};
+		const unsigned char* chunks[kLanes];
+		const size_t fullChunks = size / 64;
+		for (size_t chunk = 0; chunk < fullChunks; ++chunk) {
+			for (size_t lane = 0; lane < kLanes; ++lane)
+				chunks[lane] = inputs[lane] + chunk * 64;
+			compress8(state, chunks);
+		}
+
+		// Остаток, бит 1, нули и длина в битах занимают один или два последних фрагмента
+		const size_t tail = size % 64;
+		const size_t tailChunks = tail < 56 ? 1 : 2;
+		alignas(32) unsigned char padded[kLanes][128] = {};
+		const uint64_t bits = static_cast<uint64_t>(size) * 8;
+		for (size_t lane = 0; lane < kLanes; ++lane) {
+			std::memcpy(padded[lane], inputs[lane] + fullChunks * 64, tail);
+			padded[lane][tail] = 0x80;
+			std::memcpy(padded[lane] + tailChunks * 64 - sizeof(bits), &bits, sizeof(bits));
+		}
+		for (size_t chunk = 0; chunk < tailChunks; ++chunk) {
+			for (size_t lane = 0; lane < kLanes; ++lane)
+				chunks[lane] = padded[lane] + chunk * 64;
+			compress8(state, chunks);
+		}
+
+		alignas(32) uint32_t words[4][kLanes];
+		for (size_t i = 0; i < 4; ++i)
+			_mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+		for (size_t lane = 0; lane < count; ++lane) {
+			uint32_t digest[4] = { words[0][lane], words[1][lane], words[2][lane], words[3][lane] };
+			if (order == WordOrder::BIG_ENDIAN_WORDS) {
+				for (auto& word : digest)
+					word = __builtin_bswap32(word);
+			}
+			out[lane] = Digest(digest, sizeof(digest));
+		}
+	}
+
+	/// Восьмиполосный расчет используется, если процессор поддерживает AVX2 и результат совпадает с boost
+	WordOrder selectWordOrder()
+	{
+		if (!__builtin_cpu_supports("avx2"))
+			return WordOrder::UNSUPPORTED;
+		// Проверка охватывает остаток с одним и с двумя завершающими фрагментами
+		std::array<char, 187> probe;
+		for (size_t i = 0; i < probe.size(); ++i)
+			probe[i] = static_cast<char>(i * 37 + 11);
+		for (WordOrder order : { WordOrder::LITTLE_ENDIAN_WORDS, WordOrder::BIG_ENDIAN_WORDS }) {
+			bool matches = true;
+			for (size_t size : { size_t{ 0 }, size_t{ 55 }, size_t{ 56 }, size_t{ 64 }, probe.size() }) {
+				const unsigned char* inputs[kLanes];
+				std::fill(std::begin(inputs), std::end(inputs), reinterpret_cast<const unsigned char*>(probe.data()));
+				Digest digest;
+				md5x8(inputs, size, order, &digest, 1);
+				matches = matches && digest == md5Scalar(std::span<const char>(probe.data(), size));
+			}
+			if (matches)
+				return order;
+		}
+		return WordOrder::UNSUPPORTED;
+	}
+#endif
+}
+
+Digest MD5Hash::calculateHash(std::span<const char> block) const
+{
+	return md5Scalar(block);
+}
+
+void MD5Hash::calculateHashes(std::span<const std::span<const char>> blocks, std::span<Digest> digests) const
+{
+	size_t first = 0;
+#if BAYAN_MD5_AVX2
+	static const WordOrder order = selectWordOrder();
+	while (order != WordOrder::UNSUPPORTED && blocks.size() - first > 1) {
+		// Проход объединяет идущие подряд блоки одинаковой длины
+		size_t count = 1;
+		while (count < kLanes && first + count < blocks.size() && blocks[first + count].size() == blocks[first].size())
+			++count;
+		if (count == 1) {
+			digests[first] = md5Scalar(blocks[first]);
+			++first;
+			continue;
+		}
+		const unsigned char* inputs[kLanes];
+		for (size_t lane = 0; lane < kLanes; ++lane)
+			inputs[lane] = reinterpret_cast<const unsigned char*>(blocks[first + (lane < count ? lane : 0)].data());
+		md5x8(inputs, blocks[first].size(), order, digests.data() + first, count);
+		first += count;
+	}
+#endif
+	for (; first < blocks.size(); ++first)
+		digests[first] = md5Scalar(blocks[first]);
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+/**
+ * @file MpscQueue.h
+ * @brief Заголовочный файл для класса MpscQueue.
+ *
+ * Класс MpscQueue - неблокирующая очередь со многими производителями и одним потребителем.
+ */
+#pragma once
+#include <atomic>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * @class MpscQueue
+ * @brief Неблокирующая очередь: производители добавляют элементы CAS-операцией над вершиной
+ * списка, потребитель забирает весь список одним обменом и восстанавливает порядок добавления.
+ * @tparam T Тип элемента.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+	MpscQueue() = default;
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	/// Деструктор: освобождает незабранные элементы
+	~MpscQueue() {
+		Node* node = head_.load(std::memory_order_acquire);
+		while (node) {
+			Node* next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+	/**
+	 * @brief Метод для добавления элемента (из любого потока).
+	 * @param value Элемент.
+	 */
+	void push(T value) { pushNode(new Node{ std::move(value), nullptr }); }
+
+	/**
+	 * @brief Метод для закрытия очереди: потребитель получит признак конца после всех элементов.
+	 */
+	void close() { pushNode(new Node{ std::nullopt, nullptr }); }
+
+	/**
+	 * @brief Метод для ожидания непустой очереди (только потребитель).
+	 */
+	void wait() const { head_.wait(nullptr, std::memory_order_acquire); }
+
+	/**
+	 * @brief Метод для извлечения всех элементов в порядке добавления (только потребитель).
+	 * @param out Вектор, в конец которого добавляются элементы.
+	 * @return false, если очередь закрыта.
+	 */
+	bool popAll(std::vector<T>& out) {
+		Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+		std::vector<Node*> nodes;
+		for (; node; node = node->next)
+			nodes.push_back(node);
+		bool open = true;
+		for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+			if ((*it)->value)
+				out.push_back(std::move(*(*it)->value));
+			else
+				open = false;
+			delete *it;
+		}
+		return open;
+	}
+
+private:
+	/// Узел списка; узел без значения - признак закрытия очереди
+	struct Node
+	{
+		std::optional<T> value; ///< Элемент.
+		Node* next; ///< Ранее добавленный узел.
+	};
+
+	void pushNode(Node* node) {
+		node->next = head_.load(std::memory_order_relaxed);
+		while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+		}
+		head_.notify_one();
+	}
+
+	std::atomic<Node*> head_{ nullptr }; ///< Последний добавленный узел.
+};
\ No newline at end of file
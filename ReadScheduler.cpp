@@ -0,0 +1,188 @@
+#include "ReadScheduler.h"
+#include "Stats.h"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+namespace
+{
+	/// Шаг, с которым затрагиваются страницы отображенного блока
+	constexpr size_t kPageSize = 4096;
+}
+
+FileLayout FileLayout::query(int fd)
+{
+	FileLayout layout;
+#ifndef _WIN32
+	if (fd < 0)
+		return layout;
+	struct stat st {};
+	if (::fstat(fd, &st) == 0) {
+		layout.device_ = static_cast<uint64_t>(st.st_dev);
+		layout.inode_ = static_cast<uint64_t>(st.st_ino);
+	}
+#ifdef __linux__
+	// Запрос с местом под kMaxExtents экстентов; экстенты с неизвестным положением (отложенное выделение) пропускаются
+	std::vector<uint64_t> storage((sizeof(fiemap) + kMaxExtents * sizeof(fiemap_extent) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+	auto* map = reinterpret_cast<fiemap*>(storage.data());
+	map->fm_start = 0;
+	map->fm_length = FIEMAP_MAX_OFFSET;
+	map->fm_extent_count = kMaxExtents;
+	if (::ioctl(fd, FS_IOC_FIEMAP, map) == 0) {
+		for (uint32_t i = 0; i < map->fm_mapped_extents; ++i) {
+			const fiemap_extent& extent = map->fm_extents[i];
+			if (extent.fe_flags & (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DATA_INLINE))
+				continue;
+			layout.extents_.push_back({ extent.fe_logical, extent.fe_physical, extent.fe_length });
+		}
+	}
+#endif
+#endif
+	return layout;
+}
+
+uint64_t FileLayout::position(uint64_t offset) const
+{
+	if (extents_.empty()) {
+		// Порядок inode, внутри файла - по номеру 4-КиБ страницы
+		uint64_t page = std::min<uint64_t>(offset / kPageSize, (uint64_t{ 1 } << kInodeOffsetBits) - 1);
+		return (inode_ << kInodeOffsetBits) | page;
+	}
+	auto next = std::upper_bound(extents_.begin(), extents_.end(), offset, [](uint64_t value, const Extent& extent) {
+		return value < extent.logical;
+		});
+	if (next == extents_.begin())
+		return next->physical;
+	const Extent& extent = *std::prev(next);
+	// Дыра или смещение за последним запрошенным экстентом: положение сразу за предыдущим экстентом
+	if (offset >= extent.logical + extent.length)
+		return extent.physical + extent.length;
+	return extent.physical + (offset - extent.logical);
+}
+
+ReadScheduler::Turn::Turn(ReadScheduler& scheduler, uint64_t device, uint64_t position, size_t length)
+	: scheduler_(scheduler), device_(device), end_(position + length)
+{
+	scheduler_.acquire(device, position);
+}
+
+ReadScheduler::Turn::~Turn()
+{
+	scheduler_.release(device_, end_);
+}
+
+ReadOrder ReadScheduler::parseOrder(std::string_view name)
+{
+	if (name == "default")
+		return ReadOrder::DEFAULT;
+	if (name == "physical")
+		return ReadOrder::PHYSICAL;
+	throw std::invalid_argument("Invalid read order: " + std::string(name));
+}
+
+void ReadScheduler::acquire(uint64_t device, uint64_t position)
+{
+	Stats::add(StatCounter::ORDERED_READS);
+	std::unique_lock<std::mutex> lock(mutex_);
+	Device& queue = devices_[device];
+	if (!queue.busy) {
+		queue.busy = true;
+		return;
+	}
+	Waiter waiter;
+	queue.waiting.emplace(std::make_pair(position, sequence_++), &waiter);
+	waiter.ready.wait(lock, [&waiter]() { return waiter.granted; });
+}
+
+void ReadScheduler::release(uint64_t device, uint64_t end)
+{
+	std::scoped_lock<std::mutex> lock(mutex_);
+	Device& queue = devices_[device];
+	queue.head = end;
+	if (queue.waiting.empty()) {
+		queue.busy = false;
+		return;
+	}
+	// Следующим читает ближайший впереди головки; если впереди никого нет - начинается новый проход
+	auto next = queue.waiting.lower_bound({ queue.head, 0 });
+	if (next == queue.waiting.end()) {
+		next = queue.waiting.begin();
+		Stats::add(StatCounter::READ_SWEEPS);
+	}
+	// Устройство остается занятым: очередь переходит к выбранному чтению
+	next->second->granted = true;
+	next->second->ready.notify_one();
+	queue.waiting.erase(next);
+}
+
+FileLayout ReadScheduler::layout(int fd)
+{
+#ifndef _WIN32
+	struct stat st {};
+	if (fd >= 0 && ::fstat(fd, &st) == 0) {
+		std::pair<uint64_t, uint64_t> key{ static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino) };
+		{
+			std::scoped_lock<std::mutex> lock(layoutMutex_);
+			auto it = layouts_.find(key);
+			if (it != layouts_.end())
+				return it->second;
+		}
+		// FIEMAP выполняется без блокировки; одновременный запрос того же файла дает то же расположение
+		FileLayout layout = FileLayout::query(fd);
+		std::scoped_lock<std::mutex> lock(layoutMutex_);
+		return layouts_.try_emplace(key, std::move(layout)).first->second;
+	}
+#endif
+	return FileLayout::query(fd);
+}
+
+FileLayout ReadScheduler::layout(const std::string& path)
+{
+#ifndef _WIN32
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return FileLayout();
+	FileLayout result = layout(fd);
+	::close(fd);
+	return result;
+#else
+	(void)path;
+	return FileLayout();
+#endif
+}
+
+bool ScheduledBlockReader::open(const std::string& path, uint64_t size)
+{
+	if (!reader_->open(path, size))
+		return false;
+	layout_ = scheduler_.layout(reader_->fd());
+	if (!layout_.mapped())
+		Stats::add(StatCounter::UNMAPPED_FILES);
+	return true;
+}
+
+std::span<const char> ScheduledBlockReader::read(uint64_t offset, size_t length)
+{
+	ReadScheduler::Turn turn(scheduler_, layout_.device(), layout_.position(offset), length);
+	std::span<const char> block = reader_->read(offset, length);
+	if (prefault_) {
+		// Чтение с диска для отображенного файла происходит при первом обращении к странице
+		const volatile char* bytes = block.data();
+		for (size_t i = 0; i < block.size(); i += kPageSize)
+			(void)bytes[i];
+	}
+	return block;
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+/**
+ * @file ReadScheduler.h
+ * @brief Заголовочный файл для классов ReadScheduler, FileLayout и ScheduledBlockReader.
+ *
+ * Классы упорядочивают чтения блоков по физическому расположению на диске.
+ */
+#pragma once
+#include "BlockReader.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @enum ReadOrder
+ * @brief Порядок чтения блоков.
+ */
+enum class ReadOrder
+{
+	DEFAULT, ///< Блоки читаются в порядке сравнения групп.
+	PHYSICAL ///< Блоки читаются по возрастанию физического смещения на устройстве (лифт).
+};
+
+/**
+ * @class FileLayout
+ * @brief Физическое расположение файла на устройстве.
+ *
+ * Экстенты запрашиваются через FIEMAP. Если файловая система его не поддерживает
+ * или у файла нет экстентов (встроенные в inode данные, tmpfs), положение
+ * вычисляется по номеру inode: на большинстве файловых систем данные файлов
+ * с близкими номерами лежат рядом.
+ */
+class FileLayout
+{
+public:
+	/// Наибольшее количество экстентов, запрашиваемых у файла
+	static constexpr size_t kMaxExtents = 64;
+
+	/// Количество младших бит под номер 4-КиБ страницы файла в положении по номеру inode
+	static constexpr unsigned kInodeOffsetBits = 20;
+
+	/**
+	 * @brief Метод для получения расположения открытого файла.
+	 * @param fd Дескриптор файла.
+	 * @return Расположение (пустое, если дескриптор недействителен).
+	 */
+	static FileLayout query(int fd);
+
+	/// Устройство файла
+	uint64_t device() const { return device_; }
+
+	/// Расположение получено через FIEMAP
+	bool mapped() const { return !extents_.empty(); }
+
+	/**
+	 * @brief Метод для получения положения байта файла на устройстве.
+	 * @param offset Смещение в файле.
+	 * @return Физическое смещение (или положение по номеру inode), по которому упорядочиваются чтения.
+	 */
+	uint64_t position(uint64_t offset) const;
+
+private:
+	/// Экстент файла
+	struct Extent
+	{
+		uint64_t logical; ///< Смещение в файле.
+		uint64_t physical; ///< Смещение на устройстве.
+		uint64_t length; ///< Длина, байт.
+	};
+
+	uint64_t device_{ 0 }; ///< Устройство.
+	uint64_t inode_{ 0 }; ///< Номер inode.
+	std::vector<Extent> extents_; ///< Экстенты по возрастанию смещения в файле.
+};
+
+/**
+ * @class ReadScheduler
+ * @brief Очередь чтений каждого устройства в порядке лифта (C-SCAN).
+ *
+ * Поток, которому нужно прочитать блок, ждет своей очереди: устройство в каждый
+ * момент читает один поток, а следующим получает очередь ожидающий с наименьшим
+ * положением не меньше конца предыдущего чтения. Когда впереди ожидающих нет,
+ * головка возвращается к наименьшему положению. Группы сравниваются параллельно,
+ * поэтому их чтения сливаются в один проход по диску вместо случайных перемещений.
+ */
+class ReadScheduler
+{
+public:
+	/**
+	 * @class Turn
+	 * @brief Очередь на чтение: ожидается в конструкторе, освобождается в деструкторе.
+	 */
+	class Turn
+	{
+	public:
+		/**
+		 * @brief Конструктор класса Turn. Ждет очереди устройства.
+		 * @param scheduler Планировщик чтений.
+		 * @param device Устройство.
+		 * @param position Положение начала чтения.
+		 * @param length Длина чтения.
+		 */
+		Turn(ReadScheduler& scheduler, uint64_t device, uint64_t position, size_t length);
+
+		/**
+		 * @brief Деструктор класса Turn. Передает очередь следующему чтению.
+		 */
+		~Turn();
+
+		Turn(const Turn&) = delete;
+		Turn& operator=(const Turn&) = delete;
+
+	private:
+		ReadScheduler& scheduler_; ///< Планировщик чтений.
+		uint64_t device_; ///< Устройство.
+		uint64_t end_; ///< Положение конца чтения.
+	};
+
+	/**
+	 * @brief Метод для получения порядка чтения по названию.
+	 * @param name Название порядка (default, physical).
+	 * @return Порядок чтения.
+	 * @throws std::invalid_argument Если порядок неизвестен.
+	 */
+	static ReadOrder parseOrder(std::string_view name);
+
+	/**
+	 * @brief Метод для получения расположения открытого файла.
+	 *
+	 * Расположение запрашивается один раз для каждого файла (устройство, inode) и
+	 * переиспользуется упорядочиванием групп и всеми последующими открытиями файла.
+	 * @param fd Дескриптор файла.
+	 * @return Расположение файла.
+	 */
+	FileLayout layout(int fd);
+
+	/**
+	 * @brief Метод для получения расположения файла по пути (упорядочивание групп до чтения).
+	 * @param path Путь к файлу.
+	 * @return Расположение (пустое, если файл недоступен).
+	 */
+	FileLayout layout(const std::string& path);
+
+private:
+	/// Ожидающее чтение
+	struct Waiter
+	{
+		std::condition_variable ready; ///< Сигнал получения очереди.
+		bool granted{ false }; ///< Очередь получена.
+	};
+
+	/// Очередь устройства
+	struct Device
+	{
+		bool busy{ false }; ///< Устройство читает.
+		uint64_t head{ 0 }; ///< Положение конца последнего чтения.
+		std::map<std::pair<uint64_t, uint64_t>, Waiter*> waiting; ///< (положение, номер) -> ожидающее чтение.
+	};
+
+	/**
+	 * @brief Метод для ожидания очереди чтения.
+	 * @param device Устройство.
+	 * @param position Положение начала чтения.
+	 */
+	void acquire(uint64_t device, uint64_t position);
+
+	/**
+	 * @brief Метод для передачи очереди следующему ожидающему чтению.
+	 * @param device Устройство.
+	 * @param end Положение конца завершенного чтения.
+	 */
+	void release(uint64_t device, uint64_t end);
+
+	std::mutex mutex_; ///< Мьютекс для синхронизации доступа к очередям.
+	std::unordered_map<uint64_t, Device> devices_; ///< Очереди устройств.
+	uint64_t sequence_{ 0 }; ///< Номер следующего ожидающего чтения (различает чтения одного положения).
+	std::mutex layoutMutex_; ///< Мьютекс для синхронизации доступа к расположениям.
+	std::map<std::pair<uint64_t, uint64_t>, FileLayout> layouts_; ///< (устройство, inode) -> расположение файла.
+};
+
+/**
+ * @class ScheduledBlockReader
+ * @brief Чтение блоков в порядке лифта поверх любого способа чтения.
+ *
+ * При открытии файла по его дескриптору берется расположение, каждое чтение ждет очереди
+ * устройства. Отображенный файл читается при обращении к страницам, поэтому для
+ * mmap страницы блока затрагиваются, пока очередь удерживается.
+ */
+class ScheduledBlockReader : public BlockReader
+{
+public:
+	/**
+	 * @brief Конструктор класса ScheduledBlockReader.
+	 * @param reader Объект чтения блоков.
+	 * @param scheduler Планировщик чтений.
+	 * @param prefault Затрагивать страницы прочитанного блока (для mmap).
+	 */
+	ScheduledBlockReader(std::unique_ptr<BlockReader> reader, ReadScheduler& scheduler, bool prefault)
+		: reader_(std::move(reader)), scheduler_(scheduler), prefault_(prefault)
+	{
+	}
+
+	bool open(const std::string& path, uint64_t size) override;
+	std::span<const char> read(uint64_t offset, size_t length) override;
+	void close() override { reader_->close(); }
+	bool isOpen() const override { return reader_->isOpen(); }
+	int fd() const override { return reader_->fd(); }
+
+private:
+	std::unique_ptr<BlockReader> reader_; ///< Объект чтения блоков.
+	ReadScheduler& scheduler_; ///< Планировщик чтений.
+	bool prefault_; ///< Затрагивать страницы прочитанного блока.
+	FileLayout layout_; ///< Расположение открытого файла.
+};
\ No newline at end of file
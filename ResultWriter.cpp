@@ -0,0 +1,325 @@
+#include "ResultWriter.h"
+#include <stdexcept>
+
+namespace
+{
+	/// Порог размера буфера, после которого он записывается, не дожидаясь опустошения очереди
+	constexpr size_t kFlushThreshold = 1 << 20;
+
+	/**
+	 * @brief Функция для добавления строки JSON с экранированием.
+	 * @param value Строка.
+	 * @param out Буфер вывода.
+	 */
+	void appendJsonString(std::string_view value, std::string& out)
+	{
+		static constexpr char digits[] = "0123456789abcdef";
+		out += '"';
+		for (char c : value) {
+			switch (c) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					out += "\\u00";
+					out += digits[static_cast<unsigned char>(c) >> 4];
+					out += digits[static_cast<unsigned char>(c) & 0x0f];
+				}
+				else {
+					out += c;
+				}
+			}
+		}
+		out += '"';
+	}
+
+	/**
+	 * @brief Функция для добавления поля CSV (в кавычках, если содержит разделители).
+	 * @param value Значение поля.
+	 * @param out Буфер вывода.
+	 */
+	void appendCsvField(std::string_view value, std::string& out)
+	{
+		if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+			out += value;
+			return;
+		}
+		out += '"';
+		for (char c : value) {
+			if (c == '"')
+				out += '"';
+			out += c;
+		}
+		out += '"';
+	}
+
+	std::string_view kindName(ResultGroup::Kind kind)
+	{
+		return kind == ResultGroup::Kind::HARDLINKS ? "hardlinks" : "duplicates";
+	}
+
+	std::string_view actionName(DuplicateAction action)
+	{
+		switch (action) {
+		case DuplicateAction::DELETE: return "delete";
+		case DuplicateAction::HARDLINK: return "hardlink";
+		case DuplicateAction::REFLINK: return "reflink";
+		default: return "report";
+		}
+	}
+
+	/**
+	 * @brief Функция для добавления результата действия в виде JSON-объекта.
+	 * @param action Результат действия.
+	 * @param out Буфер вывода.
+	 */
+	void appendJsonAction(const ResultAction& action, std::string& out)
+	{
+		out += "{\"type\":\"action\",\"action\":\"";
+		out += actionName(action.action);
+		out += "\",\"path\":";
+		appendJsonString(action.path, out);
+		out += ",\"target\":";
+		appendJsonString(action.target, out);
+		out += ",\"dry_run\":";
+		out += action.dryRun ? "true" : "false";
+		out += ",\"status\":\"";
+		out += action.error.empty() ? "ok" : "error";
+		out += '"';
+		if (!action.error.empty()) {
+			out += ",\"error\":";
+			appendJsonString(action.error, out);
+		}
+		out += '}';
+	}
+
+	/**
+	 * @brief Функция для добавления группы в виде JSON-объекта.
+	 * @param group Группа результатов.
+	 * @param out Буфер вывода.
+	 */
+	void appendJsonGroup(const ResultGroup& group, std::string& out)
+	{
+		out += "{\"type\":\"";
+		out += kindName(group.kind);
+		out += "\",\"size\":";
+		out += std::to_string(group.size);
+		if (group.digest.length > 0) {
+			out += ",\"digest\":\"";
+			out += group.digest.toHex();
+			out += '"';
+		}
+		out += ",\"files\":[";
+		for (size_t i = 0; i < group.files.size(); ++i) {
+			const auto& file = group.files[i];
+			if (i > 0)
+				out += ',';
+			out += "{\"path\":";
+			appendJsonString(file.path, out);
+			out += ",\"device\":";
+			out += std::to_string(file.device);
+			out += ",\"inode\":";
+			out += std::to_string(file.inode);
+			out += '}';
+		}
+		out += "]}";
+	}
+}
+
+void TextFormatter::write(const ResultGroup& group, std::string& out)
+{
+	if (group.kind == ResultGroup::Kind::HARDLINKS)
+		out += "Hardlinks to one file (already deduplicated):\n";
+	for (const auto& file : group.files) {
+		out += file.path;
+		out += '\n';
+	}
+	out += '\n'; // Разделяем группы пустой строкой
+}
+
+void TextFormatter::write(const ResultAction& action, std::string& out)
+{
+	static constexpr std::string_view done[] = { "Reported: ", "Deleted: ", "Hardlinked: ", "Reflinked: " };
+	static constexpr std::string_view planned[] = { "Would report: ", "Would delete: ", "Would hardlink: ", "Would reflink: " };
+	auto index = static_cast<size_t>(action.action);
+	if (!action.error.empty()) {
+		out += "Failed to ";
+		out += actionName(action.action);
+		out += ' ';
+		out += action.path;
+		out += ": ";
+		out += action.error;
+		out += '\n';
+		return;
+	}
+	out += action.dryRun ? planned[index] : done[index];
+	out += action.path;
+	if (action.action != DuplicateAction::DELETE) {
+		out += " -> ";
+		out += action.target;
+	}
+	out += '\n';
+}
+
+void NdjsonFormatter::write(const ResultGroup& group, std::string& out)
+{
+	appendJsonGroup(group, out);
+	out += '\n';
+}
+
+void NdjsonFormatter::write(const ResultAction& action, std::string& out)
+{
+	appendJsonAction(action, out);
+	out += '\n';
+}
+
+void JsonFormatter::begin(std::string& out)
+{
+	out += "{\"groups\":[";
+}
+
+void JsonFormatter::write(const ResultGroup& group, std::string& out)
+{
+	out += first_ ? "\n" : ",\n";
+	first_ = false;
+	appendJsonGroup(group, out);
+}
+
+void JsonFormatter::write(const ResultAction& action, std::string& out)
+{
+	if (!actions_) {
+		out += "\n],\"actions\":[";
+		actions_ = true;
+		first_ = true;
+	}
+	out += first_ ? "\n" : ",\n";
+	first_ = false;
+	appendJsonAction(action, out);
+}
+
+void JsonFormatter::end(std::string& out)
+{
+	out += "\n]}\n";
+}
+
+void CsvFormatter::begin(std::string& out)
+{
+	out += "type,group,size,digest,device,inode,path,target,status\n";
+}
+
+void CsvFormatter::write(const ResultGroup& group, std::string& out)
+{
+	std::string digest = group.digest.toHex();
+	for (const auto& file : group.files) {
+		out += kindName(group.kind);
+		out += ',';
+		out += std::to_string(groupNumber_);
+		out += ',';
+		out += std::to_string(group.size);
+		out += ',';
+		out += digest;
+		out += ',';
+		out += std::to_string(file.device);
+		out += ',';
+		out += std::to_string(file.inode);
+		out += ',';
+		appendCsvField(file.path, out);
+		out += ",,\n";
+	}
+	++groupNumber_;
+}
+
+void CsvFormatter::write(const ResultAction& action, std::string& out)
+{
+	out += actionName(action.action);
+	out += ",,,,,,";
+	appendCsvField(action.path, out);
+	out += ',';
+	appendCsvField(action.target, out);
+	out += ',';
+	if (!action.error.empty())
+		appendCsvField("error: " + action.error, out);
+	else
+		out += action.dryRun ? "dry_run" : "ok";
+	out += '\n';
+}
+
+OutputFormat ResultFormatterFactory::parseFormat(std::string_view format)
+{
+	if (format == "text")
+		return OutputFormat::TEXT;
+	else if (format == "ndjson")
+		return OutputFormat::NDJSON;
+	else if (format == "json")
+		return OutputFormat::JSON;
+	else if (format == "csv")
+		return OutputFormat::CSV;
+	throw std::invalid_argument("Invalid output format");
+}
+
+std::unique_ptr<ResultFormatter> ResultFormatterFactory::create(OutputFormat format)
+{
+	switch (format) {
+	case OutputFormat::NDJSON:
+		return std::make_unique<NdjsonFormatter>();
+	case OutputFormat::JSON:
+		return std::make_unique<JsonFormatter>();
+	case OutputFormat::CSV:
+		return std::make_unique<CsvFormatter>();
+	default:
+		return std::make_unique<TextFormatter>();
+	}
+}
+
+ResultWriter::ResultWriter(std::ostream& out, OutputFormat format)
+	: out_(out), formatter_(ResultFormatterFactory::create(format))
+{
+	thread_ = std::thread([this]() { run(); });
+}
+
+ResultWriter::~ResultWriter()
+{
+	finish();
+}
+
+void ResultWriter::finish()
+{
+	if (!thread_.joinable())
+		return;
+	queue_.close();
+	thread_.join();
+}
+
+void ResultWriter::run()
+{
+	std::string buffer;
+	buffer.reserve(kFlushThreshold);
+	formatter_->begin(buffer);
+	std::vector<ResultRecord> records;
+	for (bool open = true; open;) {
+		queue_.wait();
+		open = queue_.popAll(records);
+		for (const auto& record : records) {
+			std::visit([&](const auto& value) { formatter_->write(value, buffer); }, record);
+			if (buffer.size() >= kFlushThreshold)
+				flush(buffer);
+		}
+		records.clear();
+		// Очередь опустела: накопленное отдается потребителю, не дожидаясь конца сканирования
+		flush(buffer);
+	}
+	formatter_->end(buffer);
+	flush(buffer);
+}
+
+void ResultWriter::flush(std::string& buffer)
+{
+	if (buffer.empty())
+		return;
+	out_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	out_.flush();
+	buffer.clear();
+}
\ No newline at end of file
@@ -0,0 +1,277 @@
+/**
+ * @file ResultWriter.h
+ * @brief Заголовочный файл для классов вывода результатов.
+ *
+ * Рабочие потоки передают найденные группы в неблокирующую очередь, а единственный
+ * поток вывода форматирует их и пишет крупными буферами по мере поступления.
+ */
+#pragma once
+#include "Digest.h"
+#include "MpscQueue.h"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+/**
+ * @enum OutputFormat
+ * @brief Формат вывода результатов.
+ */
+enum class OutputFormat
+{
+	TEXT = 0, ///< Пути группы по одному в строке, группы разделены пустой строкой.
+	NDJSON, ///< Один JSON-объект на группу в строке.
+	JSON, ///< Один JSON-документ со всеми группами.
+	CSV ///< Одна строка CSV на файл.
+};
+
+/// Файл в группе результатов
+struct ResultFile
+{
+	std::string path; ///< Путь к файлу.
+	uint64_t device{ 0 }; ///< Идентификатор устройства.
+	uint64_t inode{ 0 }; ///< Номер inode.
+	int64_t mtime{ 0 }; ///< Время изменения при сканировании, нс (не выводится).
+};
+
+/// Группа результатов
+struct ResultGroup
+{
+	/// Вид группы
+	enum class Kind
+	{
+		DUPLICATES, ///< Файлы с одинаковым содержимым.
+		HARDLINKS ///< Пути к одному физическому файлу.
+	};
+
+	Kind kind{ Kind::DUPLICATES }; ///< Вид группы.
+	uint64_t size{ 0 }; ///< Размер файлов.
+	Digest digest; ///< Хэш содержимого (хэш поблочных хэшей; пустой для HARDLINKS).
+	std::vector<ResultFile> files; ///< Файлы группы.
+};
+
+/**
+ * @enum DuplicateAction
+ * @brief Действие над найденными дубликатами (первый файл группы сохраняется).
+ */
+enum class DuplicateAction
+{
+	REPORT = 0, ///< Только вывести группы.
+	DELETE, ///< Удалить дубликаты.
+	HARDLINK, ///< Заменить дубликаты жесткими ссылками на сохраняемый файл.
+	REFLINK ///< Заменить дубликаты копиями без копирования данных (FICLONE).
+};
+
+/// Результат действия над одним дубликатом
+struct ResultAction
+{
+	DuplicateAction action{ DuplicateAction::REPORT }; ///< Действие.
+	std::string path; ///< Путь к дубликату.
+	std::string target; ///< Путь к сохраняемому файлу.
+	bool dryRun{ false }; ///< Действие только показано, файлы не изменены.
+	std::string error; ///< Текст ошибки (пусто - успешно).
+};
+
+/// Запись очереди вывода
+using ResultRecord = std::variant<ResultGroup, ResultAction>;
+
+/**
+ * @class IGroupSink
+ * @brief Интерфейс получателя найденных групп дубликатов помимо потока вывода.
+ */
+class IGroupSink
+{
+public:
+	/**
+	 * @brief Деструктор класса IGroupSink.
+	 */
+	virtual ~IGroupSink() = default;
+
+	/**
+	 * @brief Метод для передачи найденной группы дубликатов. Вызывается из рабочих потоков.
+	 * @param group Группа дубликатов.
+	 */
+	virtual void submit(const ResultGroup& group) = 0;
+};
+
+/**
+ * @class ResultFormatter
+ * @brief Интерфейс форматирования групп результатов.
+ */
+class ResultFormatter
+{
+public:
+	/**
+	 * @brief Деструктор класса ResultFormatter.
+	 */
+	virtual ~ResultFormatter() = default;
+
+	/**
+	 * @brief Метод для вывода начала документа.
+	 * @param out Буфер вывода.
+	 */
+	virtual void begin(std::string& /*out*/) {}
+
+	/**
+	 * @brief Метод для вывода группы.
+	 * @param group Группа результатов.
+	 * @param out Буфер вывода.
+	 */
+	virtual void write(const ResultGroup& group, std::string& out) = 0;
+
+	/**
+	 * @brief Метод для вывода результата действия над дубликатом.
+	 * @param action Результат действия.
+	 * @param out Буфер вывода.
+	 */
+	virtual void write(const ResultAction& action, std::string& out) = 0;
+
+	/**
+	 * @brief Метод для вывода конца документа.
+	 * @param out Буфер вывода.
+	 */
+	virtual void end(std::string& /*out*/) {}
+};
+
+/**
+ * @class TextFormatter
+ * @brief Текстовый вывод: пути по одному в строке, группы разделены пустой строкой.
+ */
+class TextFormatter : public ResultFormatter
+{
+public:
+	void write(const ResultGroup& group, std::string& out) override;
+	void write(const ResultAction& action, std::string& out) override;
+};
+
+/**
+ * @class NdjsonFormatter
+ * @brief Вывод по одному JSON-объекту на группу в строке.
+ */
+class NdjsonFormatter : public ResultFormatter
+{
+public:
+	void write(const ResultGroup& group, std::string& out) override;
+	void write(const ResultAction& action, std::string& out) override;
+};
+
+/**
+ * @class JsonFormatter
+ * @brief Вывод одного JSON-документа {"groups":[...],"actions":[...]}.
+ *
+ * Действия выполняются после поиска всех групп, поэтому массив actions открывается первым действием.
+ */
+class JsonFormatter : public ResultFormatter
+{
+public:
+	void begin(std::string& out) override;
+	void write(const ResultGroup& group, std::string& out) override;
+	void write(const ResultAction& action, std::string& out) override;
+	void end(std::string& out) override;
+
+private:
+	bool first_{ true }; ///< Признак первого элемента текущего массива.
+	bool actions_{ false }; ///< Открыт массив actions.
+};
+
+/**
+ * @class CsvFormatter
+ * @brief Вывод CSV: строка на файл с номером группы или на действие.
+ */
+class CsvFormatter : public ResultFormatter
+{
+public:
+	void begin(std::string& out) override;
+	void write(const ResultGroup& group, std::string& out) override;
+	void write(const ResultAction& action, std::string& out) override;
+
+private:
+	uint64_t groupNumber_{ 0 }; ///< Номер следующей группы.
+};
+
+/**
+ * @class ResultFormatterFactory
+ * @brief Класс для создания объектов форматирования результатов.
+ */
+class ResultFormatterFactory
+{
+public:
+	/**
+	 * @brief Метод для получения формата по названию.
+	 * @param format Название формата.
+	 * @return Формат вывода.
+	 */
+	static OutputFormat parseFormat(std::string_view format);
+
+	/**
+	 * @brief Метод для создания объекта форматирования.
+	 * @param format Формат вывода.
+	 * @return Указатель на объект форматирования.
+	 */
+	static std::unique_ptr<ResultFormatter> create(OutputFormat format);
+};
+
+/**
+ * @class ResultWriter
+ * @brief Поток вывода результатов.
+ *
+ * Группы добавляются из любых потоков без блокировок; поток вывода забирает
+ * все накопленные группы, форматирует их в буфер и записывает его одним вызовом,
+ * как только очередь опустела, поэтому потребитель получает группы во время сканирования.
+ */
+class ResultWriter
+{
+public:
+	/**
+	 * @brief Конструктор класса ResultWriter. Запускает поток вывода.
+	 * @param out Поток, в который выводятся результаты.
+	 * @param format Формат вывода.
+	 */
+	ResultWriter(std::ostream& out, OutputFormat format);
+
+	/**
+	 * @brief Деструктор класса ResultWriter. Дописывает оставшиеся группы.
+	 */
+	~ResultWriter();
+
+	ResultWriter(const ResultWriter&) = delete;
+	ResultWriter& operator=(const ResultWriter&) = delete;
+
+	/**
+	 * @brief Метод для добавления группы в очередь вывода.
+	 * @param group Группа результатов.
+	 */
+	void push(ResultGroup group) { queue_.push(std::move(group)); }
+
+	/**
+	 * @brief Метод для добавления результата действия в очередь вывода.
+	 * @param action Результат действия.
+	 */
+	void push(ResultAction action) { queue_.push(std::move(action)); }
+
+	/**
+	 * @brief Метод для завершения вывода: дожидается записи всех групп и конца документа.
+	 */
+	void finish();
+
+private:
+	/**
+	 * @brief Метод потока вывода.
+	 */
+	void run();
+
+	/**
+	 * @brief Метод для записи буфера в поток вывода.
+	 * @param buffer Буфер (очищается).
+	 */
+	void flush(std::string& buffer);
+
+	std::ostream& out_; ///< Поток вывода.
+	std::unique_ptr<ResultFormatter> formatter_; ///< Объект форматирования.
+	MpscQueue<ResultRecord> queue_; ///< Очередь групп и результатов действий.
+	std::thread thread_; ///< Поток вывода.
+};
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "SampleFilter.h"
+#include "Stats.h"
+#include <iostream>
+#include <unordered_map>
+
+std::vector<uint64_t> SampleFilter::offsets(uint64_t fileSize) const
+{
+	std::vector<uint64_t> result{ 0 };
+	if (fileSize <= kSampleSize)
+		return result;
+	// Промежуточные блоки выровнены по размеру блока, последний заканчивается концом файла
+	uint64_t last = fileSize - kSampleSize;
+	for (size_t i = 1; i + 1 < sampleCount_; ++i) {
+		uint64_t offset = last / (sampleCount_ - 1) * i / kSampleSize * kSampleSize;
+		if (offset > result.back())
+			result.push_back(offset);
+	}
+	if (last > result.back())
+		result.push_back(last);
+	return result;
+}
+
+std::vector<std::vector<size_t>> SampleFilter::partition(const std::vector<std::string>& paths, uint64_t fileSize)
+{
+	auto sampleOffsets = offsets(fileSize);
+	std::unordered_map<Digest, std::vector<size_t>, DigestHash> digestToIndices;
+	std::vector<char> samples;
+	DescriptorBudget::Holder descriptors;
+	for (size_t index = 0; index < paths.size(); ++index) {
+		budget_.acquire(descriptors);
+		auto reader = BlockReaderFactory::create(ioMode_, cachePolicy_, scheduler_);
+		if (!reader->open(paths[index], fileSize)) {
+			budget_.release(descriptors);
+			Stats::add(StatCounter::FILES_FAILED);
+			std::cerr << "Failed to open file: " << paths[index] << ". File will be skipped." << std::endl;
+			continue;
+		}
+		// Выборочные блоки хэшируются одним буфером: на файл вычисляется один хэш
+		samples.clear();
+		for (uint64_t offset : sampleOffsets) {
+			auto block = reader->read(offset, static_cast<size_t>(std::min<uint64_t>(kSampleSize, fileSize - offset)));
+			samples.insert(samples.end(), block.begin(), block.end());
+			Stats::add(StatCounter::BYTES_READ, block.size());
+			Stats::add(StatCounter::BLOCKS_READ);
+		}
+		reader->close();
+		budget_.release(descriptors);
+		Stats::add(StatCounter::SAMPLED_FILES);
+		digestToIndices[hashCalculator_.calculateHash(samples)].push_back(index);
+	}
+
+	std::vector<std::vector<size_t>> groups;
+	for (auto& [digest, indices] : digestToIndices) {
+		if (indices.size() > 1)
+			groups.push_back(std::move(indices));
+		else
+			Stats::add(StatCounter::SAMPLE_ELIMINATED);
+	}
+	return groups;
+}
\ No newline at end of file
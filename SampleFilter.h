@@ -0,0 +1,82 @@
+/**
+ * @file SampleFilter.h
+ * @brief Заголовочный файл для класса SampleFilter.
+ *
+ * Класс SampleFilter отсеивает файлы одного размера по хэшу нескольких выборочных блоков.
+ */
+#pragma once
+#include "BlockReader.h"
+#include "DescriptorBudget.h"
+#include "HashCalculator.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class SampleFilter
+ * @brief Предварительное разбиение группы по выборочным блокам.
+ *
+ * У каждого файла читаются первый и последний блоки и блоки через равные промежутки
+ * между ними; группа делится по хэшу выборки до последовательного чтения. Файлы с
+ * одинаковыми заголовками, отличающиеся ближе к концу (образы, журналы, базы данных),
+ * отсеиваются за несколько КиБ чтения вместо чтения целиком. Совпадение выборки
+ * дубликатов не доказывает, поэтому оставшиеся группы сравниваются полностью.
+ */
+class SampleFilter
+{
+public:
+	/// Размер выборочного блока
+	static constexpr size_t kSampleSize = 4096;
+
+	/// Наибольшее количество выборочных блоков
+	static constexpr size_t kMaxSamples = 64;
+
+	/// Файлы меньше этого размера сравниваются сразу: выборка почти не экономит чтение
+	static constexpr uint64_t kMinFileSize = 1 << 20;
+
+	/**
+	 * @brief Конструктор класса SampleFilter.
+	 * @param ioMode Способ чтения файлов.
+	 * @param cachePolicy Использование страничного кэша.
+	 * @param budget Общий бюджет открытых файлов.
+	 * @param hashCalculator Калькулятор хэшей.
+	 * @param sampleCount Количество выборочных блоков (0 - выборка отключена, иначе не меньше двух: первый и последний).
+	 * @param scheduler Планировщик чтений в физическом порядке (может отсутствовать).
+	 */
+	SampleFilter(IoMode ioMode, CachePolicy cachePolicy, DescriptorBudget& budget, const HashCalculator& hashCalculator, size_t sampleCount, ReadScheduler* scheduler = nullptr)
+		: ioMode_(ioMode), cachePolicy_(cachePolicy), budget_(budget), hashCalculator_(hashCalculator), sampleCount_(sampleCount == 0 ? 0 : std::clamp<size_t>(sampleCount, 2, kMaxSamples)), scheduler_(scheduler)
+	{
+	}
+
+	/**
+	 * @brief Метод для проверки, выполняется ли выборка для файлов заданного размера.
+	 * @param fileSize Размер файлов.
+	 * @return true, если выборка включена и файлы достаточно велики.
+	 */
+	bool applies(uint64_t fileSize) const { return sampleCount_ > 0 && fileSize >= kMinFileSize; }
+
+	/**
+	 * @brief Метод для разбиения файлов на группы с одинаковой выборкой.
+	 * @param paths Пути к файлам одного размера.
+	 * @param fileSize Размер файлов.
+	 * @return Группы из двух и более файлов (индексы в paths); файлы с уникальной выборкой и неоткрывшиеся исключаются.
+	 */
+	std::vector<std::vector<size_t>> partition(const std::vector<std::string>& paths, uint64_t fileSize);
+
+	/**
+	 * @brief Метод для получения смещений выборочных блоков.
+	 * @param fileSize Размер файлов.
+	 * @return Смещения по возрастанию: первый блок, промежуточные (выровнены по kSampleSize) и последний.
+	 */
+	std::vector<uint64_t> offsets(uint64_t fileSize) const;
+
+private:
+	IoMode ioMode_; ///< Способ чтения файлов.
+	CachePolicy cachePolicy_; ///< Использование страничного кэша.
+	DescriptorBudget& budget_; ///< Общий бюджет открытых файлов.
+	const HashCalculator& hashCalculator_; ///< Калькулятор хэшей.
+	size_t sampleCount_; ///< Количество выборочных блоков.
+	ReadScheduler* scheduler_; ///< Планировщик чтений.
+};
\ No newline at end of file
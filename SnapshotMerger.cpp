@@ -0,0 +1,128 @@
+#include "SnapshotMerger.h"
+#include "Stats.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <span>
+#include <string>
+#include <tuple>
+#include <utility>
+
+SnapshotMerger::SnapshotMerger(const ArgumentParser::ParserData& data, ThreadPool& pool)
+	: data_(data)
+{
+	std::vector<std::string> originNames;
+	snapshots_.resize(data.mergeSnapshots.size());
+	for (size_t shard = 0; shard < snapshots_.size(); ++shard) {
+		IndexSnapshot& snapshot = snapshots_[shard];
+		snapshot.open(data.mergeSnapshots[shard]);
+		auto origin = std::find(originNames.begin(), originNames.end(), snapshot.origin());
+		origins_.push_back(static_cast<uint32_t>(origin - originNames.begin()));
+		if (origin == originNames.end())
+			originNames.push_back(snapshot.origin());
+		bool usable = snapshot.compatible(*data.hashAlgorithm, data.blockSchedule);
+		if (!usable)
+			std::cerr << "Warning: Index snapshot " << snapshot.path() << " was written with another hash algorithm or block size. Its hashes are ignored." << std::endl;
+		digestsUsable_.push_back(usable);
+	}
+	cache_ = std::make_unique<HashCache>("", *data.hashAlgorithm, data.blockSchedule);
+
+	// Секции разных диапазонов размеров не пересекаются и просматриваются параллельно
+	std::vector<std::vector<Candidate>> sections(IndexSnapshot::kSectionCount);
+	{
+		TaskGroup tasks(pool);
+		for (size_t section = 0; section < sections.size(); ++section) {
+			tasks.run([this, section, &sections]() {
+				sections[section] = collisions(section);
+				});
+		}
+		tasks.wait();
+	}
+
+	// Директория снимка добавляется в индекс как корень с полным путем. Пути других машин получают префикс
+	// имени машины: такой файл не открывается, а сравнивается только по хэшам из снимка, поэтому файл
+	// другой машины без хэшей всех блоков в индекс не попадает
+	std::string host = IndexSnapshot::hostName();
+	std::map<std::pair<uint32_t, uint32_t>, DirectoryId> directories;
+	std::vector<Digest> digests;
+	size_t unhashedFiles = 0;
+	for (const auto& candidates : sections) {
+		for (const Candidate& candidate : candidates) {
+			const IndexSnapshot& snapshot = snapshots_[candidate.shard];
+			const IndexSnapshot::Entry& entry = candidate.entry;
+			bool hashed = digestsUsable_[candidate.shard] && entry.digestCount >= data.blockSchedule.blockCount(entry.key.size);
+			if (snapshot.origin() != host && !hashed) {
+				++unhashedFiles;
+				continue;
+			}
+			auto [it, inserted] = directories.try_emplace({ candidate.shard, entry.directory }, 0);
+			if (inserted) {
+				std::string name(snapshot.directory(entry.directory));
+				if (snapshot.origin() != host)
+					name = snapshot.origin() + ":" + name;
+				it->second = index_.addDirectory(FileIndex::kNoDirectory, name);
+			}
+			files_.push_back(index_.addFile(it->second, entry.name, entry.key));
+			shards_.push_back(candidate.shard);
+			if (!digestsUsable_[candidate.shard] || entry.digestCount == 0)
+				continue;
+			digests.clear();
+			for (uint32_t d = 0; d < entry.digestCount; ++d)
+				digests.emplace_back(entry.digests + d * snapshot.digestSize(), snapshot.digestSize());
+			cache_->store(entry.key, digests);
+		}
+	}
+	if (unhashedFiles > 0)
+		std::cerr << "Warning: " << unhashedFiles << " files of other hosts have no hashes of all blocks in their snapshots and are skipped" << std::endl;
+	Stats::add(StatCounter::MERGE_CANDIDATE_FILES, files_.size());
+
+	for (size_t first = 0; first < files_.size();) {
+		uintmax_t fileSize = index_.key(files_[first]).size;
+		size_t last = first + 1;
+		while (last < files_.size() && index_.key(files_[last]).size == fileSize)
+			++last;
+		fileGroups_.push_back({ fileSize, std::span<const FileId>(files_).subspan(first, last - first) });
+		first = last;
+	}
+}
+
+std::vector<SnapshotMerger::Candidate> SnapshotMerger::collisions(size_t section) const
+{
+	std::vector<Candidate> candidates;
+	for (uint32_t shard = 0; shard < snapshots_.size(); ++shard) {
+		for (const auto& part : snapshots_[shard].sections()) {
+			if (IndexSnapshot::sectionOf(part.minSize) != section || part.maxSize < data_.minFileSize || part.minSize > data_.maxFileSize)
+				continue;
+			Stats::add(StatCounter::SNAPSHOT_FILES, part.count);
+			for (const auto& entry : snapshots_[shard].entries(part)) {
+				if (entry.key.size >= data_.minFileSize && entry.key.size <= data_.maxFileSize)
+					candidates.push_back({ shard, entry });
+			}
+		}
+	}
+	// Файлы одного размера оказываются рядом в порядке снимков
+	std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) {
+		return lhs.entry.key.size < rhs.entry.key.size;
+		});
+
+	std::vector<Candidate> result;
+	for (size_t first = 0; first < candidates.size();) {
+		size_t last = first + 1;
+		while (last < candidates.size() && candidates[last].entry.key.size == candidates[first].entry.key.size)
+			++last;
+		// Один физический файл из нескольких снимков одной машины остается в первом из них
+		std::set<std::tuple<uint32_t, uint64_t, uint64_t>> seen;
+		std::vector<Candidate> files;
+		for (size_t i = first; i < last; ++i) {
+			const Candidate& candidate = candidates[i];
+			if (seen.emplace(origins_[candidate.shard], candidate.entry.key.device, candidate.entry.key.inode).second)
+				files.push_back(candidate);
+		}
+		// Размер из одного снимка уже сравнен при его сканировании
+		if (files.front().shard != files.back().shard)
+			result.insert(result.end(), files.begin(), files.end());
+		first = last;
+	}
+	return result;
+}
\ No newline at end of file
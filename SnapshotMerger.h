@@ -0,0 +1,78 @@
+/**
+ * @file SnapshotMerger.h
+ * @brief Заголовочный файл для класса SnapshotMerger.
+ *
+ * Класс SnapshotMerger объединяет снимки индексов нескольких машин и готовит
+ * к сравнению только файлы размеров, встречающихся в нескольких снимках.
+ */
+#pragma once
+#include "ArgumentParser.h"
+#include "FileCollector.h"
+#include "FileIndex.h"
+#include "HashCache.h"
+#include "IndexSnapshot.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @class SnapshotMerger
+ * @brief Слияние снимков индексов, записанных --export-index.
+ *
+ * Секции одного диапазона размеров всех снимков просматриваются параллельными задачами
+ * пула; в индекс попадают только размеры, файлы которых есть хотя бы в двух снимках
+ * (дубликаты внутри одного снимка найдены при его сканировании). Хэши из снимков
+ * записываются в кэш в памяти, поэтому FileComparator читает файл только ради блоков,
+ * хэшей которых в снимке нет. Пути файлов других машин получают префикс "машина:" и не
+ * открываются: такие файлы сравниваются только по хэшам из снимка, а файлы без хэшей
+ * всех блоков (недоступные при записи снимка или с другим алгоритмом) пропускаются. Один физический файл из нескольких снимков одной машины учитывается один раз.
+ */
+class SnapshotMerger
+{
+public:
+	/**
+	 * @brief Конструктор класса SnapshotMerger. Читает снимки и отбирает файлы для сравнения.
+	 * @param data Данные, полученные из аргументов командной строки.
+	 * @param pool Пул потоков для просмотра секций.
+	 * @throws std::runtime_error Если снимок недоступен или поврежден.
+	 */
+	SnapshotMerger(const ArgumentParser::ParserData& data, ThreadPool& pool);
+
+	/// Индекс отобранных файлов
+	const FileIndex& index() const { return index_; }
+
+	/// Группы файлов одного размера из нескольких снимков
+	const FileGroups& fileGroups() const { return fileGroups_; }
+
+	/// Номер снимка каждого файла индекса
+	const std::vector<uint32_t>& shards() const { return shards_; }
+
+	/// Кэш с хэшами из снимков
+	HashCache& cache() { return *cache_; }
+
+private:
+	/// Файл снимка, отобранный для сравнения
+	struct Candidate
+	{
+		uint32_t shard; ///< Номер снимка.
+		IndexSnapshot::Entry entry; ///< Файл.
+	};
+
+	/**
+	 * @brief Метод для отбора файлов секции, размер которых встречается в нескольких снимках.
+	 * @param section Номер секции.
+	 * @return Отобранные файлы в порядке возрастания размера.
+	 */
+	std::vector<Candidate> collisions(size_t section) const;
+
+	const ArgumentParser::ParserData& data_; ///< Данные, полученные из аргументов командной строки.
+	std::vector<IndexSnapshot> snapshots_; ///< Снимки.
+	std::vector<uint32_t> origins_; ///< Номер машины каждого снимка (снимки одной машины имеют один номер).
+	std::vector<bool> digestsUsable_; ///< Хэши снимка сравнимы с хэшами текущего запуска.
+	std::unique_ptr<HashCache> cache_; ///< Кэш хэшей в памяти.
+	FileIndex index_; ///< Отобранные файлы.
+	std::vector<uint32_t> shards_; ///< Номер снимка каждого файла индекса.
+	std::vector<FileId> files_; ///< Файлы, отсортированные по размеру (на них ссылаются fileGroups_).
+	FileGroups fileGroups_; ///< Группы файлов.
+};
\ No newline at end of file
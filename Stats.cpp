@@ -0,0 +1,281 @@
+#include "Stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kCounters = static_cast<size_t>(StatCounter::COUNT);
+	constexpr size_t kHistograms = static_cast<size_t>(StatHistogram::COUNT);
+
+	/// Блок счетчиков одного потока
+	struct ThreadStats
+	{
+		std::array<std::atomic<uint64_t>, kCounters> counters{};
+		std::array<std::array<std::atomic<uint64_t>, Stats::kMaxBuckets>, kHistograms> buckets{};
+		std::array<std::atomic<uint64_t>, kHistograms> sums{};
+	};
+
+	/// Блоки всех потоков: живут до конца программы, поэтому переживают завершившиеся потоки
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadStats>> threads;
+	};
+
+	Registry& registry()
+	{
+		static Registry instance;
+		return instance;
+	}
+
+	ThreadStats& threadStats()
+	{
+		thread_local ThreadStats* local = []() {
+			auto& reg = registry();
+			std::scoped_lock<std::mutex> lock(reg.mutex);
+			return reg.threads.emplace_back(std::make_unique<ThreadStats>()).get();
+			}();
+		return *local;
+	}
+
+	/// Увеличение значения, которое пишет только текущий поток: без атомарной RMW-операции
+	void increment(std::atomic<uint64_t>& value, uint64_t delta)
+	{
+		value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+	}
+
+	std::atomic<bool> timersEnabled{ false };
+
+	/// Верхние границы корзин глубины отсева, блоков (последняя корзина - +Inf)
+	constexpr std::array<uint64_t, 11> kDepthBounds{ 1, 2, 3, 4, 8, 16, 32, 64, 128, 256, 1024 };
+
+	/// Верхние границы корзин прочитанных на группу байт
+	constexpr std::array<uint64_t, 7> kGroupBytesBounds{ 4ull << 10, 64ull << 10, 1ull << 20, 16ull << 20, 256ull << 20, 4ull << 30, 64ull << 30 };
+
+	std::span<const uint64_t> bounds(StatHistogram histogram)
+	{
+		if (histogram == StatHistogram::ELIMINATION_DEPTH)
+			return kDepthBounds;
+		return kGroupBytesBounds;
+	}
+
+	double seconds(uint64_t nanos)
+	{
+		return static_cast<double>(nanos) / 1e9;
+	}
+
+	/// Пропускная способность хэширования на поток, МБ/с
+	double hashMegabytesPerSecond(const Stats::Snapshot& snapshot)
+	{
+		uint64_t nanos = snapshot[StatCounter::HASH_NANOS];
+		return nanos == 0 ? 0.0 : static_cast<double>(snapshot[StatCounter::HASHED_BYTES]) * 1e3 / static_cast<double>(nanos);
+	}
+
+	/// Описание счетчика для Prometheus
+	struct CounterInfo
+	{
+		StatCounter counter;
+		const char* name;
+		const char* help;
+	};
+
+	constexpr CounterInfo kCounterInfo[] = {
+		{ StatCounter::TOTAL_NANOS, "bayan_run_seconds_total", "Wall time of the whole run." },
+		{ StatCounter::WALK_NANOS, "bayan_walk_seconds_total", "Wall time of the directory walk." },
+		{ StatCounter::DIRECTORIES, "bayan_walk_directories_total", "Directories read." },
+		{ StatCounter::ENTRIES, "bayan_walk_entries_total", "Directory entries seen." },
+		{ StatCounter::STAT_CALLS, "bayan_walk_stat_calls_total", "stat calls made by the walk." },
+		{ StatCounter::FILES_COLLECTED, "bayan_walk_files_total", "Files that passed the masks and the minimum size." },
+		{ StatCounter::ALIAS_PATHS, "bayan_walk_alias_paths_total", "Paths collapsed as hardlinks to an already collected file." },
+		{ StatCounter::COMPARE_NANOS, "bayan_compare_seconds_total", "Wall time of the group comparison." },
+		{ StatCounter::SIZE_GROUPS, "bayan_compare_size_groups_total", "Same-size groups compared." },
+		{ StatCounter::CANDIDATE_FILES, "bayan_compare_candidate_files_total", "Files in compared groups." },
+		{ StatCounter::CANDIDATE_BYTES, "bayan_compare_candidate_bytes_total", "Total size of files in compared groups." },
+		{ StatCounter::BYTES_READ, "bayan_read_bytes_total", "Bytes read from disk." },
+		{ StatCounter::BLOCKS_READ, "bayan_read_blocks_total", "Blocks read from disk." },
+		{ StatCounter::CACHED_BYTES, "bayan_cache_bytes_total", "Bytes whose block hashes came from the cache." },
+		{ StatCounter::FILES_FAILED, "bayan_compare_failed_files_total", "Files that could not be opened." },
+		{ StatCounter::GROUPS_READ_TO_END, "bayan_compare_groups_read_to_end_total", "Same-size groups in which some files had to be read to the end." },
+		{ StatCounter::FILES_READ_TO_END, "bayan_compare_files_read_to_end_total", "Files read to the end (duplicates)." },
+		{ StatCounter::DUPLICATE_GROUPS, "bayan_duplicate_groups_total", "Duplicate groups found." },
+		{ StatCounter::DIRECT_GROUPS, "bayan_compare_direct_groups_total", "Same-size groups compared byte by byte without hashing." },
+		{ StatCounter::VERIFIED_GROUPS, "bayan_verify_groups_total", "Hash-equal groups confirmed byte by byte." },
+		{ StatCounter::VERIFY_MISMATCHES, "bayan_verify_mismatched_files_total", "Files split off hash-equal groups by byte verification (hash collisions)." },
+		{ StatCounter::SAMPLED_FILES, "bayan_sample_files_total", "Files whose sample blocks were hashed before full comparison." },
+		{ StatCounter::SAMPLE_ELIMINATED, "bayan_sample_eliminated_files_total", "Files found unique by their sample blocks." },
+		{ StatCounter::ACTIONS_DONE, "bayan_actions_total", "Duplicate actions performed (or printed with --dry-run)." },
+		{ StatCounter::ACTIONS_FAILED, "bayan_actions_failed_total", "Duplicate actions that failed." },
+		{ StatCounter::ACTION_NANOS, "bayan_action_seconds_total", "Wall time of the duplicate actions." },
+		{ StatCounter::ORDERED_READS, "bayan_read_order_reads_total", "Block reads issued in physical elevator order." },
+		{ StatCounter::READ_SWEEPS, "bayan_read_order_sweeps_total", "Times the read elevator wrapped back to the lowest waiting position." },
+		{ StatCounter::UNMAPPED_FILES, "bayan_read_order_unmapped_files_total", "Files ordered by inode number because FIEMAP gave no extents." },
+		{ StatCounter::DEVICE_QUEUED_TASKS, "bayan_device_queued_tasks_total", "Directory and group tasks that waited in the queue of a device at its --device-jobs limit." },
+		{ StatCounter::SNAPSHOT_FILES, "bayan_merge_snapshot_files_total", "Files read from index snapshots in --merge mode." },
+		{ StatCounter::MERGE_CANDIDATE_FILES, "bayan_merge_candidate_files_total", "Snapshot files whose size occurs in several snapshots." },
+		{ StatCounter::SPLIT_ROUNDS, "bayan_split_rounds_total", "Block rounds of a large size group read and hashed by several pool tasks." },
+	};
+
+	/// Описание гистограммы для Prometheus
+	struct HistogramInfo
+	{
+		StatHistogram histogram;
+		const char* name;
+		const char* help;
+	};
+
+	constexpr HistogramInfo kHistogramInfo[] = {
+		{ StatHistogram::ELIMINATION_DEPTH, "bayan_elimination_depth_blocks", "Blocks compared before a file was found to be unique." },
+		{ StatHistogram::GROUP_BYTES_READ, "bayan_group_read_bytes", "Bytes read from disk per same-size group." },
+	};
+}
+
+void Stats::enable()
+{
+	timersEnabled.store(true, std::memory_order_relaxed);
+}
+
+bool Stats::enabled()
+{
+	return timersEnabled.load(std::memory_order_relaxed);
+}
+
+void Stats::add(StatCounter counter, uint64_t value)
+{
+	increment(threadStats().counters[static_cast<size_t>(counter)], value);
+}
+
+void Stats::observe(StatHistogram histogram, uint64_t value)
+{
+	auto limits = bounds(histogram);
+	size_t bucket = static_cast<size_t>(std::lower_bound(limits.begin(), limits.end(), value) - limits.begin());
+	auto& local = threadStats();
+	increment(local.buckets[static_cast<size_t>(histogram)][bucket], 1);
+	increment(local.sums[static_cast<size_t>(histogram)], value);
+}
+
+Stats::Snapshot Stats::snapshot()
+{
+	Snapshot result;
+	auto& reg = registry();
+	std::scoped_lock<std::mutex> lock(reg.mutex);
+	for (const auto& local : reg.threads) {
+		for (size_t i = 0; i < kCounters; ++i)
+			result.counters[i] += local->counters[i].load(std::memory_order_relaxed);
+		for (size_t h = 0; h < kHistograms; ++h) {
+			for (size_t b = 0; b < kMaxBuckets; ++b)
+				result.buckets[h][b] += local->buckets[h][b].load(std::memory_order_relaxed);
+			result.sums[h] += local->sums[h].load(std::memory_order_relaxed);
+		}
+	}
+	return result;
+}
+
+void Stats::printSummary(std::ostream& out, std::string_view algorithm)
+{
+	Snapshot s = snapshot();
+	auto flags = out.flags();
+	out << std::fixed << std::setprecision(3);
+	out << "Stats:" << std::endl;
+	out << "  Total time: " << seconds(s[StatCounter::TOTAL_NANOS]) << " s" << std::endl;
+	out << "  Walk: " << seconds(s[StatCounter::WALK_NANOS]) << " s, " << s[StatCounter::DIRECTORIES] << " directories, "
+		<< s[StatCounter::ENTRIES] << " entries, " << s[StatCounter::STAT_CALLS] << " stat calls, "
+		<< s[StatCounter::FILES_COLLECTED] << " files, " << s[StatCounter::ALIAS_PATHS] << " hardlink paths collapsed" << std::endl;
+	out << "  Compare: " << seconds(s[StatCounter::COMPARE_NANOS]) << " s, " << s[StatCounter::SIZE_GROUPS] << " size groups, "
+		<< s[StatCounter::CANDIDATE_FILES] << " candidate files, " << s[StatCounter::CANDIDATE_BYTES] << " candidate bytes" << std::endl;
+	out << "  Read: " << s[StatCounter::BYTES_READ] << " bytes in " << s[StatCounter::BLOCKS_READ] << " blocks, "
+		<< s[StatCounter::CACHED_BYTES] << " bytes from cache, " << s[StatCounter::FILES_FAILED] << " files failed to open" << std::endl;
+	out << "  Hash (" << algorithm << "): " << s[StatCounter::HASHED_BYTES] << " bytes in " << seconds(s[StatCounter::HASH_NANOS])
+		<< " s, " << std::setprecision(1) << hashMegabytesPerSecond(s) << " MB/s per thread" << std::endl;
+	out << "  Files read to end: " << s[StatCounter::FILES_READ_TO_END] << " in " << s[StatCounter::GROUPS_READ_TO_END]
+		<< " size groups, " << s[StatCounter::DUPLICATE_GROUPS] << " duplicate groups" << std::endl;
+	out << "  Byte comparison: " << s[StatCounter::DIRECT_GROUPS] << " size groups without hashing, " << s[StatCounter::VERIFIED_GROUPS]
+		<< " hash groups verified, " << s[StatCounter::VERIFY_MISMATCHES] << " files split off by verification" << std::endl;
+	out << "  Samples: " << s[StatCounter::SAMPLED_FILES] << " files sampled, " << s[StatCounter::SAMPLE_ELIMINATED]
+		<< " eliminated before full read" << std::endl;
+	out << "  Actions: " << s[StatCounter::ACTIONS_DONE] << " done, " << s[StatCounter::ACTIONS_FAILED] << " failed in "
+		<< seconds(s[StatCounter::ACTION_NANOS]) << " s" << std::endl;
+	out << "  Read order: " << s[StatCounter::ORDERED_READS] << " reads in physical order, " << s[StatCounter::READ_SWEEPS]
+		<< " sweeps, " << s[StatCounter::UNMAPPED_FILES] << " files in inode order" << std::endl;
+	out << "  Device queues: " << s[StatCounter::DEVICE_QUEUED_TASKS] << " tasks waited for a device slot, " << s[StatCounter::SPLIT_ROUNDS]
+		<< " block rounds split across tasks" << std::endl;
+	out << "  Merge: " << s[StatCounter::SNAPSHOT_FILES] << " snapshot files, " << s[StatCounter::MERGE_CANDIDATE_FILES]
+		<< " with sizes found in several snapshots" << std::endl;
+
+	/// Вывод непустых корзин гистограммы
+	auto printHistogram = [&](StatHistogram histogram, const char* title, const char* unit) {
+		out << "  " << title << ":" << std::endl;
+		auto limits = bounds(histogram);
+		const auto& buckets = s.buckets[static_cast<size_t>(histogram)];
+		if (std::all_of(buckets.begin(), buckets.end(), [](uint64_t count) { return count == 0; }))
+			out << "    none" << std::endl;
+		for (size_t b = 0; b <= limits.size(); ++b) {
+			if (buckets[b] == 0)
+				continue;
+			if (b == limits.size())
+				out << "    > " << limits.back();
+			else
+				out << "    <= " << limits[b];
+			out << " " << unit << ": " << buckets[b] << std::endl;
+		}
+		};
+	printHistogram(StatHistogram::ELIMINATION_DEPTH, "Elimination depth (files found unique after N blocks)", "blocks");
+	printHistogram(StatHistogram::GROUP_BYTES_READ, "Bytes read per size group (groups)", "bytes");
+	out.flags(flags);
+}
+
+bool Stats::writePrometheus(const std::string& path, std::string_view algorithm)
+{
+	Snapshot s = snapshot();
+	// Файл заменяется атомарно, чтобы сборщик не прочитал его наполовину записанным
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::trunc);
+		if (!out)
+			return false;
+		out << std::setprecision(9);
+		for (const auto& info : kCounterInfo) {
+			uint64_t value = s[info.counter];
+			out << "# HELP " << info.name << " " << info.help << "\n";
+			out << "# TYPE " << info.name << " counter\n";
+			out << info.name << " ";
+			if (std::string_view(info.name).find("_seconds") != std::string_view::npos)
+				out << seconds(value) << "\n";
+			else
+				out << value << "\n";
+		}
+		out << "# HELP bayan_hash_bytes_total Bytes processed by the hash algorithm.\n";
+		out << "# TYPE bayan_hash_bytes_total counter\n";
+		out << "bayan_hash_bytes_total{algorithm=\"" << algorithm << "\"} " << s[StatCounter::HASHED_BYTES] << "\n";
+		out << "# HELP bayan_hash_seconds_total Time spent hashing, summed over threads.\n";
+		out << "# TYPE bayan_hash_seconds_total counter\n";
+		out << "bayan_hash_seconds_total{algorithm=\"" << algorithm << "\"} " << seconds(s[StatCounter::HASH_NANOS]) << "\n";
+		out << "# HELP bayan_hash_throughput_megabytes_per_second Hash throughput per thread.\n";
+		out << "# TYPE bayan_hash_throughput_megabytes_per_second gauge\n";
+		out << "bayan_hash_throughput_megabytes_per_second{algorithm=\"" << algorithm << "\"} " << hashMegabytesPerSecond(s) << "\n";
+		for (const auto& info : kHistogramInfo) {
+			auto limits = bounds(info.histogram);
+			const auto& buckets = s.buckets[static_cast<size_t>(info.histogram)];
+			out << "# HELP " << info.name << " " << info.help << "\n";
+			out << "# TYPE " << info.name << " histogram\n";
+			uint64_t cumulative = 0;
+			for (size_t b = 0; b < limits.size(); ++b) {
+				cumulative += buckets[b];
+				out << info.name << "_bucket{le=\"" << limits[b] << "\"} " << cumulative << "\n";
+			}
+			cumulative += buckets[limits.size()];
+			out << info.name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+			out << info.name << "_sum " << s.sums[static_cast<size_t>(info.histogram)] << "\n";
+			out << info.name << "_count " << cumulative << "\n";
+		}
+		if (!out.flush())
+			return false;
+	}
+	return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
\ No newline at end of file
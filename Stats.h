@@ -0,0 +1,175 @@
+/**
+ * @file Stats.h
+ * @brief Заголовочный файл для класса Stats.
+ *
+ * Класс Stats собирает счетчики, таймеры и гистограммы этапов поиска дубликатов.
+ */
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * @enum StatCounter
+ * @brief Счетчики этапов. Счетчики с суффиксом _NANOS хранят время в наносекундах.
+ */
+enum class StatCounter : size_t
+{
+	TOTAL_NANOS = 0, ///< Общее время работы.
+	WALK_NANOS, ///< Время обхода директорий.
+	DIRECTORIES, ///< Прочитано директорий.
+	ENTRIES, ///< Элементов директорий.
+	STAT_CALLS, ///< Вызовов stat.
+	FILES_COLLECTED, ///< Файлов, прошедших фильтры.
+	ALIAS_PATHS, ///< Путей, схлопнутых как псевдонимы.
+	COMPARE_NANOS, ///< Время сравнения групп.
+	SIZE_GROUPS, ///< Сравненных групп одного размера.
+	CANDIDATE_FILES, ///< Файлов в сравненных группах.
+	CANDIDATE_BYTES, ///< Суммарный размер файлов сравненных групп.
+	BYTES_READ, ///< Байт прочитано с диска.
+	BLOCKS_READ, ///< Блоков прочитано с диска.
+	CACHED_BYTES, ///< Байт, хэши которых взяты из кэша.
+	FILES_FAILED, ///< Файлов, которые не удалось открыть.
+	GROUPS_READ_TO_END, ///< Групп, файлы которых пришлось дочитать до конца.
+	FILES_READ_TO_END, ///< Файлов, дочитанных до конца (дубликатов).
+	DUPLICATE_GROUPS, ///< Найденных групп дубликатов.
+	DIRECT_GROUPS, ///< Групп, сравненных побайтно без хэширования.
+	VERIFIED_GROUPS, ///< Групп, найденных по хэшам и проверенных побайтно.
+	VERIFY_MISMATCHES, ///< Файлов, исключенных из групп побайтной проверкой (коллизии хэша).
+	HASHED_BYTES, ///< Байт обработано алгоритмом хэширования.
+	HASH_NANOS, ///< Время хэширования (сумма по потокам).
+	SAMPLED_FILES, ///< Файлов, прошедших выборочную проверку блоков.
+	SAMPLE_ELIMINATED, ///< Файлов, исключенных по выборочным блокам до полного чтения.
+	ACTIONS_DONE, ///< Выполненных (или показанных при --dry-run) действий над дубликатами.
+	ACTIONS_FAILED, ///< Действий над дубликатами, завершившихся ошибкой.
+	ACTION_NANOS, ///< Время выполнения действий над дубликатами.
+	ORDERED_READS, ///< Чтений, выполненных в порядке лифта (--read-order physical).
+	READ_SWEEPS, ///< Возвратов лифта к началу устройства.
+	UNMAPPED_FILES, ///< Файлов, упорядоченных по номеру inode без FIEMAP.
+	DEVICE_QUEUED_TASKS, ///< Задач, ждавших в очереди ограниченного устройства.
+	SNAPSHOT_FILES, ///< Файлов, прочитанных из снимков индексов (--merge).
+	MERGE_CANDIDATE_FILES, ///< Файлов снимков с размером, встречающимся в нескольких снимках.
+	SPLIT_ROUNDS, ///< Шагов сравнения большой группы, прочитанных несколькими задачами пула.
+	COUNT ///< Количество счетчиков.
+};
+
+/**
+ * @enum StatHistogram
+ * @brief Гистограммы этапов.
+ */
+enum class StatHistogram : size_t
+{
+	ELIMINATION_DEPTH = 0, ///< Количество сравненных блоков, после которого файл оказался уникальным.
+	GROUP_BYTES_READ, ///< Байт прочитано на группу одного размера.
+	COUNT ///< Количество гистограмм.
+};
+
+/**
+ * @class Stats
+ * @brief Счетчики и гистограммы с блоком на каждый поток.
+ *
+ * Каждый поток пишет только в свой блок (relaxed load/store без атомарных RMW-операций
+ * и разделяемых кэш-линий), блоки живут до конца программы и суммируются при выводе.
+ * Счетчики считаются всегда; таймеры, требующие чтения часов, работают только после enable().
+ */
+class Stats
+{
+public:
+	static constexpr size_t kMaxBuckets = 12; ///< Максимальное количество корзин гистограммы (с +Inf).
+
+	/// Суммарные значения всех потоков
+	struct Snapshot
+	{
+		std::array<uint64_t, static_cast<size_t>(StatCounter::COUNT)> counters{}; ///< Значения счетчиков.
+		std::array<std::array<uint64_t, kMaxBuckets>, static_cast<size_t>(StatHistogram::COUNT)> buckets{}; ///< Корзины гистограмм (не накопительные).
+		std::array<uint64_t, static_cast<size_t>(StatHistogram::COUNT)> sums{}; ///< Суммы наблюдений гистограмм.
+
+		/// Значение счетчика
+		uint64_t operator[](StatCounter counter) const { return counters[static_cast<size_t>(counter)]; }
+	};
+
+	/**
+	 * @brief Метод для включения таймеров.
+	 */
+	static void enable();
+
+	/**
+	 * @brief Метод для проверки, включены ли таймеры.
+	 * @return true, если таймеры включены.
+	 */
+	static bool enabled();
+
+	/**
+	 * @brief Метод для увеличения счетчика текущего потока.
+	 * @param counter Счетчик.
+	 * @param value Приращение.
+	 */
+	static void add(StatCounter counter, uint64_t value = 1);
+
+	/**
+	 * @brief Метод для добавления наблюдения в гистограмму текущего потока.
+	 * @param histogram Гистограмма.
+	 * @param value Наблюдаемое значение.
+	 */
+	static void observe(StatHistogram histogram, uint64_t value);
+
+	/**
+	 * @brief Метод для суммирования блоков всех потоков.
+	 * @return Суммарные значения.
+	 */
+	static Snapshot snapshot();
+
+	/**
+	 * @brief Метод для вывода сводки в читаемом виде.
+	 * @param out Поток вывода.
+	 * @param algorithm Название алгоритма хэширования.
+	 */
+	static void printSummary(std::ostream& out, std::string_view algorithm);
+
+	/**
+	 * @brief Метод для записи метрик в текстовом формате Prometheus.
+	 * @param path Путь к файлу.
+	 * @param algorithm Название алгоритма хэширования.
+	 * @return false, если файл не удалось записать.
+	 */
+	static bool writePrometheus(const std::string& path, std::string_view algorithm);
+};
+
+/**
+ * @class StatTimer
+ * @brief Таймер области видимости: добавляет прошедшее время к счетчику, если таймеры включены.
+ */
+class StatTimer
+{
+public:
+	/**
+	 * @brief Конструктор класса StatTimer.
+	 * @param counter Счетчик времени.
+	 */
+	explicit StatTimer(StatCounter counter)
+		: counter_(counter), enabled_(Stats::enabled())
+	{
+		if (enabled_)
+			start_ = std::chrono::steady_clock::now();
+	}
+
+	/**
+	 * @brief Деструктор класса StatTimer.
+	 */
+	~StatTimer() {
+		if (enabled_)
+			Stats::add(counter_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count()));
+	}
+
+	StatTimer(const StatTimer&) = delete;
+	StatTimer& operator=(const StatTimer&) = delete;
+
+private:
+	StatCounter counter_; ///< Счетчик времени.
+	bool enabled_; ///< Таймер запущен.
+	std::chrono::steady_clock::time_point start_; ///< Время запуска.
+};
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	/// Пул, которому принадлежит текущий поток
+	thread_local ThreadPool* currentPool = nullptr;
+	/// Индекс очереди текущего рабочего потока
+	thread_local size_t currentIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+	for (size_t i = 0; i < threads; ++i)
+		queues_.push_back(std::make_unique<WorkerQueue>());
+	for (size_t i = 0; i < threads; ++i)
+		workers_.emplace_back([this, i]() { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::scoped_lock<std::mutex> lock(sleepMutex_);
+		stop_ = true;
+	}
+	sleepCv_.notify_all();
+	for (auto& worker : workers_)
+		worker.join();
+}
+
+void ThreadPool::submit(Task task)
+{
+	size_t index = currentPool == this ? currentIndex : nextQueue_++ % queues_.size();
+	{
+		// Счётчик увеличивается до вставки, чтобы он никогда не был меньше числа задач в очередях
+		std::scoped_lock<std::mutex> lock(sleepMutex_);
+		++pending_;
+	}
+	{
+		std::scoped_lock<std::mutex> lock(queues_[index]->mutex);
+		queues_[index]->tasks.push_back(std::move(task));
+	}
+	sleepCv_.notify_one();
+}
+
+bool ThreadPool::runPendingTask()
+{
+	Task task;
+	if (!popTask(currentPool == this ? currentIndex : 0, task))
+		return false;
+	task();
+	return true;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& part)
+{
+	/// Общее состояние частей; помощник, взявший задачу после завершения работы, обращается только к нему
+	struct State
+	{
+		std::atomic<size_t> next{ 0 }; ///< Следующая свободная часть.
+		size_t done{ 0 }; ///< Выполненные части.
+		std::mutex mutex; ///< Мьютекс для синхронизации доступа к done и error.
+		std::condition_variable cv; ///< Условная переменная выполнения всех частей.
+		std::exception_ptr error; ///< Первое исключение из частей.
+	};
+	auto state = std::make_shared<State>();
+	auto work = [state, count, &part]() {
+		for (size_t index; (index = state->next++) < count;) {
+			std::exception_ptr error;
+			try {
+				part(index);
+			}
+			catch (...) {
+				error = std::current_exception();
+			}
+			std::scoped_lock<std::mutex> lock(state->mutex);
+			if (error && !state->error)
+				state->error = error;
+			if (++state->done == count)
+				state->cv.notify_all();
+		}
+		};
+	for (size_t helper = 1; helper < std::min(count, size()); ++helper)
+		submit(work);
+	work();
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->cv.wait(lock, [&state, count]() { return state->done == count; });
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+bool ThreadPool::popTask(size_t index, Task& task)
+{
+	if (pending_ == 0)
+		return false;
+	{
+		auto& own = *queues_[index];
+		std::scoped_lock<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			--pending_;
+			return true;
+		}
+	}
+	for (size_t i = 1; i < queues_.size(); ++i) {
+		auto& victim = *queues_[(index + i) % queues_.size()];
+		std::scoped_lock<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			--pending_;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+	currentPool = this;
+	currentIndex = index;
+	while (true) {
+		Task task;
+		if (popTask(index, task)) {
+			task();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex_);
+		sleepCv_.wait(lock, [this]() { return stop_ || pending_ > 0; });
+		if (stop_ && pending_ == 0)
+			return;
+	}
+}
+
+TaskGroup::~TaskGroup()
+{
+	waitAll();
+}
+
+void TaskGroup::run(ThreadPool::Task task)
+{
+	++active_;
+	pool_.submit([this, task = std::move(task)]() {
+		try {
+			task();
+		}
+		catch (...) {
+			std::scoped_lock<std::mutex> lock(mutex_);
+			if (!error_)
+				error_ = std::current_exception();
+		}
+		std::scoped_lock<std::mutex> lock(mutex_);
+		if (--active_ == 0)
+			cv_.notify_all();
+		});
+}
+
+void TaskGroup::wait()
+{
+	waitAll();
+	std::exception_ptr error;
+	{
+		std::scoped_lock<std::mutex> lock(mutex_);
+		std::swap(error, error_);
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void TaskGroup::waitAll()
+{
+	while (active_ > 0) {
+		if (pool_.runPendingTask())
+			continue;
+		std::unique_lock<std::mutex> lock(mutex_);
+		cv_.wait_for(lock, std::chrono::milliseconds(1), [this]() { return active_ == 0; });
+	}
+	// Дожидаемся выхода последней задачи из критической секции
+	std::scoped_lock<std::mutex> lock(mutex_);
+}
\ No newline at end of file
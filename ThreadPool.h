@@ -0,0 +1,154 @@
+/**
+ * @file ThreadPool.h
+ * @brief Заголовочный файл для классов ThreadPool и TaskGroup.
+ *
+ * Класс ThreadPool реализует ограниченный пул потоков с перехватом задач (work stealing),
+ * общий для обхода директорий и сравнения групп файлов.
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Пул потоков фиксированного размера с локальными очередями и перехватом задач.
+ *
+ * Каждый рабочий поток имеет свою очередь: собственные задачи он берёт с конца (LIFO),
+ * а при пустой очереди забирает задачи с начала чужих очередей (FIFO).
+ */
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	/**
+	 * @brief Конструктор класса ThreadPool.
+	 * @param threads Количество рабочих потоков (0 - по числу аппаратных потоков).
+	 */
+	explicit ThreadPool(size_t threads);
+
+	/**
+	 * @brief Деструктор класса ThreadPool. Дожидается завершения всех поставленных задач.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Метод для постановки задачи в пул.
+	 * @param task Задача.
+	 */
+	void submit(Task task);
+
+	/**
+	 * @brief Метод для выполнения одной ожидающей задачи в текущем потоке.
+	 * @return true, если задача была выполнена.
+	 */
+	bool runPendingTask();
+
+	/**
+	 * @brief Метод для выполнения частей одной работы текущим потоком вместе со свободными рабочими потоками.
+	 *
+	 * В отличие от TaskGroup::wait, вызывающий поток выполняет только части этой работы и не берёт
+	 * чужие задачи пула, поэтому метод можно вызывать из задачи, удерживающей ресурсы (дескрипторы
+	 * файлов): вложенная чужая задача не заблокирует её ожиданием тех же ресурсов. Части, которые
+	 * не взяли рабочие потоки, выполняет вызывающий поток.
+	 * @param count Количество частей.
+	 * @param part Функция выполнения части по её номеру.
+	 * @throws Первое исключение, выброшенное частью.
+	 */
+	void parallelFor(size_t count, const std::function<void(size_t)>& part);
+
+	/**
+	 * @brief Метод для получения количества рабочих потоков.
+	 * @return Количество рабочих потоков.
+	 */
+	size_t size() const { return workers_.size(); }
+
+private:
+	/// Очередь задач рабочего потока
+	struct WorkerQueue
+	{
+		std::mutex mutex; ///< Мьютекс для синхронизации доступа к tasks.
+		std::deque<Task> tasks; ///< Задачи.
+	};
+
+	/**
+	 * @brief Основной цикл рабочего потока.
+	 * @param index Индекс рабочего потока.
+	 */
+	void workerLoop(size_t index);
+
+	/**
+	 * @brief Метод для извлечения задачи: сначала из своей очереди, затем из чужих.
+	 * @param index Индекс очереди, с которой начинается поиск.
+	 * @param task Извлечённая задача.
+	 * @return true, если задача извлечена.
+	 */
+	bool popTask(size_t index, Task& task);
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues_; ///< Очереди рабочих потоков.
+	std::vector<std::thread> workers_; ///< Рабочие потоки.
+	std::atomic<size_t> pending_{ 0 }; ///< Количество задач в очередях.
+	std::atomic<size_t> nextQueue_{ 0 }; ///< Очередь для задач из внешних потоков.
+	std::mutex sleepMutex_; ///< Мьютекс для ожидания новых задач.
+	std::condition_variable sleepCv_; ///< Условная переменная для ожидания новых задач.
+	bool stop_{ false }; ///< Флаг остановки пула.
+};
+
+/**
+ * @class TaskGroup
+ * @brief Группа задач пула, завершения которых можно дождаться.
+ *
+ * Ожидающий поток не простаивает, а выполняет задачи пула, поэтому задачи
+ * могут безопасно порождать вложенные группы и ждать их.
+ */
+class TaskGroup
+{
+public:
+	/**
+	 * @brief Конструктор класса TaskGroup.
+	 * @param pool Пул потоков.
+	 */
+	explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+
+	/**
+	 * @brief Деструктор класса TaskGroup. Дожидается завершения задач группы.
+	 */
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	/**
+	 * @brief Метод для запуска задачи в группе.
+	 * @param task Задача.
+	 */
+	void run(ThreadPool::Task task);
+
+	/**
+	 * @brief Метод для ожидания завершения всех задач группы.
+	 *
+	 * Если одна из задач завершилась исключением, оно пробрасывается дальше.
+	 */
+	void wait();
+
+private:
+	/// Ожидание без проброса исключения
+	void waitAll();
+
+	ThreadPool& pool_; ///< Пул потоков.
+	std::atomic<size_t> active_{ 0 }; ///< Количество незавершённых задач.
+	std::mutex mutex_; ///< Мьютекс для синхронизации доступа к error_.
+	std::condition_variable cv_; ///< Условная переменная завершения задач.
+	std::exception_ptr error_; ///< Первое исключение из задач группы.
+};
\ No newline at end of file
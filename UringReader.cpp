@@ -0,0 +1,239 @@
+#include "UringReader.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#if BAYAN_HAS_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+	int uringSetup(unsigned entries, io_uring_params* params)
+	{
+		return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+	}
+
+	int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+	{
+		return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+	}
+
+	int uringRegister(int fd, unsigned opcode, const void* arg, unsigned count)
+	{
+		return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+	}
+
+	unsigned loadAcquire(unsigned* value)
+	{
+		return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+	}
+
+	void storeRelease(unsigned* value, unsigned newValue)
+	{
+		std::atomic_ref<unsigned>(*value).store(newValue, std::memory_order_release);
+	}
+
+	/// Смещение указателя внутри отображения кольца
+	template <typename T>
+	T* ringField(void* ring, uint32_t offset)
+	{
+		return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+	}
+}
+
+UringReader::UringReader(unsigned queueDepth, size_t bufferSize)
+	: queueDepth_(queueDepth == 0 ? 1 : queueDepth), bufferSize_(bufferSize)
+{
+	io_uring_params params{};
+	ringFd_ = uringSetup(queueDepth_, &params);
+	if (ringFd_ < 0)
+		throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+
+	sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (singleMmap)
+		sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+	sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+	if (sqRing_ == MAP_FAILED) {
+		sqRing_ = nullptr;
+		release();
+		throw std::system_error(errno, std::generic_category(), "io_uring mmap");
+	}
+	if (singleMmap) {
+		cqRing_ = sqRing_;
+	}
+	else {
+		cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+		if (cqRing_ == MAP_FAILED) {
+			cqRing_ = nullptr;
+			release();
+			throw std::system_error(errno, std::generic_category(), "io_uring mmap");
+		}
+	}
+	sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+	sqes_ = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+	if (sqes_ == MAP_FAILED) {
+		sqes_ = nullptr;
+		release();
+		throw std::system_error(errno, std::generic_category(), "io_uring mmap");
+	}
+
+	sqHead_ = ringField<unsigned>(sqRing_, params.sq_off.head);
+	sqTail_ = ringField<unsigned>(sqRing_, params.sq_off.tail);
+	sqMask_ = ringField<unsigned>(sqRing_, params.sq_off.ring_mask);
+	sqArray_ = ringField<unsigned>(sqRing_, params.sq_off.array);
+	cqHead_ = ringField<unsigned>(cqRing_, params.cq_off.head);
+	cqTail_ = ringField<unsigned>(cqRing_, params.cq_off.tail);
+	cqMask_ = ringField<unsigned>(cqRing_, params.cq_off.ring_mask);
+	cqes_ = ringField<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+
+	// Буферы выравниваются по странице, чтобы их можно было зарегистрировать в ядре
+	buffers_ = static_cast<char*>(std::aligned_alloc(4096, (queueDepth_ * bufferSize_ + 4095) / 4096 * 4096));
+	if (!buffers_) {
+		release();
+		throw std::bad_alloc();
+	}
+	std::vector<iovec> iovecs(queueDepth_);
+	for (unsigned i = 0; i < queueDepth_; ++i)
+		iovecs[i] = { buffers_ + i * bufferSize_, bufferSize_ };
+	// Без регистрации (например, из-за RLIMIT_MEMLOCK) используются обычные чтения
+	fixedBuffers_ = uringRegister(ringFd_, IORING_REGISTER_BUFFERS, iovecs.data(), queueDepth_) == 0;
+}
+
+UringReader::~UringReader()
+{
+	release();
+}
+
+void UringReader::release()
+{
+	std::free(buffers_);
+	buffers_ = nullptr;
+	if (sqes_)
+		::munmap(sqes_, sqesSize_);
+	if (cqRing_ && cqRing_ != sqRing_)
+		::munmap(cqRing_, cqRingSize_);
+	if (sqRing_)
+		::munmap(sqRing_, sqRingSize_);
+	sqes_ = cqRing_ = sqRing_ = nullptr;
+	if (ringFd_ >= 0)
+		::close(ringFd_);
+	ringFd_ = -1;
+}
+
+void UringReader::readAll(std::span<const Request> requests, const Completion& onComplete)
+{
+	std::vector<unsigned> freeSlots;
+	freeSlots.reserve(queueDepth_);
+	for (unsigned i = queueDepth_; i > 0; --i)
+		freeSlots.push_back(i - 1);
+
+	auto* sqes = static_cast<io_uring_sqe*>(sqes_);
+	auto* cqes = static_cast<io_uring_cqe*>(cqes_);
+	size_t next = 0;
+	size_t inFlight = 0;
+	while (next < requests.size() || inFlight > 0) {
+		unsigned toSubmit = 0;
+		unsigned tail = *sqTail_;
+		while (next < requests.size() && !freeSlots.empty()) {
+			unsigned slot = freeSlots.back();
+			freeSlots.pop_back();
+			const auto& request = requests[next];
+			unsigned index = tail & *sqMask_;
+			io_uring_sqe& sqe = sqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = fixedBuffers_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+			sqe.fd = request.fd;
+			sqe.off = request.offset;
+			sqe.addr = reinterpret_cast<uint64_t>(buffers_ + slot * bufferSize_);
+			sqe.len = static_cast<uint32_t>(std::min(request.length, bufferSize_));
+			sqe.buf_index = static_cast<uint16_t>(slot);
+			sqe.user_data = static_cast<uint64_t>(next) * queueDepth_ + slot;
+			sqArray_[index] = index;
+			++tail;
+			++next;
+			++inFlight;
+			++toSubmit;
+		}
+		storeRelease(sqTail_, tail);
+
+		int res;
+		do {
+			res = uringEnter(ringFd_, toSubmit, 1, IORING_ENTER_GETEVENTS);
+		} while (res < 0 && errno == EINTR);
+		if (res < 0)
+			throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+
+		unsigned head = *cqHead_;
+		unsigned cqTail = loadAcquire(cqTail_);
+		while (head != cqTail) {
+			const io_uring_cqe& cqe = cqes[head & *cqMask_];
+			size_t requestIndex = static_cast<size_t>(cqe.user_data / queueDepth_);
+			unsigned slot = static_cast<unsigned>(cqe.user_data % queueDepth_);
+			const auto& request = requests[requestIndex];
+			char* buffer = buffers_ + slot * bufferSize_;
+			size_t length = std::min(request.length, bufferSize_);
+			size_t bytesRead = cqe.res > 0 ? static_cast<size_t>(cqe.res) : 0;
+			// Короткое чтение дочитывается синхронно до конца блока или файла
+			while (cqe.res > 0 && bytesRead < length) {
+				ssize_t more = ::pread(request.fd, buffer + bytesRead, length - bytesRead, static_cast<off_t>(request.offset + bytesRead));
+				if (more <= 0)
+					break;
+				bytesRead += static_cast<size_t>(more);
+			}
+			++head;
+			storeRelease(cqHead_, head);
+			--inFlight;
+			onComplete(requestIndex, { buffer, bytesRead });
+			freeSlots.push_back(slot);
+		}
+	}
+}
+
+bool UringReader::available()
+{
+	static const bool result = []() {
+		try {
+			UringReader probe(1, 4096);
+			return true;
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+		}();
+	return result;
+}
+
+#else
+
+UringReader::UringReader(unsigned queueDepth, size_t bufferSize)
+	: queueDepth_(queueDepth), bufferSize_(bufferSize)
+{
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "io_uring");
+}
+
+UringReader::~UringReader() = default;
+
+void UringReader::release()
+{
+}
+
+void UringReader::readAll(std::span<const Request>, const Completion&)
+{
+}
+
+bool UringReader::available()
+{
+	return false;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * @file UringReader.h
+ * @brief Заголовочный файл для класса UringReader.
+ *
+ * Класс UringReader выполняет пакетное асинхронное чтение блоков через io_uring,
+ * чтобы чтения всех файлов группы шли параллельно и перекрывались с хэшированием.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define BAYAN_HAS_URING 1
+#else
+#define BAYAN_HAS_URING 0
+#endif
+
+/**
+ * @class UringReader
+ * @brief Кольцо io_uring с зарегистрированными буферами для пакетного чтения блоков.
+ */
+class UringReader
+{
+public:
+	/// Запрос на чтение блока
+	struct Request
+	{
+		int fd; ///< Дескриптор файла.
+		uint64_t offset; ///< Смещение блока.
+		size_t length; ///< Размер блока (не больше размера буфера).
+	};
+
+	/// Обработчик завершённого чтения: индекс запроса и прочитанные данные
+	using Completion = std::function<void(size_t, std::span<const char>)>;
+
+	/**
+	 * @brief Конструктор класса UringReader.
+	 * @param queueDepth Глубина очереди (количество одновременных чтений).
+	 * @param bufferSize Размер буфера одного чтения.
+	 * @throw std::system_error, если io_uring недоступен.
+	 */
+	UringReader(unsigned queueDepth, size_t bufferSize);
+
+	/**
+	 * @brief Деструктор класса UringReader.
+	 */
+	~UringReader();
+
+	UringReader(const UringReader&) = delete;
+	UringReader& operator=(const UringReader&) = delete;
+
+	/**
+	 * @brief Метод для чтения набора блоков.
+	 *
+	 * Запросы отправляются пакетами по глубине очереди; каждый освободившийся буфер
+	 * сразу получает следующий запрос, а обработчик вызывается по мере завершения чтений.
+	 * При ошибке чтения обработчик получает пустые данные.
+	 * @param requests Запросы на чтение.
+	 * @param onComplete Обработчик завершённого чтения.
+	 */
+	void readAll(std::span<const Request> requests, const Completion& onComplete);
+
+	/// Размер буфера одного чтения
+	size_t bufferSize() const { return bufferSize_; }
+
+	/**
+	 * @brief Метод для проверки доступности io_uring в системе.
+	 * @return true, если io_uring доступен.
+	 */
+	static bool available();
+
+private:
+	/**
+	 * @brief Метод для освобождения ресурсов кольца.
+	 */
+	void release();
+
+	unsigned queueDepth_; ///< Глубина очереди.
+	size_t bufferSize_; ///< Размер буфера одного чтения.
+	char* buffers_{ nullptr }; ///< Буферы чтения (queueDepth_ * bufferSize_).
+	bool fixedBuffers_{ false }; ///< Признак зарегистрированных в ядре буферов.
+#if BAYAN_HAS_URING
+	int ringFd_{ -1 }; ///< Дескриптор кольца.
+	void* sqRing_{ nullptr }; ///< Отображение очереди отправки.
+	size_t sqRingSize_{ 0 }; ///< Размер отображения очереди отправки.
+	void* cqRing_{ nullptr }; ///< Отображение очереди завершения.
+	size_t cqRingSize_{ 0 }; ///< Размер отображения очереди завершения.
+	void* sqes_{ nullptr }; ///< Массив элементов очереди отправки.
+	size_t sqesSize_{ 0 }; ///< Размер массива элементов очереди отправки.
+	unsigned* sqHead_{ nullptr }; ///< Голова очереди отправки.
+	unsigned* sqTail_{ nullptr }; ///< Хвост очереди отправки.
+	unsigned* sqMask_{ nullptr }; ///< Маска очереди отправки.
+	unsigned* sqArray_{ nullptr }; ///< Индексы очереди отправки.
+	unsigned* cqHead_{ nullptr }; ///< Голова очереди завершения.
+	unsigned* cqTail_{ nullptr }; ///< Хвост очереди завершения.
+	unsigned* cqMask_{ nullptr }; ///< Маска очереди завершения.
+	void* cqes_{ nullptr }; ///< Элементы очереди завершения.
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include "WatchServer.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef __linux__
+#include <csignal>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	/**
+	 * @brief Функция для приведения пути директории к виду, в котором сравниваются исключения.
+	 * @param dirPath Путь к директории.
+	 * @return Нормализованный путь без завершающего разделителя.
+	 */
+	std::string normalizeDirectory(const std::string& dirPath)
+	{
+		std::string result = std::filesystem::path(dirPath).lexically_normal().string();
+		while (result.size() > 1 && result.back() == '/')
+			result.pop_back();
+		return result;
+	}
+
+#ifdef __linux__
+	/// События директорий, меняющие набор или содержимое файлов
+	constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+		| IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+	/**
+	 * @brief Функция для отправки всего буфера клиенту.
+	 * @param fd Сокет клиента.
+	 * @param data Данные.
+	 */
+	void sendAll(int fd, const std::string& data)
+	{
+		for (size_t sent = 0; sent < data.size();) {
+			ssize_t written = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0)
+				return;
+			sent += static_cast<size_t>(written);
+		}
+	}
+#endif
+}
+
+#ifdef __linux__
+WatchServer::WatchServer(const ArgumentParser::ParserData& data)
+	: data_(data)
+{
+	for (const auto& path : data.excludeDirectories)
+		excluded_.insert(normalizeDirectory(path));
+
+	// Сигналы блокируются до создания рабочих потоков и принимаются только через signalfd
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	::pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+	signalFd_ = ::signalfd(-1, &signals, SFD_CLOEXEC);
+	inotifyFd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (signalFd_ < 0 || inotifyFd_ < 0)
+		throw std::runtime_error(std::string("Failed to initialize inotify: ") + std::strerror(errno));
+
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (data.watchSocket.size() >= sizeof(address.sun_path))
+		throw std::runtime_error("Socket path is too long: " + data.watchSocket);
+	std::memcpy(address.sun_path, data.watchSocket.c_str(), data.watchSocket.size() + 1);
+	listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listenFd_ < 0)
+		throw std::runtime_error(std::string("Failed to create socket: ") + std::strerror(errno));
+	// Файл сокета от завершившегося экземпляра удаляется, работающий экземпляр не трогается
+	if (::connect(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+		throw std::runtime_error("Socket is already in use: " + data.watchSocket);
+	::unlink(data.watchSocket.c_str());
+	if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listenFd_, 16) != 0)
+		throw std::runtime_error("Failed to listen on socket " + data.watchSocket + ": " + std::strerror(errno));
+
+	for (const auto& root : data.directories)
+		watchTree(root, 0, nullptr);
+}
+
+WatchServer::~WatchServer()
+{
+	if (listenFd_ >= 0) {
+		::close(listenFd_);
+		::unlink(data_.watchSocket.c_str());
+	}
+	if (inotifyFd_ >= 0)
+		::close(inotifyFd_);
+	if (signalFd_ >= 0)
+		::close(signalFd_);
+}
+
+void WatchServer::run(DuplicateIndex& index)
+{
+	std::cerr << "Watching " << watches_.size() << " directories, queries on " << data_.watchSocket << std::endl;
+	pollfd fds[3] = { { signalFd_, POLLIN, 0 }, { inotifyFd_, POLLIN, 0 }, { listenFd_, POLLIN, 0 } };
+	for (;;) {
+		// События, накопившиеся во время сканирования, применяются до первого запроса
+		handleEvents(index);
+		if (::poll(fds, 3, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			std::cerr << "Error: poll failed: " << std::strerror(errno) << std::endl;
+			return;
+		}
+		if (fds[0].revents & POLLIN)
+			return;
+		if (fds[2].revents & POLLIN)
+			handleClient(index);
+	}
+}
+
+void WatchServer::watchTree(const std::string& dirPath, size_t depth, std::vector<std::string>* files)
+{
+	if (isExcluded(dirPath))
+		return;
+	int wd = ::inotify_add_watch(inotifyFd_, dirPath.c_str(), kWatchMask);
+	if (wd < 0) {
+		std::cerr << "Warning: Unable to watch directory " << dirPath << ": " << std::strerror(errno) << std::endl;
+		return;
+	}
+	// Директория, уже найденная по другому пути (символическая ссылка), повторно не обходится
+	if (!watches_.try_emplace(wd, Watch{ dirPath, depth }).second)
+		return;
+	std::error_code ec;
+	for (std::filesystem::directory_iterator it(dirPath, ec), end; !ec && it != end; it.increment(ec)) {
+		std::error_code typeError;
+		std::string path = it->path().string();
+		if (it->is_directory(typeError)) {
+			if (depth < data_.level)
+				watchTree(path, depth + 1, files);
+		}
+		else if (files && it->is_regular_file(typeError)) {
+			files->push_back(std::move(path));
+		}
+	}
+}
+
+void WatchServer::unwatchTree(const std::string& dirPath)
+{
+	std::string prefix = dirPath + '/';
+	for (auto it = watches_.begin(); it != watches_.end();) {
+		if (it->second.path == dirPath || it->second.path.starts_with(prefix)) {
+			::inotify_rm_watch(inotifyFd_, it->first);
+			it = watches_.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void WatchServer::rescan(DuplicateIndex& index, std::set<std::string>& changed)
+{
+	// Директории, созданные без события, не наблюдаются, а обход останавливается на уже наблюдаемых
+	for (const auto& [wd, watch] : watches_)
+		::inotify_rm_watch(inotifyFd_, wd);
+	watches_.clear();
+	std::vector<std::string> files = index.paths();
+	for (const auto& root : data_.directories)
+		watchTree(root, 0, &files);
+	changed.insert(files.begin(), files.end());
+	++rescans_;
+}
+
+void WatchServer::handleEvents(DuplicateIndex& index)
+{
+	alignas(inotify_event) char buffer[64 * 1024];
+	std::set<std::string> changed;
+	bool overflowed = false;
+	for (;;) {
+		ssize_t bytes = ::read(inotifyFd_, buffer, sizeof(buffer));
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		if (bytes <= 0)
+			break;
+		for (ssize_t offset = 0; offset < bytes;) {
+			auto* event = reinterpret_cast<inotify_event*>(buffer + offset);
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+			if (event->mask & IN_Q_OVERFLOW) {
+				overflowed = true;
+				continue;
+			}
+			auto watch = watches_.find(event->wd);
+			if (watch == watches_.end())
+				continue;
+			if (event->mask & IN_IGNORED) {
+				watches_.erase(watch);
+				continue;
+			}
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+				std::string dirPath = watch->second.path;
+				index.removeTree(dirPath);
+				unwatchTree(dirPath);
+				continue;
+			}
+			if (event->len == 0)
+				continue;
+			std::string path = watch->second.path;
+			if (path.back() != '/')
+				path += '/';
+			path += event->name;
+			if (event->mask & IN_ISDIR) {
+				if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+					index.removeTree(path);
+					unwatchTree(path);
+				}
+				else if (watch->second.depth < data_.level) {
+					// Файлы новой директории появились до начала наблюдения за ней и добавляются обходом
+					std::vector<std::string> files;
+					watchTree(path, watch->second.depth + 1, &files);
+					changed.insert(files.begin(), files.end());
+				}
+				continue;
+			}
+			changed.insert(std::move(path));
+		}
+	}
+	if (overflowed) {
+		std::cerr << "Warning: inotify event queue overflowed, rescanning watched directories" << std::endl;
+		rescan(index, changed);
+	}
+	// Несколько событий одного файла за пачку применяются один раз
+	for (const auto& path : changed)
+		index.update(path);
+}
+
+void WatchServer::handleClient(DuplicateIndex& index)
+{
+	int client = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+	if (client < 0)
+		return;
+	// Клиент, не приславший команду за секунду, отключается
+	timeval timeout{ 1, 0 };
+	::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	std::string command;
+	char chunk[kMaxCommandLength];
+	while (command.size() < kMaxCommandLength && command.find('\n') == std::string::npos) {
+		ssize_t bytes = ::recv(client, chunk, sizeof(chunk), 0);
+		if (bytes < 0 && errno == EINTR)
+			continue;
+		if (bytes <= 0)
+			break;
+		command.append(chunk, static_cast<size_t>(bytes));
+	}
+	command = command.substr(0, command.find('\n'));
+	while (!command.empty() && (command.back() == '\r' || command.back() == ' '))
+		command.pop_back();
+
+	std::string response;
+	if (command.empty() || command == "groups") {
+		auto formatter = ResultFormatterFactory::create(data_.outputFormat);
+		formatter->begin(response);
+		for (const auto& group : index.groups())
+			formatter->write(group, response);
+		formatter->end(response);
+	}
+	else if (command == "status") {
+		response = "files " + std::to_string(index.fileCount()) + "\npaths " + std::to_string(index.pathCount())
+			+ "\ngroups " + std::to_string(index.groups().size()) + "\ndirectories " + std::to_string(watches_.size())
+			+ "\nrescans " + std::to_string(rescans_) + "\n";
+	}
+	else {
+		response = "Error: Unknown command " + command + "\n";
+	}
+	sendAll(client, response);
+	::close(client);
+}
+#else
+WatchServer::WatchServer(const ArgumentParser::ParserData& data)
+	: data_(data)
+{
+	throw std::runtime_error("Watch mode is supported on Linux only");
+}
+
+WatchServer::~WatchServer() = default;
+
+void WatchServer::run(DuplicateIndex& /*index*/) {}
+
+void WatchServer::watchTree(const std::string& /*dirPath*/, size_t /*depth*/, std::vector<std::string>* /*files*/) {}
+
+void WatchServer::unwatchTree(const std::string& /*dirPath*/) {}
+
+void WatchServer::rescan(DuplicateIndex& /*index*/, std::set<std::string>& /*changed*/) {}
+
+void WatchServer::handleEvents(DuplicateIndex& /*index*/) {}
+
+void WatchServer::handleClient(DuplicateIndex& /*index*/) {}
+#endif
+
+bool WatchServer::isExcluded(const std::string& dirPath) const
+{
+	return excluded_.contains(normalizeDirectory(dirPath));
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+/**
+ * @file WatchServer.h
+ * @brief Заголовочный файл для класса WatchServer.
+ *
+ * Класс WatchServer реализует режим наблюдения: обновляет индекс дубликатов по событиям
+ * inotify и отвечает на запросы через Unix-сокет.
+ */
+#pragma once
+#include "ArgumentParser.h"
+#include "DuplicateIndex.h"
+#include <cstddef>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class WatchServer
+ * @brief Наблюдение за директориями и ответы на запросы к индексу дубликатов.
+ *
+ * Наблюдение за директориями начинается в конструкторе, до сканирования, поэтому
+ * изменения во время сканирования не теряются: события копятся в очереди inotify и
+ * применяются к индексу после заполнения. Новые директории берутся под наблюдение с
+ * учетом глубины и исключений. Клиент подключается к сокету, отправляет строку с
+ * командой и получает ответ до закрытия соединения:
+ * - groups (или пустая строка) - текущие группы дубликатов в формате --format;
+ * - status - количество файлов, путей, групп, наблюдаемых директорий и повторных обходов.
+ * При переполнении очереди inotify пропущенные события неизвестны, поэтому наблюдение
+ * устанавливается заново, а индекс сверяется с повторным обходом директорий.
+ * Работа завершается по SIGINT или SIGTERM. Поддерживается только Linux.
+ */
+class WatchServer
+{
+public:
+	/// Наибольшая длина команды клиента
+	static constexpr size_t kMaxCommandLength = 256;
+
+	/**
+	 * @brief Конструктор класса WatchServer. Начинает наблюдение и открывает сокет.
+	 * @param data Данные, полученные из аргументов командной строки.
+	 * @throws std::runtime_error Если inotify или сокет недоступны.
+	 */
+	explicit WatchServer(const ArgumentParser::ParserData& data);
+
+	/**
+	 * @brief Деструктор класса WatchServer. Закрывает дескрипторы и удаляет файл сокета.
+	 */
+	~WatchServer();
+
+	WatchServer(const WatchServer&) = delete;
+	WatchServer& operator=(const WatchServer&) = delete;
+
+	/**
+	 * @brief Метод для обработки событий и запросов до получения SIGINT или SIGTERM.
+	 * @param index Индекс дубликатов, заполненный сканированием.
+	 */
+	void run(DuplicateIndex& index);
+
+private:
+	/// Наблюдаемая директория
+	struct Watch
+	{
+		std::string path; ///< Путь к директории.
+		size_t depth; ///< Глубина от корня сканирования.
+	};
+
+	/**
+	 * @brief Метод для наблюдения за директорией и ее поддиректориями до заданной глубины.
+	 * @param dirPath Путь к директории.
+	 * @param depth Глубина директории.
+	 * @param files Найденные обычные файлы (nullptr - не собирать).
+	 */
+	void watchTree(const std::string& dirPath, size_t depth, std::vector<std::string>* files);
+
+	/**
+	 * @brief Метод для прекращения наблюдения за директорией и ее поддиректориями.
+	 * @param dirPath Путь к директории.
+	 */
+	void unwatchTree(const std::string& dirPath);
+
+	/**
+	 * @brief Метод для повторного обхода директорий после переполнения очереди inotify.
+	 * @param index Индекс дубликатов.
+	 * @param changed Пути для обновления: найденные обходом и все пути индекса (удаленные исключаются).
+	 */
+	void rescan(DuplicateIndex& index, std::set<std::string>& changed);
+
+	/**
+	 * @brief Метод для применения накопившихся событий inotify к индексу.
+	 * @param index Индекс дубликатов.
+	 */
+	void handleEvents(DuplicateIndex& index);
+
+	/**
+	 * @brief Метод для ответа на запрос подключившегося клиента.
+	 * @param index Индекс дубликатов.
+	 */
+	void handleClient(DuplicateIndex& index);
+
+	/**
+	 * @brief Метод для проверки, исключена ли директория из сканирования.
+	 * @param dirPath Путь к директории.
+	 * @return true, если директория исключена.
+	 */
+	bool isExcluded(const std::string& dirPath) const;
+
+	const ArgumentParser::ParserData& data_; ///< Данные, полученные из аргументов командной строки.
+	std::set<std::string> excluded_; ///< Нормализованные пути исключенных директорий.
+	std::unordered_map<int, Watch> watches_; ///< Дескриптор наблюдения -> директория.
+	int inotifyFd_{ -1 }; ///< Дескриптор inotify.
+	int listenFd_{ -1 }; ///< Слушающий сокет.
+	int signalFd_{ -1 }; ///< Дескриптор signalfd для SIGINT и SIGTERM.
+	size_t rescans_{ 0 }; ///< Количество повторных обходов после переполнения очереди.
+};
\ No newline at end of file
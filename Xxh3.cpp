@@ -0,0 +1,370 @@
+#include "HashCalculator.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BAYAN_XXH3_SSE2 1
+#include <emmintrin.h>
+#endif
+#if BAYAN_XXH3_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#define BAYAN_XXH3_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t kPrime32_1 = 0x9E3779B1u;
+	constexpr uint32_t kPrime32_2 = 0x85EBCA77u;
+	constexpr uint32_t kPrime32_3 = 0xC2B2AE3Du;
+	constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4Full;
+	constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ull;
+	constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ull;
+	constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ull;
+	constexpr uint64_t kPrimeMx1 = 0x165667919E3779F9ull;
+	constexpr uint64_t kPrimeMx2 = 0x9FB21C651E98DF25ull;
+
+	constexpr size_t kStripeLen = 64;
+	constexpr size_t kSecretConsumeRate = 8;
+	constexpr size_t kAccNb = 8;
+	constexpr size_t kSecretSizeMin = 136;
+	constexpr size_t kMidSizeStartOffset = 3;
+	constexpr size_t kMidSizeLastOffset = 17;
+	constexpr size_t kSecretLastAccStart = 7;
+	constexpr size_t kSecretMergeAccsStart = 11;
+
+	/// Секрет XXH3 по умолчанию
+	alignas(64) constexpr uint8_t kSecret[192] = {
+		0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+		0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+		0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+		0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+		0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+		0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+		0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+		0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+		0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+		0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+		0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+		0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+	};
+
+	struct Hash128
+	{
+		uint64_t low;
+		uint64_t high;
+	};
+
+	inline uint32_t read32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+	inline uint64_t read64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+	inline uint32_t swap32(uint32_t x) { return ((x << 24) & 0xff000000u) | ((x << 8) & 0x00ff0000u) | ((x >> 8) & 0x0000ff00u) | ((x >> 24) & 0x000000ffu); }
+	inline uint64_t swap64(uint64_t x) { return (static_cast<uint64_t>(swap32(static_cast<uint32_t>(x))) << 32) | swap32(static_cast<uint32_t>(x >> 32)); }
+	inline uint32_t rotl32(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+	inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+	inline Hash128 mult64to128(uint64_t lhs, uint64_t rhs)
+	{
+#if defined(__SIZEOF_INT128__)
+		__extension__ typedef unsigned __int128 Uint128;
+		Uint128 product = static_cast<Uint128>(lhs) * rhs;
+		return { static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64) };
+#else
+		uint64_t loLo = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+		uint64_t hiLo = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+		uint64_t loHi = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+		uint64_t hiHi = (lhs >> 32) * (rhs >> 32);
+		uint64_t cross = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi;
+		uint64_t upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+		uint64_t lower = (cross << 32) | (loLo & 0xFFFFFFFF);
+		return { lower, upper };
+#endif
+	}
+
+	inline uint64_t mul128Fold64(uint64_t lhs, uint64_t rhs)
+	{
+		Hash128 product = mult64to128(lhs, rhs);
+		return product.low ^ product.high;
+	}
+
+	inline uint64_t xxh64Avalanche(uint64_t h)
+	{
+		h ^= h >> 33;
+		h *= kPrime64_2;
+		h ^= h >> 29;
+		h *= kPrime64_3;
+		h ^= h >> 32;
+		return h;
+	}
+
+	inline uint64_t avalanche(uint64_t h)
+	{
+		h ^= h >> 37;
+		h *= kPrimeMx1;
+		h ^= h >> 32;
+		return h;
+	}
+
+	inline uint64_t rrmxmx(uint64_t h, uint64_t len)
+	{
+		h ^= rotl64(h, 49) ^ rotl64(h, 24);
+		h *= kPrimeMx2;
+		h ^= (h >> 35) + len;
+		h *= kPrimeMx2;
+		return h ^ (h >> 28);
+	}
+
+	inline uint64_t mix16B(const uint8_t* input, const uint8_t* secret)
+	{
+		return mul128Fold64(read64(input) ^ read64(secret), read64(input + 8) ^ read64(secret + 8));
+	}
+
+	inline Hash128 mix32B(Hash128 acc, const uint8_t* input1, const uint8_t* input2, const uint8_t* secret)
+	{
+		acc.low += mix16B(input1, secret);
+		acc.low ^= read64(input2) + read64(input2 + 8);
+		acc.high += mix16B(input2, secret + 16);
+		acc.high ^= read64(input1) + read64(input1 + 8);
+		return acc;
+	}
+
+#if !BAYAN_XXH3_SSE2
+	void accumulate512Scalar(uint64_t* acc, const uint8_t* input, const uint8_t* secret)
+	{
+		for (size_t i = 0; i < kAccNb; ++i) {
+			uint64_t dataVal = read64(input + 8 * i);
+			uint64_t dataKey = dataVal ^ read64(secret + 8 * i);
+			acc[i ^ 1] += dataVal;
+			acc[i] += (dataKey & 0xFFFFFFFF) * (dataKey >> 32);
+		}
+	}
+#else
+	void accumulate512Sse2(uint64_t* acc, const uint8_t* input, const uint8_t* secret)
+	{
+		auto* xacc = reinterpret_cast<__m128i*>(acc);
+		for (size_t i = 0; i < kStripeLen / sizeof(__m128i); ++i) {
+			__m128i dataVec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input) + i);
+			__m128i keyVec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+			__m128i dataKey = _mm_xor_si128(dataVec, keyVec);
+			__m128i dataKeyLo = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+			__m128i product = _mm_mul_epu32(dataKey, dataKeyLo);
+			__m128i dataSwap = _mm_shuffle_epi32(dataVec, _MM_SHUFFLE(1, 0, 3, 2));
+			__m128i sum = _mm_add_epi64(_mm_load_si128(xacc + i), dataSwap);
+			_mm_store_si128(xacc + i, _mm_add_epi64(product, sum));
+		}
+	}
+#endif
+
+#if BAYAN_XXH3_AVX2
+	__attribute__((target("avx2")))
+	void accumulate512Avx2(uint64_t* acc, const uint8_t* input, const uint8_t* secret)
+	{
+		auto* xacc = reinterpret_cast<__m256i*>(acc);
+		for (size_t i = 0; i < kStripeLen / sizeof(__m256i); ++i) {
+			__m256i dataVec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input) + i);
+			__m256i keyVec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret) + i);
+			__m256i dataKey = _mm256_xor_si256(dataVec, keyVec);
+			__m256i dataKeyLo = _mm256_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+			__m256i product = _mm256_mul_epu32(dataKey, dataKeyLo);
+			__m256i dataSwap = _mm256_shuffle_epi32(dataVec, _MM_SHUFFLE(1, 0, 3, 2));
+			__m256i sum = _mm256_add_epi64(_mm256_load_si256(xacc + i), dataSwap);
+			_mm256_store_si256(xacc + i, _mm256_add_epi64(product, sum));
+		}
+	}
+#endif
+
+	using Accumulate512 = void(*)(uint64_t*, const uint8_t*, const uint8_t*);
+
+	/// Выбор векторной реализации накопления по возможностям процессора
+	Accumulate512 selectAccumulate()
+	{
+#if BAYAN_XXH3_AVX2
+		if (__builtin_cpu_supports("avx2"))
+			return accumulate512Avx2;
+#endif
+#if BAYAN_XXH3_SSE2
+		return accumulate512Sse2;
+#else
+		return accumulate512Scalar;
+#endif
+	}
+
+	void scramble(uint64_t* acc, const uint8_t* secret)
+	{
+		for (size_t i = 0; i < kAccNb; ++i) {
+			uint64_t acc64 = acc[i];
+			acc64 ^= acc64 >> 47;
+			acc64 ^= read64(secret + 8 * i);
+			acc64 *= kPrime32_1;
+			acc[i] = acc64;
+		}
+	}
+
+	/// Основной цикл для длинных входов: заполняет аккумуляторы
+	void hashLongInternal(uint64_t* acc, const uint8_t* input, size_t len)
+	{
+		static const Accumulate512 accumulate512 = selectAccumulate();
+		constexpr size_t secretSize = sizeof(kSecret);
+		constexpr size_t stripesPerBlock = (secretSize - kStripeLen) / kSecretConsumeRate;
+		constexpr size_t blockLen = kStripeLen * stripesPerBlock;
+		const size_t blocks = (len - 1) / blockLen;
+
+		for (size_t n = 0; n < blocks; ++n) {
+			for (size_t s = 0; s < stripesPerBlock; ++s)
+				accumulate512(acc, input + n * blockLen + s * kStripeLen, kSecret + s * kSecretConsumeRate);
+			scramble(acc, kSecret + secretSize - kStripeLen);
+		}
+		const size_t stripes = ((len - 1) - blockLen * blocks) / kStripeLen;
+		for (size_t s = 0; s < stripes; ++s)
+			accumulate512(acc, input + blocks * blockLen + s * kStripeLen, kSecret + s * kSecretConsumeRate);
+		accumulate512(acc, input + len - kStripeLen, kSecret + secretSize - kStripeLen - kSecretLastAccStart);
+	}
+
+	uint64_t mergeAccs(const uint64_t* acc, const uint8_t* secret, uint64_t start)
+	{
+		uint64_t result = start;
+		for (size_t i = 0; i < 4; ++i)
+			result += mul128Fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+		return avalanche(result);
+	}
+
+	uint64_t xxh3_64(const uint8_t* input, size_t len)
+	{
+		const uint8_t* secret = kSecret;
+		if (len == 0)
+			return xxh64Avalanche(read64(secret + 56) ^ read64(secret + 64));
+		if (len <= 3) {
+			uint32_t combined = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[len >> 1]) << 24) |
+				input[len - 1] | (static_cast<uint32_t>(len) << 8);
+			uint64_t bitflip = read32(secret) ^ read32(secret + 4);
+			return xxh64Avalanche(combined ^ bitflip);
+		}
+		if (len <= 8) {
+			uint64_t input64 = read32(input + len - 4) + (static_cast<uint64_t>(read32(input)) << 32);
+			uint64_t bitflip = read64(secret + 8) ^ read64(secret + 16);
+			return rrmxmx(input64 ^ bitflip, len);
+		}
+		if (len <= 16) {
+			uint64_t inputLo = read64(input) ^ (read64(secret + 24) ^ read64(secret + 32));
+			uint64_t inputHi = read64(input + len - 8) ^ (read64(secret + 40) ^ read64(secret + 48));
+			uint64_t acc = len + swap64(inputLo) + inputHi + mul128Fold64(inputLo, inputHi);
+			return avalanche(acc);
+		}
+		if (len <= 128) {
+			uint64_t acc = len * kPrime64_1;
+			if (len > 32) {
+				if (len > 64) {
+					if (len > 96) {
+						acc += mix16B(input + 48, secret + 96);
+						acc += mix16B(input + len - 64, secret + 112);
+					}
+					acc += mix16B(input + 32, secret + 64);
+					acc += mix16B(input + len - 48, secret + 80);
+				}
+				acc += mix16B(input + 16, secret + 32);
+				acc += mix16B(input + len - 32, secret + 48);
+			}
+			acc += mix16B(input, secret);
+			acc += mix16B(input + len - 16, secret + 16);
+			return avalanche(acc);
+		}
+		if (len <= 240) {
+			uint64_t acc = len * kPrime64_1;
+			const size_t rounds = len / 16;
+			for (size_t i = 0; i < 8; ++i)
+				acc += mix16B(input + 16 * i, secret + 16 * i);
+			acc = avalanche(acc);
+			for (size_t i = 8; i < rounds; ++i)
+				acc += mix16B(input + 16 * i, secret + 16 * (i - 8) + kMidSizeStartOffset);
+			acc += mix16B(input + len - 16, secret + kSecretSizeMin - kMidSizeLastOffset);
+			return avalanche(acc);
+		}
+		alignas(32) uint64_t acc[kAccNb] = { kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_4, kPrime32_2, kPrime64_5, kPrime32_1 };
+		hashLongInternal(acc, input, len);
+		return mergeAccs(acc, secret + kSecretMergeAccsStart, len * kPrime64_1);
+	}
+
+	Hash128 xxh3_128(const uint8_t* input, size_t len)
+	{
+		const uint8_t* secret = kSecret;
+		if (len == 0)
+			return { xxh64Avalanche(read64(secret + 64) ^ read64(secret + 72)), xxh64Avalanche(read64(secret + 80) ^ read64(secret + 88)) };
+		if (len <= 3) {
+			uint32_t combinedLo = (static_cast<uint32_t>(input[0]) << 16) | (static_cast<uint32_t>(input[len >> 1]) << 24) |
+				input[len - 1] | (static_cast<uint32_t>(len) << 8);
+			uint32_t combinedHi = rotl32(swap32(combinedLo), 13);
+			uint64_t bitflipLo = read32(secret) ^ read32(secret + 4);
+			uint64_t bitflipHi = read32(secret + 8) ^ read32(secret + 12);
+			return { xxh64Avalanche(combinedLo ^ bitflipLo), xxh64Avalanche(combinedHi ^ bitflipHi) };
+		}
+		if (len <= 8) {
+			uint64_t input64 = read32(input) + (static_cast<uint64_t>(read32(input + len - 4)) << 32);
+			uint64_t bitflip = read64(secret + 16) ^ read64(secret + 24);
+			Hash128 m = mult64to128(input64 ^ bitflip, kPrime64_1 + (len << 2));
+			m.high += m.low << 1;
+			m.low ^= m.high >> 3;
+			m.low ^= m.low >> 35;
+			m.low *= kPrimeMx2;
+			m.low ^= m.low >> 28;
+			m.high = avalanche(m.high);
+			return m;
+		}
+		if (len <= 16) {
+			uint64_t bitflipLo = read64(secret + 32) ^ read64(secret + 40);
+			uint64_t bitflipHi = read64(secret + 48) ^ read64(secret + 56);
+			uint64_t inputLo = read64(input);
+			uint64_t inputHi = read64(input + len - 8);
+			Hash128 m = mult64to128(inputLo ^ inputHi ^ bitflipLo, kPrime64_1);
+			m.low += static_cast<uint64_t>(len - 1) << 54;
+			inputHi ^= bitflipHi;
+			m.high += inputHi + (inputHi & 0xFFFFFFFF) * (kPrime32_2 - 1);
+			m.low ^= swap64(m.high);
+			Hash128 h = mult64to128(m.low, kPrime64_2);
+			h.high += m.high * kPrime64_2;
+			return { avalanche(h.low), avalanche(h.high) };
+		}
+		if (len <= 240) {
+			Hash128 acc{ len * kPrime64_1, 0 };
+			if (len <= 128) {
+				if (len > 32) {
+					if (len > 64) {
+						if (len > 96)
+							acc = mix32B(acc, input + 48, input + len - 64, secret + 96);
+						acc = mix32B(acc, input + 32, input + len - 48, secret + 64);
+					}
+					acc = mix32B(acc, input + 16, input + len - 32, secret + 32);
+				}
+				acc = mix32B(acc, input, input + len - 16, secret);
+			}
+			else {
+				const size_t rounds = len / 32;
+				for (size_t i = 0; i < 4; ++i)
+					acc = mix32B(acc, input + 32 * i, input + 32 * i + 16, secret + 32 * i);
+				acc.low = avalanche(acc.low);
+				acc.high = avalanche(acc.high);
+				for (size_t i = 4; i < rounds; ++i)
+					acc = mix32B(acc, input + 32 * i, input + 32 * i + 16, secret + kMidSizeStartOffset + 32 * (i - 4));
+				acc = mix32B(acc, input + len - 16, input + len - 32, secret + kSecretSizeMin - kMidSizeLastOffset - 16);
+			}
+			Hash128 h{ acc.low + acc.high, acc.low * kPrime64_1 + acc.high * kPrime64_4 + len * kPrime64_2 };
+			return { avalanche(h.low), 0 - avalanche(h.high) };
+		}
+		alignas(32) uint64_t acc[kAccNb] = { kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_4, kPrime32_2, kPrime64_5, kPrime32_1 };
+		hashLongInternal(acc, input, len);
+		return { mergeAccs(acc, secret + kSecretMergeAccsStart, len * kPrime64_1),
+			mergeAccs(acc, secret + sizeof(kSecret) - kStripeLen - kSecretMergeAccsStart, ~(len * kPrime64_2)) };
+	}
+}
+
+Digest XXH3Hash::calculateHash(std::span<const char> block) const
+{
+	// Каноническое (big-endian) представление, как у xxhsum
+	uint64_t hash = swap64(xxh3_64(reinterpret_cast<const uint8_t*>(block.data()), block.size()));
+	return Digest(&hash, sizeof(hash));
+}
+
+Digest XXH128Hash::calculateHash(std::span<const char> block) const
+{
+	Hash128 hash = xxh3_128(reinterpret_cast<const uint8_t*>(block.data()), block.size());
+	uint64_t canonical[2] = { swap64(hash.high), swap64(hash.low) };
+	return Digest(canonical, sizeof(canonical));
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "TreeGenerator.h"
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace
+{
+	/**
+	 * @brief Функция для получения псевдослучайных байт.
+	 * @param rng Генератор (без распределений, чтобы байты не зависели от стандартной библиотеки).
+	 * @param size Количество байт.
+	 * @return Байты.
+	 */
+	std::string randomBytes(std::mt19937_64& rng, size_t size)
+	{
+		std::string result(size, '\0');
+		for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+			uint64_t value = rng();
+			for (size_t j = 0; j < sizeof(uint64_t) && i + j < size; ++j)
+				result[i + j] = static_cast<char>(value >> (8 * j));
+		}
+		return result;
+	}
+
+	/**
+	 * @brief Функция для записи файла.
+	 * @param path Путь к файлу.
+	 * @param content Содержимое.
+	 */
+	void writeFile(const fs::path& path, std::string_view content)
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(content.data(), static_cast<std::streamsize>(content.size()));
+		if (!out)
+			throw std::runtime_error("Failed to write " + path.string());
+	}
+
+	/// Имя файла или директории с номером
+	std::string numbered(std::string_view prefix, size_t number)
+	{
+		return std::string(prefix) + std::to_string(number);
+	}
+
+	/// 20000 файлов по 100 в директории размером 1..4096 байт, каждый десятый - копия одного из предыдущих
+	void generateSmallFiles(std::mt19937_64& rng, const fs::path& root)
+	{
+		std::vector<std::string> contents;
+		for (size_t dir = 0; dir < 200; ++dir) {
+			fs::path dirPath = root / numbered("d", dir);
+			fs::create_directories(dirPath);
+			for (size_t file = 0; file < 100; ++file) {
+				std::string content = !contents.empty() && rng() % 10 == 0 ? contents[rng() % contents.size()] : randomBytes(rng, 1 + rng() % 4096);
+				writeFile(dirPath / numbered("f", file), content);
+				contents.push_back(std::move(content));
+			}
+		}
+	}
+
+	/// 4 файла по 32 МиБ: оригинал, его копия, отличие в середине и уникальный
+	void generateHugeFiles(std::mt19937_64& rng, const fs::path& root)
+	{
+		constexpr size_t kSize = 32 << 20;
+		fs::create_directories(root);
+		std::string content = randomBytes(rng, kSize);
+		writeFile(root / "original", content);
+		writeFile(root / "copy", content);
+		content[kSize / 2] ^= 0x5a;
+		writeFile(root / "middle", content);
+		writeFile(root / "unique", randomBytes(rng, kSize));
+	}
+
+	/// 2048 файлов по 32 КиБ с общим префиксом 16 КиБ: 512 различных содержимых по 4 копии
+	void generateSameSizeGroup(std::mt19937_64& rng, const fs::path& root)
+	{
+		constexpr size_t kSize = 32 << 10;
+		std::string prefix = randomBytes(rng, kSize / 2);
+		std::vector<std::string> contents;
+		for (size_t i = 0; i < 512; ++i)
+			contents.push_back(prefix + randomBytes(rng, kSize - prefix.size()));
+		for (size_t dir = 0; dir < 4; ++dir) {
+			fs::path dirPath = root / numbered("d", dir);
+			fs::create_directories(dirPath);
+			for (size_t i = 0; i < contents.size(); ++i)
+				writeFile(dirPath / numbered("f", i), contents[(i * 7 + dir) % contents.size()]);
+		}
+	}
+
+	/// 8 цепочек глубиной 128 директорий по 4 файла 1 КиБ; файлы на одной глубине совпадают во всех цепочках
+	void generateDeepNesting(std::mt19937_64& rng, const fs::path& root)
+	{
+		constexpr size_t kDepth = 128;
+		std::vector<std::string> contents;
+		for (size_t i = 0; i < kDepth * 4; ++i)
+			contents.push_back(randomBytes(rng, 1024));
+		for (size_t chain = 0; chain < 8; ++chain) {
+			fs::path dirPath = root / numbered("c", chain);
+			for (size_t depth = 0; depth < kDepth; ++depth) {
+				dirPath /= "d";
+				fs::create_directories(dirPath);
+				for (size_t file = 0; file < 4; ++file)
+					writeFile(dirPath / numbered("f", file), contents[depth * 4 + file]);
+			}
+		}
+	}
+
+	/// 2000 файлов по 8 КиБ с двумя дополнительными жесткими ссылками, каждый четвертый имеет копию
+	void generateHardlinks(std::mt19937_64& rng, const fs::path& root)
+	{
+		for (auto dir : { "files", "links1", "links2", "copies" })
+			fs::create_directories(root / dir);
+		for (size_t i = 0; i < 2000; ++i) {
+			std::string content = randomBytes(rng, 8 << 10);
+			fs::path original = root / "files" / numbered("f", i);
+			writeFile(original, content);
+			fs::create_hard_link(original, root / "links1" / numbered("f", i));
+			fs::create_hard_link(original, root / "links2" / numbered("f", i));
+			if (i % 4 == 0)
+				writeFile(root / "copies" / numbered("f", i), content);
+		}
+	}
+
+	/// 200 пар файлов по 256 КиБ, различающихся только последним байтом
+	void generateNearDuplicates(std::mt19937_64& rng, const fs::path& root)
+	{
+		for (auto dir : { "a", "b" })
+			fs::create_directories(root / dir);
+		for (size_t i = 0; i < 200; ++i) {
+			std::string content = randomBytes(rng, 256 << 10);
+			writeFile(root / "a" / numbered("f", i), content);
+			content.back() ^= 0x01;
+			writeFile(root / "b" / numbered("f", i), content);
+		}
+	}
+}
+
+TreeGenerator::TreeGenerator(fs::path baseDir)
+	: baseDir_(std::move(baseDir))
+{
+}
+
+fs::path TreeGenerator::tree(TreeKind kind)
+{
+	fs::path root = baseDir_ / name(kind);
+	// Признак готового дерева лежит рядом с ним, чтобы не попадать в сканирование
+	fs::path marker = baseDir_ / (std::string(name(kind)) + ".v" + std::to_string(kVersion));
+	if (fs::exists(marker))
+		return root;
+	fs::remove_all(root);
+	generate(kind, root);
+	writeFile(marker, {});
+	return root;
+}
+
+std::string_view TreeGenerator::name(TreeKind kind)
+{
+	switch (kind) {
+	case TreeKind::SMALL_FILES: return "small_files";
+	case TreeKind::HUGE_FILES: return "huge_files";
+	case TreeKind::SAME_SIZE_GROUP: return "same_size_group";
+	case TreeKind::DEEP_NESTING: return "deep_nesting";
+	case TreeKind::HARDLINKS: return "hardlinks";
+	case TreeKind::NEAR_DUPLICATES: return "near_duplicates";
+	}
+	return "unknown";
+}
+
+std::vector<TreeKind> TreeGenerator::kinds()
+{
+	return { TreeKind::SMALL_FILES, TreeKind::HUGE_FILES, TreeKind::SAME_SIZE_GROUP,
+		TreeKind::DEEP_NESTING, TreeKind::HARDLINKS, TreeKind::NEAR_DUPLICATES };
+}
+
+void TreeGenerator::generate(TreeKind kind, const fs::path& root)
+{
+	// Зерно зависит только от вида дерева
+	std::mt19937_64 rng(0xBA7A'0000 + static_cast<uint64_t>(kind));
+	switch (kind) {
+	case TreeKind::SMALL_FILES: generateSmallFiles(rng, root); break;
+	case TreeKind::HUGE_FILES: generateHugeFiles(rng, root); break;
+	case TreeKind::SAME_SIZE_GROUP: generateSameSizeGroup(rng, root); break;
+	case TreeKind::DEEP_NESTING: generateDeepNesting(rng, root); break;
+	case TreeKind::HARDLINKS: generateHardlinks(rng, root); break;
+	case TreeKind::NEAR_DUPLICATES: generateNearDuplicates(rng, root); break;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+/**
+ * @file TreeGenerator.h
+ * @brief Заголовочный файл для класса TreeGenerator.
+ *
+ * Класс TreeGenerator создает детерминированные синтетические деревья файлов для бенчмарков.
+ */
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @enum TreeKind
+ * @brief Вид синтетического дерева.
+ */
+enum class TreeKind
+{
+	SMALL_FILES = 0, ///< Десятки тысяч мелких файлов разного размера, часть - копии.
+	HUGE_FILES, ///< Несколько больших файлов: копия, отличие в середине, уникальный.
+	SAME_SIZE_GROUP, ///< Тысячи файлов одного размера с общим префиксом.
+	DEEP_NESTING, ///< Глубокие цепочки вложенных директорий с одинаковыми файлами.
+	HARDLINKS, ///< Файлы с несколькими жесткими ссылками и копиями.
+	NEAR_DUPLICATES ///< Пары файлов, различающиеся только последним байтом.
+};
+
+/**
+ * @class TreeGenerator
+ * @brief Генератор синтетических деревьев файлов.
+ *
+ * Содержимое файлов получается из std::mt19937_64 с фиксированным зерном без распределений,
+ * поэтому деревья побайтно совпадают на всех платформах и между коммитами, и результаты
+ * бенчмарков сравнимы. Созданное дерево переиспользуется, пока не изменится kVersion.
+ */
+class TreeGenerator
+{
+public:
+	/// Версия генератора: при изменении деревьев создаются заново
+	static constexpr uint32_t kVersion = 1;
+
+	/**
+	 * @brief Конструктор класса TreeGenerator.
+	 * @param baseDir Директория, в которой создаются деревья.
+	 */
+	explicit TreeGenerator(fs::path baseDir);
+
+	/**
+	 * @brief Метод для получения корня дерева; дерево создается при первом обращении.
+	 * @param kind Вид дерева.
+	 * @return Путь к корню дерева.
+	 */
+	fs::path tree(TreeKind kind);
+
+	/**
+	 * @brief Метод для получения названия дерева.
+	 * @param kind Вид дерева.
+	 * @return Название дерева.
+	 */
+	static std::string_view name(TreeKind kind);
+
+	/**
+	 * @brief Метод для получения всех видов деревьев.
+	 * @return Виды деревьев.
+	 */
+	static std::vector<TreeKind> kinds();
+
+private:
+	/**
+	 * @brief Метод для создания дерева.
+	 * @param kind Вид дерева.
+	 * @param root Корень дерева.
+	 */
+	static void generate(TreeKind kind, const fs::path& root);
+
+	fs::path baseDir_; ///< Директория деревьев.
+};
\ No newline at end of file
@@ -0,0 +1,149 @@
+/**
+ * @file bayan_bench.cpp
+ * @brief Бенчмарки этапов поиска дубликатов на синтетических деревьях.
+ *
+ * Этапы измеряются по отдельности: обход директорий (Walk), обход с получением
+ * метаданных и группировкой по размеру (Collect), хэширование блоков каждым алгоритмом (Hash)
+ * и поблочное сравнение групп (Compare). Деревья создаются TreeGenerator в директории
+ * BAYAN_BENCH_DIR (по умолчанию bayan_bench во временной директории) и переиспользуются,
+ * поэтому замеры выполняются на прогретом кэше страниц.
+ */
+#include "TreeGenerator.h"
+#include "ArgumentParser.h"
+#include "FileCollector.h"
+#include "FileComparator.h"
+#include "HashCalculator.h"
+#include "ResultWriter.h"
+#include "ThreadPool.h"
+#include "UringReader.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <ostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace
+{
+	/// Буфер потока, отбрасывающий вывод
+	class NullBuffer : public std::streambuf
+	{
+	protected:
+		int overflow(int c) override { return c; }
+		std::streamsize xsputn(const char* /*s*/, std::streamsize n) override { return n; }
+	};
+
+	/// Генератор деревьев, общий для всех бенчмарков
+	TreeGenerator& generator()
+	{
+		static TreeGenerator instance([]() {
+			const char* dir = std::getenv("BAYAN_BENCH_DIR");
+			return dir ? fs::path(dir) : fs::temp_directory_path() / "bayan_bench";
+			}());
+		return instance;
+	}
+
+	/**
+	 * @brief Функция для получения параметров сканирования дерева, как при запуске программы.
+	 * @param kind Вид дерева.
+	 * @return Параметры сканирования.
+	 */
+	ArgumentParser::ParserData makeData(TreeKind kind)
+	{
+		ArgumentParser::ParserData data;
+		data.directories = { generator().tree(kind).string() };
+		data.level = 1000;
+		data.minFileSize = 1;
+		data.hashAlgorithm = HashAlgorithmFactory::create("xxh3");
+		data.blockSchedule = BlockSchedule(4096, 1 << 20);
+		return data;
+	}
+
+	/// Обход директорий без получения метаданных: маска не подходит ни к одному файлу
+	void BM_Walk(benchmark::State& state, TreeKind kind)
+	{
+		auto data = makeData(kind);
+		data.maskMatcher = MaskMatcher({ ".bayan-bench-none" });
+		ThreadPool pool(0);
+		for (auto _ : state) {
+			FileCollector collector(data, pool);
+			benchmark::DoNotOptimize(collector.index().fileCount());
+		}
+	}
+
+	/// Обход с fstatat, группировкой по размеру и схлопыванием жестких ссылок
+	void BM_Collect(benchmark::State& state, TreeKind kind)
+	{
+		auto data = makeData(kind);
+		ThreadPool pool(0);
+		size_t files = 0;
+		for (auto _ : state) {
+			FileCollector collector(data, pool);
+			files = collector.index().fileCount();
+		}
+		state.counters["files"] = static_cast<double>(files);
+		state.counters["files_per_second"] = benchmark::Counter(static_cast<double>(files) * static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+	}
+
+	/// Пропускная способность алгоритма хэширования на блоках размера state.range(0)
+	void BM_Hash(benchmark::State& state, std::string_view algorithmName)
+	{
+		auto algorithm = HashAlgorithmFactory::create(algorithmName);
+		std::mt19937_64 rng(0xBA7A);
+		std::vector<char> block(static_cast<size_t>(state.range(0)));
+		for (auto& byte : block)
+			byte = static_cast<char>(rng());
+		for (auto _ : state)
+			benchmark::DoNotOptimize(algorithm->calculateHash(block));
+		state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+	}
+
+	/// Поблочное сравнение групп, собранных заранее; результаты выводятся в пустой поток
+	void BM_Compare(benchmark::State& state, TreeKind kind, IoMode ioMode)
+	{
+		if (ioMode == IoMode::URING && !UringReader::available()) {
+			state.SkipWithError("io_uring is not available");
+			return;
+		}
+		auto data = makeData(kind);
+		data.ioMode = ioMode;
+		ThreadPool pool(0);
+		data.hashAlgorithm->setThreadPool(&pool);
+		FileCollector collector(data, pool);
+		uint64_t candidateBytes = 0;
+		for (const auto& group : collector.fileGroups())
+			candidateBytes += static_cast<uint64_t>(group.size) * group.files.size();
+		NullBuffer nullBuffer;
+		std::ostream nullStream(&nullBuffer);
+		for (auto _ : state) {
+			ResultWriter writer(nullStream, OutputFormat::NDJSON);
+			FileComparator comparator(collector.index(), collector.fileGroups(), data, pool, writer);
+			comparator.compareGroups();
+			comparator.reportAliases(collector.aliases());
+			writer.finish();
+		}
+		// Байты файлов-кандидатов, а не прочитанные: ранний отсев ускоряет этап при том же объеме
+		state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(candidateBytes));
+	}
+
+	/// Регистрация бенчмарков для всех деревьев, алгоритмов и способов чтения
+	[[maybe_unused]] const bool registered = []() {
+		for (auto kind : TreeGenerator::kinds()) {
+			std::string tree(TreeGenerator::name(kind));
+			benchmark::RegisterBenchmark(("Walk/" + tree).c_str(), BM_Walk, kind)->Unit(benchmark::kMillisecond)->UseRealTime();
+			benchmark::RegisterBenchmark(("Collect/" + tree).c_str(), BM_Collect, kind)->Unit(benchmark::kMillisecond)->UseRealTime();
+		}
+		for (auto algorithm : HashAlgorithmFactory::names())
+			benchmark::RegisterBenchmark(("Hash/" + std::string(algorithm)).c_str(), BM_Hash, algorithm)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20);
+		for (auto kind : TreeGenerator::kinds()) {
+			for (auto [ioMode, ioName] : { std::pair{ IoMode::STREAM, "stream" }, std::pair{ IoMode::MMAP, "mmap" }, std::pair{ IoMode::URING, "uring" } }) {
+				std::string name = "Compare/" + std::string(TreeGenerator::name(kind)) + "/" + ioName;
+				benchmark::RegisterBenchmark(name.c_str(), BM_Compare, kind, ioMode)->Unit(benchmark::kMillisecond)->UseRealTime();
+			}
+		}
+		return true;
+		}();
+}
+
+BENCHMARK_MAIN();
\ No newline at end of file
@@ -1,13 +1,100 @@
-#include "ArgumentParser.h"
-#include "FileCollector.h"
-#include "FileComparator.h"
-
-int main(int argc, char* argv[]) {
-	ArgumentParser parser(argc, argv);
-	if (auto res = parser.parse(); res != ArgumentParser::PARSE_RES_CODE::OK)
-		return static_cast<int>(res);
-	FileCollector fileCollector(parser.data());
-	FileComparator comparator(fileCollector.fileGroups(), parser.data());
-	comparator.compareGroups();
-	return 0;
+#include "ActionEngine.h"
+#include "ArgumentParser.h"
+#include "DuplicateIndex.h"
+#include "FileCollector.h"
+#include "FileComparator.h"
+#include "ThreadPool.h"
+#include "HashCache.h"
+#include "IndexSnapshot.h"
+#include "ResultWriter.h"
+#include "SnapshotMerger.h"
+#include "Stats.h"
+#include "WatchServer.h"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+	ArgumentParser parser(argc, argv);
+	if (auto res = parser.parse(); res != ArgumentParser::PARSE_RES_CODE::OK)
+		return static_cast<int>(res);
+	if (parser.data().help)
+		return 0;
+	if (parser.data().hashBenchmark) {
+		HashAlgorithmFactory::benchmark(std::cout, parser.data().blockSchedule.maxBlockSize());
+		return 0;
+	}
+	if (parser.data().stats || !parser.data().statsFile.empty())
+		Stats::enable();
+	// Наблюдение начинается до создания потоков и сканирования, чтобы не пропустить изменения
+	std::unique_ptr<WatchServer> watchServer;
+	if (!parser.data().watchSocket.empty()) {
+		try {
+			watchServer = std::make_unique<WatchServer>(parser.data());
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Error: " << e.what() << std::endl;
+			return 1;
+		}
+	}
+	{
+		StatTimer timer(StatCounter::TOTAL_NANOS);
+		ThreadPool pool(parser.data().jobs);
+		parser.data().hashAlgorithm->setThreadPool(&pool);
+		if (!parser.data().mergeSnapshots.empty()) {
+			std::unique_ptr<SnapshotMerger> merger;
+			try {
+				merger = std::make_unique<SnapshotMerger>(parser.data(), pool);
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Error: " << e.what() << std::endl;
+				return 1;
+			}
+			ResultWriter writer(std::cout, parser.data().outputFormat);
+			FileComparator comparator(merger->index(), merger->fileGroups(), parser.data(), pool, writer, &merger->cache());
+			comparator.setShards(merger->shards());
+			comparator.compareGroups();
+			writer.finish();
+		}
+		else {
+			FileCollector fileCollector(parser.data(), pool);
+			std::unique_ptr<HashCache> cache;
+			if (!parser.data().cacheFile.empty())
+				cache = std::make_unique<HashCache>(parser.data().cacheFile, *parser.data().hashAlgorithm, parser.data().blockSchedule);
+			ResultWriter writer(std::cout, parser.data().outputFormat);
+			ActionEngine actions(parser.data().action, parser.data().dryRun, pool, writer);
+			std::vector<IGroupSink*> sinks{ &actions };
+			std::unique_ptr<DuplicateIndex> index;
+			if (watchServer) {
+				index = std::make_unique<DuplicateIndex>(parser.data(), pool, cache.get());
+				index->seed(fileCollector.index());
+				sinks.push_back(index.get());
+			}
+			FileComparator comparator(fileCollector.index(), fileCollector.fileGroups(), parser.data(), pool, writer, cache.get(), sinks);
+			comparator.compareGroups();
+			comparator.reportAliases(fileCollector.aliases());
+			actions.run();
+			writer.finish();
+			if (!parser.data().exportIndex.empty()) {
+				// Снимок хэшируется отдельно от сравнения и без --cache-file не меняет способ сравнения
+				std::unique_ptr<HashCache> exportCache;
+				HashCache* hashes = cache.get();
+				if (!hashes) {
+					exportCache = std::make_unique<HashCache>("", *parser.data().hashAlgorithm, parser.data().blockSchedule);
+					hashes = exportCache.get();
+				}
+				IndexSnapshot::hashFiles(fileCollector.index(), fileCollector.files(), *hashes, parser.data(), pool);
+				if (!IndexSnapshot::write(parser.data().exportIndex, fileCollector.index(), fileCollector.files(),
+					hashes, *parser.data().hashAlgorithm, parser.data().blockSchedule))
+					std::cerr << "Error: Failed to write index snapshot " << parser.data().exportIndex << std::endl;
+			}
+			if (watchServer)
+				watchServer->run(*index);
+		}
+	}
+	if (parser.data().stats)
+		Stats::printSummary(std::cerr, parser.data().hashAlgorithm->name());
+	if (!parser.data().statsFile.empty() && !Stats::writePrometheus(parser.data().statsFile, parser.data().hashAlgorithm->name()))
+		std::cerr << "Error: Failed to write stats file " << parser.data().statsFile << std::endl;
+	return 0;
 }
\ No newline at end of file